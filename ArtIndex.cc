@@ -0,0 +1,457 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/19/2026
+ */
+
+#include "ArtIndex.h"
+#include "BTreeIndex.h"
+#include <cstring>
+#include <climits>
+#include <algorithm>
+
+using namespace std;
+
+map<string, ArtIndex> ArtIndex::indexes;
+
+/*
+ * Node layouts. Node4 and Node16 keep their key bytes sorted; Node48 maps
+ * a byte to a slot of children (slot+1, 0 for none); Node256 has a child
+ * for every byte. first is the smallest position in the subtree.
+ */
+enum { NODE4, NODE16, NODE48, NODE256 };
+
+struct ArtIndex::Node {
+  unsigned char type;
+  unsigned char prefixLen;
+  unsigned char prefix[4];
+  short         count;
+  int           first;
+};
+
+struct Node4 : ArtIndex::Node   { unsigned char keys[4];   uintptr_t children[4]; };
+struct Node16 : ArtIndex::Node  { unsigned char keys[16];  uintptr_t children[16]; };
+struct Node48 : ArtIndex::Node  { unsigned char slot[256]; uintptr_t children[48]; };
+struct Node256 : ArtIndex::Node { uintptr_t children[256]; };
+
+// byte depth (0-3) of key, in key order
+static unsigned char keyByte(int key, int depth)
+{
+	return (((unsigned)key ^ 0x80000000u) >> (24 - 8*depth)) & 0xff;
+}
+
+static bool isLeaf(uintptr_t child) { return child & 1; }
+static int leafPosition(uintptr_t child) { return child >> 1; }
+static uintptr_t makeLeaf(int pos) { return ((uintptr_t)pos << 1) | 1; }
+
+template<class T> static T* newNode(int type, long& bytes)
+{
+	T* node = new T();
+	node->type = type;
+	bytes += sizeof(T);
+	return node;
+}
+
+// the child of node for byte, NULL if none
+static uintptr_t* findChild(ArtIndex::Node* node, unsigned char byte)
+{
+	switch(node->type)
+	{
+		case NODE4:
+		{
+			Node4* n = (Node4*)node;
+			for(int i=0; i<n->count; i++) if(n->keys[i]==byte) return &n->children[i];
+			return NULL;
+		}
+		case NODE16:
+		{
+			Node16* n = (Node16*)node;
+			unsigned char* k = lower_bound(n->keys, n->keys + n->count, byte);
+			return (k < n->keys + n->count && *k==byte) ? &n->children[k - n->keys] : NULL;
+		}
+		case NODE48:
+		{
+			Node48* n = (Node48*)node;
+			return n->slot[byte] ? &n->children[n->slot[byte]-1] : NULL;
+		}
+		default:
+		{
+			Node256* n = (Node256*)node;
+			return n->children[byte] ? &n->children[byte] : NULL;
+		}
+	}
+}
+
+// the child of node with the smallest byte above byte, 0 if none
+static uintptr_t nextChild(ArtIndex::Node* node, unsigned char byte)
+{
+	switch(node->type)
+	{
+		case NODE4:
+		{
+			Node4* n = (Node4*)node;
+			for(int i=0; i<n->count; i++) if(n->keys[i] > byte) return n->children[i];
+			return 0;
+		}
+		case NODE16:
+		{
+			Node16* n = (Node16*)node;
+			unsigned char* k = upper_bound(n->keys, n->keys + n->count, byte);
+			return k < n->keys + n->count ? n->children[k - n->keys] : 0;
+		}
+		case NODE48:
+		{
+			Node48* n = (Node48*)node;
+			for(int b=byte+1; b<256; b++) if(n->slot[b]) return n->children[n->slot[b]-1];
+			return 0;
+		}
+		default:
+		{
+			Node256* n = (Node256*)node;
+			for(int b=byte+1; b<256; b++) if(n->children[b]) return n->children[b];
+			return 0;
+		}
+	}
+}
+
+// insert (byte, child) into the sorted keys and children of a Node4 or Node16 with room
+template<class T> static void insertSorted(T* n, unsigned char byte, uintptr_t child)
+{
+	int i = n->count;
+	for(; i>0 && n->keys[i-1] > byte; i--)
+	{
+		n->keys[i] = n->keys[i-1];
+		n->children[i] = n->children[i-1];
+	}
+	n->keys[i] = byte;
+	n->children[i] = child;
+	n->count++;
+}
+
+// copy the header (type aside) of a node that is replaced by a bigger one
+static void copyHeader(ArtIndex::Node* to, const ArtIndex::Node* from)
+{
+	to->prefixLen = from->prefixLen;
+	memcpy(to->prefix, from->prefix, sizeof(from->prefix));
+	to->count = from->count;
+	to->first = from->first;
+}
+
+// orders the entries by key; stable_sort keeps records with the same key in table order
+struct ArtEntryOrder {
+	template <class T> bool operator()(const T& a, const T& b) const { return a.key < b.key; }
+};
+
+ArtIndex::ArtIndex()
+{
+	valid = false;
+	hasIndex = false;
+	covering = false;
+	root = 0;
+	nodeBytes = 0;
+	charged = 0;
+	memset(&tableStat, 0, sizeof(tableStat));
+	memset(&indexStat, 0, sizeof(indexStat));
+}
+
+ArtIndex::~ArtIndex()
+{
+	clear();
+}
+
+void ArtIndex::clear()
+{
+	destroy(root);
+	root = 0;
+	nodeBytes = 0;
+	vector<Entry>().swap(entries);
+	valid = false;
+}
+
+void ArtIndex::destroy(Child ref)
+{
+	if(ref==0 || isLeaf(ref)) return;
+	Node* node = (Node*)ref;
+	switch(node->type)
+	{
+		case NODE4:   for(int i=0; i<node->count; i++) destroy(((Node4*)node)->children[i]); delete (Node4*)node; break;
+		case NODE16:  for(int i=0; i<node->count; i++) destroy(((Node16*)node)->children[i]); delete (Node16*)node; break;
+		case NODE48:  for(int i=0; i<node->count; i++) destroy(((Node48*)node)->children[i]); delete (Node48*)node; break;
+		case NODE256: for(int i=0; i<256; i++) destroy(((Node256*)node)->children[i]); delete (Node256*)node; break;
+	}
+}
+
+RC ArtIndex::open(const string& table, const RecordFile& rf, long budget, ArtIndex*& index)
+{
+	RC rc;
+	ArtIndex& art = indexes[table];
+	struct stat tableStat, indexStat;
+
+	if(::stat((table + ".tbl").c_str(), &tableStat)!=0) return RC_FILE_OPEN_FAILED;
+	bool hasIndex = ::stat((table + ".idx").c_str(), &indexStat)==0;
+
+	// still good if neither file changed since it was built
+	bool sameFiles = PageFile::sameFileVersion(art.tableStat, tableStat) && art.hasIndex==hasIndex &&
+	                 (!hasIndex || PageFile::sameFileVersion(art.indexStat, indexStat));
+	if(art.valid && sameFiles)
+	{
+		index = &art;
+		return 0;
+	}
+	if(!sameFiles)
+	{
+		// the tree and the pages charged were for other versions of the files
+		art.clear();
+		art.charged = 0;
+		art.hasIndex = hasIndex;
+		art.tableStat = tableStat;
+		art.indexStat = indexStat;
+	}
+
+	// one entry per record
+	long records = (long)rf.endRid().pid*RecordFile::RECORDS_PER_PAGE + rf.endRid().sid;
+	if(records*ESTIMATED_ENTRY_BYTES > budget) return RC_NODE_FULL;
+
+	// building reads the whole file: wait until the queries that could
+	// have used the index instead read as many pages
+	long buildPages = hasIndex ? (long)(indexStat.st_size/PageFile::PAGE_SIZE) : rf.endRid().pid + 1;
+	if(art.charged < buildPages) return RC_NO_SUCH_RECORD;
+
+	// the pages read by a failed build paid for nothing
+	if((rc = art.build(table, hasIndex))!=0)
+	{
+		art.clear();
+		art.charged = 0;
+		return rc;
+	}
+	if(art.getMemoryUsage() > budget)
+	{
+		art.clear();
+		art.charged = 0;
+		return RC_NODE_FULL;
+	}
+	art.valid = true;
+	index = &art;
+	return 0;
+}
+
+void ArtIndex::charge(const string& table, int pages)
+{
+	map<string, ArtIndex>::iterator it = indexes.find(table);
+	if(it!=indexes.end()) it->second.charged += pages;
+}
+
+RC ArtIndex::build(const string& table, bool hasIndex)
+{
+	RC rc;
+	Entry entry;
+	string value;
+
+	covering = false;
+	if(hasIndex)
+	{
+		// the leaves of the B+tree, already in key order
+		BTreeIndex tree;
+		IndexCursor cursor;
+		if((rc = tree.open(table + ".idx", 'r'))!=0) return rc;
+		covering = tree.includesValue();
+		tree.locate(INT_MIN, cursor);
+		while(tree.readForward(cursor, entry.key, entry.rid)==0) entries.push_back(entry);
+		tree.close();
+	}
+	else
+	{
+		RecordFile rf;
+		if((rc = rf.open(table + ".tbl", 'r'))!=0) return rc;
+		for(entry.rid.pid = entry.rid.sid = 0; entry.rid < rf.endRid(); ++entry.rid)
+		{
+			if((rc = rf.read(entry.rid, entry.key, value))!=0)
+			{
+				rf.close();
+				return rc;
+			}
+			entries.push_back(entry);
+		}
+		rf.close();
+
+		stable_sort(entries.begin(), entries.end(), ArtEntryOrder());
+	}
+
+	// a leaf for the first entry of each key
+	for(int pos=0; pos<(int)entries.size(); pos++)
+		if(pos==0 || entries[pos].key!=entries[pos-1].key) insert(root, entries[pos].key, pos, 0);
+	return 0;
+}
+
+void ArtIndex::insert(Child& ref, int key, int pos, int depth)
+{
+	if(ref==0)
+	{
+		ref = makeLeaf(pos);
+		return;
+	}
+
+	// a leaf: replace it by a node over the two keys, with the bytes they
+	// share as its prefix
+	if(isLeaf(ref))
+	{
+		int other = entries[leafPosition(ref)].key;
+		if(other==key) return;
+		Node4* node = newNode<Node4>(NODE4, nodeBytes);
+		int d = depth;
+		for(; keyByte(other, d)==keyByte(key, d); d++) node->prefix[d - depth] = keyByte(key, d);
+		node->prefixLen = d - depth;
+		node->first = min(leafPosition(ref), pos);
+		insertSorted(node, keyByte(other, d), ref);
+		insertSorted(node, keyByte(key, d), makeLeaf(pos));
+		ref = (Child)node;
+		return;
+	}
+
+	// the key leaves the prefix of the node: split the prefix
+	Node* node = (Node*)ref;
+	int p = 0;
+	while(p < node->prefixLen && node->prefix[p]==keyByte(key, depth+p)) p++;
+	if(p < node->prefixLen)
+	{
+		Node4* parent = newNode<Node4>(NODE4, nodeBytes);
+		parent->prefixLen = p;
+		memcpy(parent->prefix, node->prefix, p);
+		parent->first = min(node->first, pos);
+		unsigned char byte = node->prefix[p];
+		node->prefixLen -= p+1;
+		memmove(node->prefix, node->prefix+p+1, node->prefixLen);
+		insertSorted(parent, byte, ref);
+		insertSorted(parent, keyByte(key, depth+p), makeLeaf(pos));
+		ref = (Child)parent;
+		return;
+	}
+
+	depth += node->prefixLen;
+	node->first = min(node->first, pos);
+	Child* child = findChild(node, keyByte(key, depth));
+	if(child!=NULL) insert(*child, key, pos, depth+1);
+	else addChild(ref, keyByte(key, depth), makeLeaf(pos));
+}
+
+void ArtIndex::addChild(Child& ref, unsigned char byte, Child child)
+{
+	Node* node = (Node*)ref;
+	switch(node->type)
+	{
+		case NODE4:
+		{
+			Node4* n = (Node4*)node;
+			if(n->count < 4) { insertSorted(n, byte, child); return; }
+			Node16* bigger = newNode<Node16>(NODE16, nodeBytes);
+			copyHeader(bigger, n);
+			memcpy(bigger->keys, n->keys, sizeof(n->keys));
+			memcpy(bigger->children, n->children, sizeof(n->children));
+			insertSorted(bigger, byte, child);
+			delete n;
+			nodeBytes -= sizeof(Node4);
+			ref = (Child)bigger;
+			return;
+		}
+		case NODE16:
+		{
+			Node16* n = (Node16*)node;
+			if(n->count < 16) { insertSorted(n, byte, child); return; }
+			Node48* bigger = newNode<Node48>(NODE48, nodeBytes);
+			copyHeader(bigger, n);
+			for(int i=0; i<16; i++)
+			{
+				bigger->slot[n->keys[i]] = i+1;
+				bigger->children[i] = n->children[i];
+			}
+			delete n;
+			nodeBytes -= sizeof(Node16);
+			ref = (Child)bigger;
+			addChild(ref, byte, child);
+			return;
+		}
+		case NODE48:
+		{
+			Node48* n = (Node48*)node;
+			if(n->count < 48)
+			{
+				n->children[n->count] = child;
+				n->slot[byte] = ++n->count;
+				return;
+			}
+			Node256* bigger = newNode<Node256>(NODE256, nodeBytes);
+			copyHeader(bigger, n);
+			for(int b=0; b<256; b++) if(n->slot[b]) bigger->children[b] = n->children[n->slot[b]-1];
+			delete n;
+			nodeBytes -= sizeof(Node48);
+			ref = (Child)bigger;
+			addChild(ref, byte, child);
+			return;
+		}
+		default:
+		{
+			Node256* n = (Node256*)node;
+			n->children[byte] = child;
+			n->count++;
+			return;
+		}
+	}
+}
+
+/*
+ * The position of the first entry with a key >= key in the subtree ref
+ * (whose keys all have the bytes of key before depth), -1 if all its keys
+ * are smaller.
+ */
+int ArtIndex::lowerBound(Child ref, int key, int depth) const
+{
+	if(ref==0) return -1;
+	if(isLeaf(ref)) return entries[leafPosition(ref)].key >= key ? leafPosition(ref) : -1;
+
+	Node* node = (Node*)ref;
+	for(int p=0; p<node->prefixLen; p++)
+	{
+		unsigned char byte = keyByte(key, depth+p);
+		if(node->prefix[p] > byte) return node->first;
+		if(node->prefix[p] < byte) return -1;
+	}
+	depth += node->prefixLen;
+
+	unsigned char byte = keyByte(key, depth);
+	Child* child = findChild(node, byte);
+	if(child!=NULL)
+	{
+		int pos = lowerBound(*child, key, depth+1);
+		if(pos!=-1) return pos;
+	}
+	Child next = nextChild(node, byte);
+	if(next==0) return -1;
+	return isLeaf(next) ? leafPosition(next) : ((Node*)next)->first;
+}
+
+RC ArtIndex::locate(int searchKey, int& cursor) const
+{
+	cursor = lowerBound(root, searchKey, 0);
+	if(cursor==-1) cursor = entries.size();
+	return (cursor < (int)entries.size() && entries[cursor].key==searchKey) ? 0 : RC_NO_SUCH_RECORD;
+}
+
+RC ArtIndex::readForward(int& cursor, int& key, RecordId& rid) const
+{
+	if(cursor < 0 || cursor >= (int)entries.size()) return RC_END_OF_TREE;
+	key = entries[cursor].key;
+	rid = entries[cursor].rid;
+	cursor++;
+	return 0;
+}
+
+int ArtIndex::countRange(int lo, int hi) const
+{
+	int first, last;
+	if(lo > hi) return 0;
+	locate(lo, first);
+	if(hi==INT_MAX) last = entries.size();
+	else locate(hi+1, last);
+	return last - first;
+}
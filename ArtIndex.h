@@ -0,0 +1,142 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/19/2026
+ */
+
+#ifndef ARTINDEX_H
+#define ARTINDEX_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <sys/stat.h>
+#include "Bruinbase.h"
+#include "RecordFile.h"
+
+/**
+ * Implements an in-memory index over the key column of a table: an
+ * adaptive radix tree (ART) over the 4 bytes of the key, most significant
+ * first (with the sign bit flipped, so byte order is key order). Inner
+ * nodes have room for 4, 16, 48 or 256 children and grow as children are
+ * added; a chain of bytes shared by all keys below a node is kept in the
+ * node as its prefix. The leaves are positions in an array of the
+ * (key, RecordId) entries sorted by key, so a range is read by walking
+ * the array from the position of its first key.
+ *
+ * The tree is built from the leaves of the table's .idx, or from the .tbl
+ * if the table has no key index, and kept for the process: the files
+ * remain the durable copy, and the tree is dropped when either of them
+ * changes. Building it reads every page of that file, so it is only built
+ * once the queries that could have used it have read as many pages
+ * without it (see charge()). Lookups read no pages at all.
+ */
+class ArtIndex {
+ public:
+  // estimated bytes per entry, to check the memory budget before building
+  static const int ESTIMATED_ENTRY_BYTES = 24;
+
+  ArtIndex();
+  ~ArtIndex();
+
+  /**
+   * Get the in-memory index of table, building it if it is not built yet
+   * (or the table changed since) and the pages charged for it pay for
+   * building it.
+   * @param table[IN] the name of the table
+   * @param rf[IN] the table file, open for reading
+   * @param budget[IN] the most bytes of memory the index may take
+   * @param index[OUT] the index
+   * @return error code. RC_NODE_FULL if the index would not fit in budget,
+   *         RC_NO_SUCH_RECORD if it is not worth building yet
+   */
+  static RC open(const std::string& table, const RecordFile& rf, long budget, ArtIndex*& index);
+
+  /**
+   * Charge the pages read by a query that open() could not serve because
+   * the index was not worth building yet. Once the charged pages add up to
+   * the pages building the index reads, open() builds it.
+   * @param table[IN] the name of the table
+   * @param pages[IN] the pages the query read
+   */
+  static void charge(const std::string& table, int pages);
+
+  /**
+   * Find the first entry whose key is larger than or equal to searchKey.
+   * @param searchKey[IN] the key to find
+   * @param cursor[OUT] the position of the entry
+   * @return 0 if searchKey is found. Otherwise RC_NO_SUCH_RECORD
+   */
+  RC locate(int searchKey, int& cursor) const;
+
+  /**
+   * Read the (key, rid) pair at the cursor and move the cursor forward.
+   * @param cursor[IN/OUT] the position of an entry
+   * @param key[OUT] the key of the entry
+   * @param rid[OUT] the RecordId of the entry
+   * @return error code. RC_END_OF_TREE if there are no more entries
+   */
+  RC readForward(int& cursor, int& key, RecordId& rid) const;
+
+  /**
+   * @return the # of entries with lo <= key <= hi
+   */
+  int countRange(int lo, int hi) const;
+
+  /**
+   * @return whether the index was built from a covering .idx (one that
+   *         also stores the value, see BTreeIndex::includeValue())
+   */
+  bool coversValue() const { return covering; }
+
+  /**
+   * @return the bytes the index takes in memory
+   */
+  long getMemoryUsage() const { return nodeBytes + entries.capacity()*sizeof(Entry); }
+
+  struct Node; // the header of the inner nodes, defined in ArtIndex.cc
+
+ private:
+  struct Entry {
+    int      key;
+    RecordId rid;
+  };
+
+  // a child pointer: 0 for none, (position << 1 | 1) for a leaf, and the
+  // address of the Node otherwise
+  typedef uintptr_t Child;
+
+  ArtIndex(const ArtIndex&);            // not copied: it owns its nodes
+  ArtIndex& operator=(const ArtIndex&);
+
+  /**
+   * Read the entries of table and build the tree over them.
+   */
+  RC build(const std::string& table, bool hasIndex);
+
+  /**
+   * Drop the tree and the entries.
+   */
+  void clear();
+
+  void insert(Child& ref, int key, int pos, int depth);
+  void addChild(Child& ref, unsigned char byte, Child child);
+  int  lowerBound(Child ref, int key, int depth) const;
+  void destroy(Child ref);
+
+  static std::map<std::string, ArtIndex> indexes;
+
+  bool        valid;        /// false until the index has been built
+  bool        hasIndex;     /// whether it is built from the .idx
+  struct stat tableStat;    /// the .tbl it is built from
+  struct stat indexStat;    /// the .idx it is built from (if hasIndex)
+  long        charged;      /// pages charged to these versions of the files
+  bool        covering;     /// whether the .idx holds the values
+  Child       root;
+  long        nodeBytes;    /// bytes taken by the inner nodes
+  std::vector<Entry> entries; /// all the entries, sorted by key
+};
+
+#endif /* ARTINDEX_H */
@@ -14,9 +14,51 @@
 #include <cstring>
 #include <stdlib.h>
 #include <math.h>
+#include <algorithm>
+#include <climits>
 
 using namespace std;
 
+map<string, BTreeIndex::NodeCache> BTreeIndex::nodeCaches;
+
+/*
+ * The child of a decoded nonleaf node to follow for searchKey:
+ * the number of keys <= searchKey, as in BTNonLeafNode::locateChildIndex().
+ */
+static int childIndex(const vector<int>& keys, int searchKey)
+{
+    return upper_bound(keys.begin(), keys.end(), searchKey) - keys.begin();
+}
+
+/*
+ * The left-most child of a decoded nonleaf node that can hold searchKey:
+ * the number of keys < searchKey. Entries with a key equal to a separating
+ * key may be on both sides of it (a leaf split between duplicates), so
+ * searches start left of it.
+ */
+static int firstChildIndex(const vector<int>& keys, int searchKey)
+{
+    return lower_bound(keys.begin(), keys.end(), searchKey) - keys.begin();
+}
+
+/*
+ * Whether a leaf entry stands for the rids of a posting list.
+ */
+static bool isPosting(const RecordId& rid)
+{
+    return rid.sid == BTPostingNode::POSTING_SID;
+}
+
+/*
+ * Whether the leaf entry (key, rid) is the last one returned through cursor
+ * (or holds the posting list the last rid came from).
+ */
+static bool isLastEntry(const IndexCursor& cursor, int key, const RecordId& rid)
+{
+    if(key != cursor.lastKey) return false;
+    return rid == cursor.lastRid || (isPosting(rid) && rid.pid == cursor.postingHead);
+}
+
 /*
  * BTreeIndex constructor
  */
@@ -24,9 +66,23 @@ BTreeIndex::BTreeIndex()
 {
     rootPid = -1;
     treeHeight = 0; // initialize height of the B+ Tree to 0.
+    valueSize = 0; // plain (key, rid) entries unless includeValue() is called
+    compressed = false; // plain leaves unless compressLeaves() is called
+    mode = 'r';
+    cache = NULL;
+    rightLowKey = INT_MIN;
+    bulk.leaf = NULL;
     fill(buffer, buffer + PageFile::PAGE_SIZE, 0); //set buffer entries to zero.
 }
 
+/*
+ * BTreeIndex destructor
+ */
+BTreeIndex::~BTreeIndex()
+{
+    delete bulk.leaf; // left over by a bulk load that did not finish
+}
+
 /*
  * Open the index file in read or write mode.
  * Under 'w' mode, the index file should be created if it does not exist.
@@ -42,6 +98,25 @@ RC BTreeIndex::open(const string& indexname, char mode)
     error = pf.open(indexname, mode);
     if(error==0) {/*cout<<"OK so far... \n"*/;}
     else return error;
+
+    this->mode = mode;
+    this->indexname = indexname;
+    rightPath.clear();
+    cache = &nodeCaches[indexname];
+
+    // the cached header and nodes are still good if the file did not change
+    // since they were read (stat first: a later change only makes us re-read)
+    struct stat statbuf;
+    if(::stat(indexname.c_str(), &statbuf)==0 && cache->valid && PageFile::sameFileVersion(cache->fileStat, statbuf))
+    {
+        rootPid = cache->rootPid;
+        treeHeight = cache->treeHeight;
+        valueSize = cache->valueSize;
+        compressed = cache->compressed;
+        return 0;
+    }
+    cache->valid = false;
+    cache->nodes.clear();
     
     error = pf.read(0,buffer);
     if(error==0) {/*cout<<"OK so far.... \n"*/;}
@@ -55,6 +130,20 @@ RC BTreeIndex::open(const string& indexname, char mode)
     memcpy(&bufferTreeHeight, buffer+sizeof(PageId), sizeof(int));
     if(bufferTreeHeight>=1) treeHeight = bufferTreeHeight;
 
+    int bufferValueSize;
+    memcpy(&bufferValueSize, buffer+sizeof(PageId)+sizeof(int), sizeof(int));
+    if(bufferValueSize>0) valueSize = bufferValueSize;
+
+    int bufferCompressed;
+    memcpy(&bufferCompressed, buffer+sizeof(PageId)+2*sizeof(int), sizeof(int));
+    if(bufferCompressed>0) compressed = true;
+
+    cache->fileStat = statbuf;
+    cache->rootPid = rootPid;
+    cache->treeHeight = treeHeight;
+    cache->valueSize = valueSize;
+    cache->compressed = compressed;
+    cache->valid = true;
     return 0;
 }
 
@@ -69,20 +158,89 @@ RC BTreeIndex::close()
 	// As mentioned in the project description, these variables need to be saved or else
 	// they get deleted from memory
 
-	// copy to memory
-    memcpy(buffer, &rootPid, sizeof(PageId));
-	memcpy(buffer+sizeof(PageId), &treeHeight, sizeof(int));
-	
-	// write to disk
 	RC error;
-	error = pf.write(0, buffer);
+	error = writeHeader();
 	if(error==0) {/*cout<<"OK so far.... \n"*/;}
 	else return error;
 
 	// close file now
 	error = pf.close();
 	if(error!=0) return error;
-    else return 0;
+
+	// the cache followed every write: it describes the file as it is now
+	struct stat statbuf;
+	if((mode=='w' || mode=='W') && ::stat(indexname.c_str(), &statbuf)==0)
+	{
+		cache->fileStat = statbuf;
+		cache->valid = true;
+	}
+	return 0;
+}
+
+/*
+ * Write rootPid, treeHeight, valueSize and whether the leaves are compressed to page 0.
+ * @return error code. 0 if no error
+ */
+RC BTreeIndex::writeHeader()
+{
+	// copy to memory
+	memcpy(buffer, &rootPid, sizeof(PageId));
+	memcpy(buffer+sizeof(PageId), &treeHeight, sizeof(int));
+	memcpy(buffer+sizeof(PageId)+sizeof(int), &valueSize, sizeof(int));
+	int compressedFlag = compressed ? 1 : 0;
+	memcpy(buffer+sizeof(PageId)+2*sizeof(int), &compressedFlag, sizeof(int));
+
+	cache->rootPid = rootPid;
+	cache->treeHeight = treeHeight;
+	cache->valueSize = valueSize;
+	cache->compressed = compressed;
+
+	// write to disk
+	return pf.write(0, buffer);
+}
+
+/*
+ * Return the decoded nonleaf node at pid, reading it if it is not cached.
+ * @param pid[IN] the PageId of the nonleaf node
+ * @param node[OUT] the decoded node (valid until the next cache update)
+ * @return error code. 0 if no error
+ */
+RC BTreeIndex::readNonLeaf(PageId pid, const CachedNode*& node)
+{
+	if(pid < (int)cache->nodes.size() && !cache->nodes[pid].children.empty())
+	{
+		node = &cache->nodes[pid];
+		return 0;
+	}
+
+	BTNonLeafNode nonLeafNode;
+	RC error = nonLeafNode.read(pid, pf);
+	if(error!=0) return error;
+	cacheNonLeaf(pid, nonLeafNode);
+	node = &cache->nodes[pid];
+	return 0;
+}
+
+/*
+ * Store the decoded content of the nonleaf node at pid.
+ * @param pid[IN] the PageId of the nonleaf node
+ * @param nonLeafNode[IN] the node as written to (or read from) disk
+ */
+void BTreeIndex::cacheNonLeaf(PageId pid, BTNonLeafNode& nonLeafNode)
+{
+	if(pid >= (int)cache->nodes.size()) cache->nodes.resize(pid+1);
+	CachedNode& node = cache->nodes[pid];
+
+	int keyCount = nonLeafNode.getKeyCount();
+	node.keys.resize(keyCount);
+	node.children.resize(keyCount+1);
+	node.counts.resize(keyCount+1);
+	for(int j=0; j<=keyCount; j++)
+	{
+		if(j > 0) node.keys[j-1] = nonLeafNode.getKey(j);
+		node.children[j] = nonLeafNode.getChildPtr(j);
+		node.counts[j] = nonLeafNode.getChildCount(j);
+	}
 }
 
 /*
@@ -93,56 +251,114 @@ RC BTreeIndex::close()
  */
 RC BTreeIndex::insert(int key, const RecordId& rid)
 {
+    return insert(key, rid, "");
+}
+
+/*
+ * Insert (key, RecordId) pair to the index, keeping the value of the
+ * record in the leaf entry if this is a covering index.
+ * @param key[IN] the key for the value inserted into the index
+ * @param rid[IN] the RecordId for the record being inserted into the index
+ * @param value[IN] the value of the record
+ * @return error code. 0 if no error
+ */
+RC BTreeIndex::insert(int key, const RecordId& rid, const string& value)
+{
+    // a leaf slot holding key 0 is empty (see BTLeafNode::getKeyCount())
+    if(key==0) return RC_INVALID_ATTRIBUTE;
+
     // 2 cases: treeHeight = 0 and treeHeight!=0
 
     if(treeHeight==0)
     {
     	//cout<<"Tree Height is zero."<<endl;
     	RC error;
-    	BTLeafNode leafNode;
-    	leafNode.insert(key,rid);
+    	BTLeafNode leafNode(valueSize, compressed);
+    	leafNode.insert(key,rid,value);
     	treeHeight++;
 
     	if(pf.endPid()==0)  rootPid = 1;
 		else  rootPid = pf.endPid();
 
 		error = leafNode.write(rootPid, pf);
-		return error;
+		if(error!=0) return error;
+
+		// publish the new root to readers of the index
+		return writeHeader();
     }
     else
     {
     	//cout<<"Tree Height is not zero."<<endl;
     	RC error;
+
+    	// keys at the right end of the tree (e.g. a sorted load) skip the search
+    	if(!rightPath.empty() && key>=rightLowKey)
+    	{
+    		bool appended;
+    		error = appendRightmost(key, rid, value, appended);
+    		if(error!=0 || appended) return error;
+    	}
+
+    	// helper_insert records the right-most path again if it goes down it
+    	rightPath.clear();
+    	rightLowKey = INT_MIN;
+
     	PageId insertPid = -1;
     	int midKey = -1;
+    	int insertCount = 0;
     	int height = 1;
-    	error = helper_insert(key,rid,rootPid,height,midKey,insertPid);
+    	error = helper_insert(key,rid,value,rootPid,height,midKey,insertPid,insertCount,true);
+    	if(error!=0) return error;
+    	if((int)rightPath.size()!=treeHeight) rightPath.clear();
+
+    	// the root was split: grow the tree by one level
+    	if(insertPid!=-1)
+    	{
+    		int rootCount;
+    		error = subtreeCount(rootPid, 1, rootCount);
+    		if(error!=0) return error;
+
+    		BTNonLeafNode newRoot;
+    		newRoot.initializeRoot(rootPid, rootCount, midKey, insertPid, insertCount);
+    		treeHeight++;
+    		rootPid = pf.endPid();
+    		error = newRoot.write(rootPid, pf);
+    		if(error!=0) return error;
+    		cacheNonLeaf(rootPid, newRoot);
+
+    		// publish the new root to readers of the index
+    		error = writeHeader();
+    	}
     	return error;
     }
 }
-RC BTreeIndex::helper_insert(int key, const RecordId& rid, PageId pagePid, int height, int& midKey, PageId& insertPid)
+
+RC BTreeIndex::helper_insert(int key, const RecordId& rid, const string& value, PageId pagePid, int height, int& midKey, PageId& insertPid, int& insertCount, bool rightEdge)
 {
 	RC error;
 	
 	midKey = -1;
 	insertPid = -1;
+	insertCount = 0;
+	if(rightEdge) rightPath.push_back(pagePid);
 	
 	if(height==treeHeight)
 	{
 		//cout<<"Height==TreeHeight"<<endl;
-		BTLeafNode leafNode;
+		BTLeafNode leafNode(valueSize, compressed);
 		leafNode.read(pagePid, pf);
 
 		//Return if the leaf node gets inserted successfully
-		if(leafNode.insert(key, rid)==0)
-		{	
-			leafNode.write(pagePid, pf);
-			return 0;
-		}
+		bool inserted;
+		error = insertIntoLeaf(leafNode, pagePid, key, rid, value, inserted);
+		if(error!=0 || inserted) return error;
+
+		//The right-most leaf may be the new sibling now
+		rightPath.clear();
 
 		int otherKey;
-		BTLeafNode otherLeafNode;
-		error = leafNode.insertAndSplit(key, rid, otherLeafNode, otherKey);
+		BTLeafNode otherLeafNode(valueSize, compressed);
+		error = leafNode.insertAndSplit(key, rid, value, otherLeafNode, otherKey);
 		
 		if(error==0) {/*cout<<"OK so far... \n"*/;}
     	else return error;
@@ -150,11 +366,17 @@ RC BTreeIndex::helper_insert(int key, const RecordId& rid, PageId pagePid, int h
 		int lastPid = pf.endPid();
 		midKey = otherKey;
 		insertPid = lastPid;
+		error = entryCount(otherLeafNode, 0, otherLeafNode.getKeyCount(), insertCount);
+		if(error!=0) return error;
 
 		//Update leafNode and otherLeafNode
-		otherLeafNode.setNextNodePtr(leafNode.getNextNodePtr());
+		PageId nextPid = leafNode.getNextNodePtr();
+		otherLeafNode.setNextNodePtr(nextPid);
+		otherLeafNode.setPrevNodePtr(pagePid);
 		leafNode.setNextNodePtr(lastPid);
 
+		//Write the new sibling before any page points to it, so that a reader
+		//in another process always finds the moved entries by moving right
 		error = otherLeafNode.write(lastPid, pf);
 		
 		if(error==0) {/*cout<<"OK so far... \n"*/;}
@@ -164,17 +386,16 @@ RC BTreeIndex::helper_insert(int key, const RecordId& rid, PageId pagePid, int h
 		
 		if(error==0) {/*cout<<"OK so far... \n"*/;}
     	else return error;
-		
-		if(treeHeight==1)
+
+		//The old right neighbour now points back to the new sibling
+		if(nextPid > 0)
 		{
-			//Create a new Root if there was only one node in the beginning
-			BTNonLeafNode newRoot;
-			newRoot.initializeRoot(pagePid, otherKey, lastPid);
-			treeHeight++;
-			
-			//Update rootPid
-			rootPid = pf.endPid();
-			newRoot.write(rootPid, pf);
+			BTLeafNode nextLeafNode(valueSize, compressed);
+			error = nextLeafNode.read(nextPid, pf);
+			if(error!=0) return error;
+			nextLeafNode.setPrevNodePtr(lastPid);
+			error = nextLeafNode.write(nextPid, pf);
+			if(error!=0) return error;
 		}
 		
 		return 0;
@@ -184,56 +405,300 @@ RC BTreeIndex::helper_insert(int key, const RecordId& rid, PageId pagePid, int h
 		//cout<<"Height NOT=TreeHeight"<<endl;
 		//Locate the node where the new key should be inserted
 		BTNonLeafNode midNode;
-		midNode.read(pagePid, pf);
+		error = midNode.read(pagePid, pf);
+		if(error!=0) return error;
 		
-		PageId childPid = -1;
-		midNode.locateChildPtr(key, childPid);
+		int childIdx = midNode.locateChildIndex(key);
+		PageId childPid = midNode.getChildPtr(childIdx);
+		bool childRightEdge = rightEdge && childIdx==midNode.getKeyCount();
+		if(childRightEdge && childIdx>0) rightLowKey = midNode.getKey(childIdx);
 		
-		int insertKey = -1;
-		PageId insertPid = -1;
+		int childKey = -1;
+		PageId childInsertPid = -1;
+		int childInsertCount = 0;
 		
-		error = helper_insert(key, rid, childPid, height+1, insertKey, insertPid);
+		error = helper_insert(key, rid, value, childPid, height+1, childKey, childInsertPid, childInsertCount, childRightEdge);
+		if(error!=0) return error;
+
+		// the child gained one entry and lost whatever moved to its new sibling
+		midNode.setChildCount(childIdx, midNode.getChildCount(childIdx) + 1 - childInsertCount);
 		
-		//Error might occur if node was full
-		if(!(insertKey==-1 && insertPid==-1)) 
+		if(childInsertPid==-1 || midNode.insert(childKey, childInsertPid, childInsertCount, childIdx)==0)
+		{
+			cacheNonLeaf(pagePid, midNode);
+			return midNode.write(pagePid, pf);
+		}
+
+		//the node is full: split it and pass the middle key up
+		BTNonLeafNode anotherMidNode;
+		int otherKey;
+		
+		error = midNode.insertAndSplit(childKey, childInsertPid, childInsertCount, childIdx, anotherMidNode, otherKey, rightEdge);
+		if(error!=0) return error;
+		
+		int lastPid = pf.endPid();
+		midKey = otherKey;
+		insertPid = lastPid;
+		insertCount = anotherMidNode.getTotalCount();
+		
+		//Update anotherMidNode and midNode (the new sibling first, as for leaves)
+		error = anotherMidNode.write(lastPid, pf);
+		if(error==0) {/*cout<<"OK so far... \n"*/;}
+		else return error;
+
+		error = midNode.write(pagePid, pf);
+		if(error==0) {/*cout<<"OK so far... \n"*/;}
+    	else return error;
+
+		cacheNonLeaf(lastPid, anotherMidNode);
+		cacheNonLeaf(pagePid, midNode);
+
+		return 0;
+	}
+}
+
+/*
+ * Insert (key, rid) into the right-most leaf recorded in rightPath and add
+ * it to the count of the last child of every nonleaf node on the path.
+ * @param key[IN] the key to insert (not below rightLowKey)
+ * @param rid[IN] the RecordId to insert
+ * @param value[IN] the value to keep in the entry of a covering index
+ * @param appended[OUT] false if the leaf is full and nothing was written
+ * @return error code. 0 if no error
+ */
+RC BTreeIndex::appendRightmost(int key, const RecordId& rid, const string& value, bool& appended)
+{
+	RC error;
+	appended = false;
+
+	BTLeafNode leafNode(valueSize, compressed);
+	error = leafNode.read(rightPath.back(), pf);
+	if(error!=0) return error;
+	error = insertIntoLeaf(leafNode, rightPath.back(), key, rid, value, appended);
+	if(error!=0 || !appended) return error;
+
+	for(int i=(int)rightPath.size()-2; i>=0; i--)
+	{
+		BTNonLeafNode node;
+		error = node.read(rightPath[i], pf);
+		if(error!=0) return error;
+		int last = node.getKeyCount();
+		node.setChildCount(last, node.getChildCount(last) + 1);
+		error = node.write(rightPath[i], pf);
+		if(error!=0) return error;
+		cacheNonLeaf(rightPath[i], node);
+	}
+	return 0;
+}
+
+/*
+ * Insert (key, rid) into the leaf at pid and write it. Once the leaf holds
+ * POSTING_MIN_ENTRIES entries with key, they are replaced by a single entry
+ * that points to a posting list of their rids, and the next rids of key
+ * are appended to the list (the leaf is not written then).
+ * @param leafNode[IN/OUT] the leaf, as read from pid
+ * @param pid[IN] the PageId of the leaf
+ * @param key[IN] the key to insert
+ * @param rid[IN] the RecordId to insert
+ * @param value[IN] the value to keep in the entry of a covering index
+ * @param inserted[OUT] false if the leaf is full and nothing was written
+ * @return error code. 0 if no error
+ */
+RC BTreeIndex::insertIntoLeaf(BTLeafNode& leafNode, PageId pid, int key, const RecordId& rid, const string& value, bool& inserted)
+{
+	RC error;
+	inserted = true;
+
+	// the entries of a covering index carry their values: no posting lists
+	if(valueSize==0)
+	{
+		int eid, storedKey, dups = 0;
+		RecordId storedRid;
+		leafNode.locate(key, eid);
+		for(int i = eid; leafNode.readEntry(i, storedKey, storedRid)==0 && storedKey==key; i++)
+		{
+			if(isPosting(storedRid)) return appendPosting(storedRid.pid, rid);
+			dups++;
+		}
+
+		if(dups+1 >= POSTING_MIN_ENTRIES)
 		{
-			RC error2 = midNode.insert(insertKey, insertPid);
-			if(error2==0)
+			// the list goes to new pages at the end of the file
+			vector<RecordId> rids(1, rid);
+			vector<PageId> pages;
+			BTLeafNode converted = leafNode;
+			for(int i = 0; i < dups; i++)
 			{
-				midNode.write(pagePid, pf);
-				return 0;
+				converted.readEntry(eid, storedKey, storedRid);
+				rids.push_back(storedRid);
+				converted.remove(eid);
 			}
-			//else, try insertAndSplit again
-			BTNonLeafNode anotherMidNode;
-			int otherKey;
-			
-			midNode.insertAndSplit(insertKey, insertPid, anotherMidNode, otherKey);
-			
-			int lastPid = pf.endPid();
-			midKey = otherKey;
-			insertPid = lastPid;
-			
-			//Update midNode and anotherMidNode
-			error = midNode.write(pagePid, pf);
-			if(error==0) {/*cout<<"OK so far... \n"*/;}
-	    	else return error;
-			
-			error = anotherMidNode.write(lastPid, pf);
-			if(error==0) {/*cout<<"OK so far... \n"*/;}
-    		else return error;
-			
-			if(treeHeight==1)
+			RecordId head;
+			head.pid = pf.endPid();
+			head.sid = BTPostingNode::POSTING_SID;
+
+			// (a compressed leaf may have no room for the pid of the list)
+			if(converted.insert(key, head)==0)
 			{
-				BTNonLeafNode newRoot;
-				newRoot.initializeRoot(pagePid, otherKey, lastPid);
-				treeHeight++;		
-				rootPid = pf.endPid();
-				newRoot.write(rootPid, pf);
+				sort(rids.begin(), rids.end());
+				if((error = writePostingList(rids, pages))!=0) return error;
+				leafNode = converted;
+				return leafNode.write(pid, pf);
 			}
 		}
+	}
+
+	if(leafNode.insert(key, rid, value)!=0)
+	{
+		inserted = false;
 		return 0;
 	}
+	return leafNode.write(pid, pf);
+}
+
+/*
+ * Append rid to the posting list starting at head. A rid below the last one
+ * in the list (not from an append to the table) is inserted in order.
+ * @param head[IN] the first page of the posting list
+ * @param rid[IN] the RecordId to add
+ * @return error code. 0 if no error
+ */
+RC BTreeIndex::appendPosting(PageId head, const RecordId& rid)
+{
+	RC error;
+	BTPostingNode headNode, tailNode;
+	if((error = headNode.read(head, pf))!=0) return error;
+
+	PageId tail = headNode.getTailPtr();
+	BTPostingNode& lastNode = (tail==head) ? headNode : tailNode;
+	if(tail!=head && (error = tailNode.read(tail, pf))!=0) return error;
+
+	error = lastNode.append(rid);
+	if(error==RC_INVALID_RID)
+	{
+		vector<RecordId> rids;
+		vector<PageId> pages;
+		if((error = readPostingList(head, rids, pages))!=0) return error;
+		rids.insert(upper_bound(rids.begin(), rids.end(), rid), rid);
+		return writePostingList(rids, pages);
+	}
+	if(error==RC_NODE_FULL)
+	{
+		// start a new last page (written before any page points to it)
+		BTPostingNode newNode;
+		PageId newPid = pf.endPid();
+		newNode.append(rid);
+		newNode.setPrevNodePtr(tail);
+		if((error = newNode.write(newPid, pf))!=0) return error;
+		lastNode.setNextNodePtr(newPid);
+		headNode.setTailPtr(newPid);
+	}
+	else if(error!=0) return error;
+
+	if(tail!=head && (error = tailNode.write(tail, pf))!=0) return error;
+	headNode.setTotalCount(headNode.getTotalCount() + 1);
+	return headNode.write(head, pf);
+}
+
+/*
+ * Read all rids of the posting list starting at head.
+ * @param head[IN] the first page of the posting list
+ * @param rids[OUT] the rids of the list, sorted
+ * @param pages[OUT] the pages of the list, in order
+ * @return error code. 0 if no error
+ */
+RC BTreeIndex::readPostingList(PageId head, vector<RecordId>& rids, vector<PageId>& pages)
+{
+	RC error;
+	for(PageId pid = head; pid > 0; )
+	{
+		BTPostingNode postingNode;
+		if((error = postingNode.read(pid, pf))!=0) return error;
+		pages.push_back(pid);
+
+		int offset = BTPostingNode::HEADER_SIZE;
+		RecordId prev, rid;
+		prev.pid = prev.sid = 0;
+		while(postingNode.readEntry(offset, prev, rid)==0)
+		{
+			rids.push_back(rid);
+			prev = rid;
+		}
+		pid = postingNode.getNextNodePtr();
+	}
+	return 0;
+}
+
+/*
+ * Write the sorted rids as a posting list into pages, which are extended by
+ * new pages at the end of the file if they cannot hold all rids.
+ * @param rids[IN] the rids of the list, sorted
+ * @param pages[IN/OUT] the pages of the list (empty for a new list)
+ * @return error code. 0 if no error
+ */
+RC BTreeIndex::writePostingList(const vector<RecordId>& rids, vector<PageId>& pages)
+{
+	return writePostingList(rids, pages, pf.endPid());
+}
+
+/*
+ * Write a posting list as above, numbering the added pages from newPid on.
+ */
+RC BTreeIndex::writePostingList(const vector<RecordId>& rids, vector<PageId>& pages, PageId newPid)
+{
+	RC error;
+	vector<BTPostingNode> nodes(1);
+	for(unsigned i = 0; i < rids.size(); i++)
+	{
+		if(nodes.back().append(rids[i])==0) continue;
+		nodes.push_back(BTPostingNode());
+		nodes.back().append(rids[i]);
+	}
+
+	while(pages.size() < nodes.size()) pages.push_back(newPid++);
+
+	for(unsigned i = 0; i < nodes.size(); i++)
+	{
+		if(i > 0) nodes[i].setPrevNodePtr(pages[i-1]);
+		if(i+1 < nodes.size()) nodes[i].setNextNodePtr(pages[i+1]);
+	}
+	nodes[0].setTailPtr(pages[nodes.size()-1]);
+	nodes[0].setTotalCount(rids.size());
+
+	// the pages are in ascending order: the file grows one page at a time
+	for(unsigned i = 0; i < nodes.size(); i++)
+		if((error = nodes[i].write(pages[i], pf))!=0) return error;
+	return 0;
+}
+
+/*
+ * Count the (key, rid) entries stored in the entries [from, to) of a leaf.
+ * @param leafNode[IN] the leaf
+ * @param from[IN] the first entry to count
+ * @param to[IN] the entry behind the last one to count
+ * @param count[OUT] the number of entries, with all rids of posting lists
+ * @return error code. 0 if no error
+ */
+RC BTreeIndex::entryCount(BTLeafNode& leafNode, int from, int to, int& count)
+{
+	RC error;
+	int key;
+	RecordId rid;
+	count = 0;
+	for(int eid = from; eid < to && leafNode.readEntry(eid, key, rid)==0; eid++)
+	{
+		if(valueSize > 0 || !isPosting(rid))
+		{
+			count++;
+			continue;
+		}
+		BTPostingNode headNode;
+		if((error = headNode.read(rid.pid, pf))!=0) return error;
+		count += headNode.getTotalCount();
+	}
+	return 0;
 }
+
 /**
  * Run the standard B+Tree key search algorithm and identify the
  * leaf node where searchKey may exist. If an index entry with
@@ -263,21 +728,18 @@ RC BTreeIndex::locate(int searchKey, IndexCursor& cursor)
         return RC_NO_SUCH_RECORD;
     }
 
-    BTNonLeafNode NonLeaf;
+    // the nonleaf levels come from the node cache: only the leaf is read
+    const CachedNode* node;
     PageId nextPid=rootPid;
-    for(int height = 1; height!=treeHeight;)
+    for(int height = 1; height!=treeHeight; height++)
     {
-        error = NonLeaf.read(nextPid, pf);
+        error = readNonLeaf(nextPid, node);
        // cout<<"Non Leaf Read Error "<<error<<endl;
         if(error!=0) return error;
 
-        error = NonLeaf.locateChildPtr(searchKey, nextPid);
-       // cout<<"Non Leaf Child Locate Error "<<error<<endl;
-        if(error!=0) return error;
-
-        height++;
+        nextPid = node->children[firstChildIndex(node->keys, searchKey)];
     }
-    BTLeafNode leafNode;
+    BTLeafNode leafNode(valueSize, compressed);
 
     error = leafNode.read(nextPid, pf);
     //cout<<"Leaf Read Error "<<error<<endl;
@@ -287,13 +749,120 @@ RC BTreeIndex::locate(int searchKey, IndexCursor& cursor)
     //cout<<"Leaf Read Error "<<error<<endl;
     if(error!=0) return error;
 
+    // A writer in another process may have split the leaf after we read its
+    // parent: move right (B-link style) while the next leaf starts at or below searchKey
+    while(eid >= leafNode.getKeyCount() && leafNode.getNextNodePtr() > 0)
+    {
+        BTLeafNode rightNode(valueSize, compressed);
+        PageId rightPid = leafNode.getNextNodePtr();
+        int firstKey;
+        RecordId firstRid;
+
+        error = rightNode.read(rightPid, pf);
+        if(error!=0) return error;
+        if(rightNode.readEntry(0, firstKey, firstRid)!=0 || firstKey > searchKey) break;
+
+        leafNode = rightNode;
+        nextPid = rightPid;
+        leafNode.locate(searchKey, eid);
+    }
+
     // Update IndexCursor now.
     cursor.pid = nextPid;
     cursor.eid = eid;
+    cursor.lastRid.pid = -1; // nothing read yet
+    cursor.postingHead = cursor.postingPid = 0;
 
     return error;
 }
 
+/*
+ * Orders probe positions by their key.
+ */
+struct ProbeOrder {
+    const int* keys;
+    bool operator()(int a, int b) const { return keys[a] < keys[b]; }
+};
+
+/*
+ * Run locate() for a batch of keys, traversing the tree once.
+ * @param keys[IN] the keys to find (in any order)
+ * @param n[IN] the number of keys
+ * @param cursors[OUT] cursors[i] is the cursor for keys[i]
+ * @return error code. 0 if no error
+ */
+RC BTreeIndex::locateMany(const int* keys, int n, IndexCursor* cursors)
+{
+    if (treeHeight<=0) return RC_NO_SUCH_RECORD;
+    if (n<=0) return 0;
+
+    vector<int> order(n);
+    for(int i=0; i<n; i++) order[i] = i;
+    ProbeOrder byKey = { keys };
+    sort(order.begin(), order.end(), byKey);
+
+    return locateBatch(rootPid, 1, keys, order, 0, n, cursors);
+}
+
+/*
+ * Position the cursors of the probes order[lo..hi), sorted by key,
+ * in the subtree rooted at pid.
+ */
+RC BTreeIndex::locateBatch(PageId pid, int height, const int* keys, const vector<int>& order,
+                           int lo, int hi, IndexCursor* cursors)
+{
+    RC error;
+
+    if(height < treeHeight)
+    {
+        // split the sorted probes into runs that follow the same child
+        const CachedNode* node;
+        if((error = readNonLeaf(pid, node))!=0) return error;
+
+        vector<PageId> children;
+        vector<int> bounds;
+        for(int i = lo; i < hi; )
+        {
+            int childIdx = firstChildIndex(node->keys, keys[order[i]]);
+            int j = i+1;
+            while(j < hi && firstChildIndex(node->keys, keys[order[j]])==childIdx) j++;
+            children.push_back(node->children[childIdx]);
+            bounds.push_back(i);
+            i = j;
+        }
+        bounds.push_back(hi);
+
+        // (node may move in memory once the subtrees add to the cache)
+        for(unsigned c = 0; c < children.size(); c++)
+        {
+            error = locateBatch(children[c], height+1, keys, order, bounds[c], bounds[c+1], cursors);
+            if(error!=0) return error;
+        }
+        return 0;
+    }
+
+    // all probes of this leaf share one read
+    BTLeafNode leafNode(valueSize, compressed);
+    if((error = leafNode.read(pid, pf))!=0) return error;
+
+    for(int i = lo; i < hi; i++)
+    {
+        IndexCursor& cursor = cursors[order[i]];
+        leafNode.locate(keys[order[i]], cursor.eid);
+
+        // behind the last entry: locate() checks whether to move right
+        if(cursor.eid >= leafNode.getKeyCount() && leafNode.getNextNodePtr() > 0)
+        {
+            if((error = locate(keys[order[i]], cursor))!=0) return error;
+            continue;
+        }
+        cursor.pid = pid;
+        cursor.lastRid.pid = -1; // nothing read yet
+        cursor.postingHead = cursor.postingPid = 0;
+    }
+    return 0;
+}
+
 /*
  * Read the (key, rid) pair at the location specified by the index cursor,
  * and move foward the cursor to the next entry.
@@ -303,29 +872,94 @@ RC BTreeIndex::locate(int searchKey, IndexCursor& cursor)
  * @return error code. 0 if no error
  */
 RC BTreeIndex::readForward(IndexCursor& cursor, int& key, RecordId& rid)
+{
+	string value;
+	bool complete;
+	return readForward(cursor, key, rid, value, complete);
+}
+
+/*
+ * Read the (key, rid) pair and the stored value at the location specified
+ * by the index cursor, and move foward the cursor to the next entry.
+ * @param cursor[IN/OUT] the cursor pointing to an leaf-node index entry in the b+tree
+ * @param key[OUT] the key stored at the index cursor location.
+ * @param rid[OUT] the RecordId stored at the index cursor location.
+ * @param value[OUT] the value stored at the index cursor location.
+ * @param complete[OUT] false if value is missing or truncated and the record must be read.
+ * @return error code. 0 if no error
+ */
+RC BTreeIndex::readForward(IndexCursor& cursor, int& key, RecordId& rid, string& value, bool& complete)
 {
     //IndexCursor Details:
 	int cEid = cursor.eid;
 	PageId cPid = cursor.pid;
 		
 	//Cursor's leaf loaded using cPid
-	BTLeafNode leafNode;
+	BTLeafNode leafNode(valueSize, compressed);
 	RC error = leafNode.read(cPid, pf);
 	if(error==0) {/*cout<<"OK so far .. \n"*/;}
 	else return error;
 	//Incase the cursor pid is not valid, return error = RC_NO_SUCH_RECORD
 
+	//locate() leaves the cursor behind the last entry when searchKey is larger
+	//than every key in the leaf: the next entry is the first one of the next leaf
+	if(cEid >= leafNode.getKeyCount() && leafNode.getNextNodePtr() > 0)
+	{
+		cEid = 0;
+		cPid = leafNode.getNextNodePtr();
+		error = leafNode.read(cPid, pf);
+		if(error!=0) return error;
+	}
+
+	//Resume behind the last returned entry if a writer changed the leaf since
+	if(cursor.lastRid.pid >= 0)
+	{
+		error = resumeCursor(cursor, leafNode, cPid, cEid);
+		if(error!=0) return error;
+	}
+
 	//Find and return the key and RecordId using cursor eid (cEid)
 	error = leafNode.readEntry(cEid, key, rid);
 	if(error==0) {/*cout<<"OK so far .. \n"*/;}
 	else return error;
+	complete = (leafNode.readValue(cEid, value)==0);
 	//cout<<"CPiD: "<<cPid<<endl;
 	if(cPid <= 0) return RC_NO_SUCH_RECORD;
 
+	//A posting list entry returns the rids of the list one by one
+	PageId postingHead = 0, postingPid = 0;
+	int postingPos = 0;
+	if(valueSize==0 && isPosting(rid))
+	{
+		postingHead = rid.pid;
+		postingPid = rid.pid;
+		postingPos = BTPostingNode::HEADER_SIZE;
+		if(cursor.postingHead==postingHead && cursor.postingPid > 0)
+		{
+			postingPid = cursor.postingPid;
+			postingPos = cursor.postingPos;
+		}
+
+		BTPostingNode postingNode;
+		if((error = postingNode.read(postingPid, pf))!=0) return error;
+		if((error = postingNode.readEntry(postingPos, cursor.lastRid, rid))!=0) return error;
+
+		//at the end of the page go on with the next one (0: the list is done)
+		if(postingPos >= postingNode.getEndOffset())
+		{
+			postingPid = postingNode.getNextNodePtr();
+			postingPos = BTPostingNode::HEADER_SIZE;
+		}
+	}
+
 	//Increment cEid and check it is less than max
 	int count = leafNode.getKeyCount();
+	if(postingPid > 0)
+	{
+		//the next rid comes from the same posting list: stay on the entry
+	}
 	//If not exceeded,
-	if(cEid+1 < count)
+	else if(cEid+1 < count)
 	{
 		cEid++; //simply increment cursor eid
 	}
@@ -339,5 +973,569 @@ RC BTreeIndex::readForward(IndexCursor& cursor, int& key, RecordId& rid)
 	//update new eid and pid to cursor parameters.
 	cursor.eid = cEid;
 	cursor.pid = cPid;
+	cursor.lastKey = key;
+	cursor.lastRid = rid;
+	cursor.postingHead = postingHead;
+	cursor.postingPid = postingPid;
+	cursor.postingPos = postingPos;
+	return 0;
+}
+
+/*
+ * Make (pid, eid) point right behind the last entry returned through the
+ * cursor. Without concurrent writers the entry before eid (or, at the
+ * start of a leaf, every entry of it) is still in place and nothing moves.
+ * @param cursor[IN] the cursor holding the last returned entry
+ * @param leafNode[IN/OUT] the leaf at pid
+ * @param pid[IN/OUT] the leaf to continue in
+ * @param eid[IN/OUT] the entry to continue with
+ * @return error code. 0 if no error
+ */
+RC BTreeIndex::resumeCursor(const IndexCursor& cursor, BTLeafNode& leafNode, PageId& pid, int& eid)
+{
+	RC error;
+	int key;
+	RecordId rid;
+
+	// in the middle of a posting list the cursor stays on its entry
+	bool inList = cursor.postingPid > 0;
+
+	if(inList)
+	{
+		if(leafNode.readEntry(eid, key, rid)==0 && isLastEntry(cursor, key, rid)) return 0;
+	}
+	else if(eid > 0)
+	{
+		if(leafNode.readEntry(eid-1, key, rid)==0 && isLastEntry(cursor, key, rid)) return 0;
+	}
+	else if(leafNode.readEntry(0, key, rid)==0 && (key > cursor.lastKey || (key==cursor.lastKey && !isLastEntry(cursor, key, rid))))
+	{
+		return 0;
+	}
+
+	// the leaf changed: skip everything up to the last returned entry
+	while(true)
+	{
+		int count = leafNode.getKeyCount();
+		bool found = false;
+		for(eid = 0; eid < count; eid++)
+		{
+			leafNode.readEntry(eid, key, rid);
+			if(key > cursor.lastKey) return 0;
+			if(isLastEntry(cursor, key, rid))
+			{
+				if(!inList) eid++;
+				found = true;
+				break;
+			}
+		}
+		if(eid < count || leafNode.getNextNodePtr() <= 0) return 0;
+
+		pid = leafNode.getNextNodePtr();
+		eid = 0;
+		error = leafNode.read(pid, pf);
+		if(error!=0) return error;
+
+		// the last returned entry ended the leaf: the scan goes on here
+		if(found) return 0;
+	}
+}
+
+/*
+ * Identify the index entry with the largest key that is smaller than
+ * or equal to searchKey, and set the cursor to its location.
+ * @param searchKey[IN] the upper bound (inclusive) of the scan
+ * @param cursor[OUT] the cursor pointing to the starting index entry
+ * @return error code. 0 if no error
+ */
+RC BTreeIndex::locateBackward(int searchKey, IndexCursor& cursor)
+{
+	RC error;
+	int eid;
+	int storedKey;
+	RecordId storedRid;
+
+	// the leaf where searchKey may exist holds the largest key <= searchKey,
+	// unless every key in it is larger (then it is the last entry of the previous leaf)
+	error = locate(searchKey, cursor);
+	if(error!=0) return error;
+
+	BTLeafNode leafNode(valueSize, compressed);
+	error = leafNode.read(cursor.pid, pf);
+	if(error!=0) return error;
+
+	// skip the entries equal to searchKey, which may go on in the next leaves
+	eid = cursor.eid;
+	while(true)
+	{
+		while(leafNode.readEntry(eid, storedKey, storedRid)==0 && storedKey==searchKey) eid++;
+		if(eid < leafNode.getKeyCount() || leafNode.getNextNodePtr() <= 0) break;
+
+		BTLeafNode nextNode(valueSize, compressed);
+		PageId nextPid = leafNode.getNextNodePtr();
+		if((error = nextNode.read(nextPid, pf))!=0) return error;
+		if(nextNode.readEntry(0, storedKey, storedRid)!=0 || storedKey!=searchKey) break;
+		leafNode = nextNode;
+		cursor.pid = nextPid;
+		eid = 0;
+	}
+	// eid is now the first entry with a key larger than searchKey
+
+	if(eid > 0)
+	{
+		cursor.eid = eid-1;
+	}
+	else
+	{
+		cursor.pid = leafNode.getPrevNodePtr(); // 0 if this is the left-most leaf
+		cursor.eid = -1;
+	}
+	return 0;
+}
+
+/*
+ * Read the (key, rid) pair at the location specified by the index cursor,
+ * and move backward the cursor to the previous entry.
+ * @param cursor[IN/OUT] the cursor pointing to an leaf-node index entry in the b+tree
+ * @param key[OUT] the key stored at the index cursor location.
+ * @param rid[OUT] the RecordId stored at the index cursor location.
+ * @return error code. 0 if no error
+ */
+RC BTreeIndex::readBackward(IndexCursor& cursor, int& key, RecordId& rid)
+{
+	int cEid = cursor.eid;
+	PageId cPid = cursor.pid;
+
+	// page 0 holds rootPid and treeHeight, so pid 0 marks the end of the chain
+	if(cPid <= 0) return RC_END_OF_TREE;
+
+	BTLeafNode leafNode(valueSize, compressed);
+	RC error = leafNode.read(cPid, pf);
+	if(error!=0) return error;
+
+	// eid = -1 refers to the last entry of the leaf
+	if(cEid < 0) cEid = leafNode.getKeyCount()-1;
+
+	error = leafNode.readEntry(cEid, key, rid);
+	if(error!=0) return error;
+
+	// a posting list entry returns the rids of the list from the last one
+	PageId postingHead = 0, postingPid = 0;
+	int postingPos = -1;
+	if(valueSize==0 && isPosting(rid))
+	{
+		postingHead = rid.pid;
+		if(cursor.postingHead==postingHead && cursor.postingPid > 0)
+		{
+			postingPid = cursor.postingPid;
+			postingPos = cursor.postingPos;
+		}
+		else
+		{
+			BTPostingNode headNode;
+			if((error = headNode.read(postingHead, pf))!=0) return error;
+			postingPid = headNode.getTailPtr();
+		}
+
+		// the rids are delta-encoded: decode the page up to postingPos
+		BTPostingNode postingNode;
+		if((error = postingNode.read(postingPid, pf))!=0) return error;
+		if(postingPos < 0) postingPos = postingNode.getCount()-1;
+		int offset = BTPostingNode::HEADER_SIZE;
+		RecordId prev = rid;
+		for(int i = 0; i <= postingPos; i++)
+		{
+			if((error = postingNode.readEntry(offset, prev, rid))!=0) return error;
+			prev = rid;
+		}
+
+		if(postingPos > 0) postingPos--;
+		else
+		{
+			postingPid = postingNode.getPrevNodePtr(); // 0: the list is done
+			postingPos = -1;
+		}
+	}
+
+	if(postingPid > 0)
+	{
+		// the next rid comes from the same posting list: stay on the entry
+	}
+	else if(cEid > 0)
+	{
+		cEid--;
+	}
+	else
+	{
+		// a concurrent split may have put a new sibling between the previous
+		// leaf and this one before updating our back pointer: move right to it
+		PageId prevPid = leafNode.getPrevNodePtr();
+		BTLeafNode prevNode(valueSize, compressed);
+		while(prevPid > 0)
+		{
+			error = prevNode.read(prevPid, pf);
+			if(error!=0) return error;
+			if(prevNode.getNextNodePtr()==cPid || prevNode.getNextNodePtr() <= 0) break;
+			prevPid = prevNode.getNextNodePtr();
+		}
+		cPid = prevPid;
+		cEid = -1;
+	}
+
+	cursor.eid = cEid;
+	cursor.pid = cPid;
+	cursor.postingHead = postingHead;
+	cursor.postingPid = postingPid;
+	cursor.postingPos = postingPos;
+	return 0;
+}
+
+/*
+ * Return the number of (key, rid) entries in the subtree rooted at pid.
+ * @param pid[IN] the root of the subtree
+ * @param height[IN] the level of pid (1 is the root level)
+ * @param count[OUT] the number of entries in the subtree
+ * @return error code. 0 if no error
+ */
+RC BTreeIndex::subtreeCount(PageId pid, int height, int& count)
+{
+	RC error;
+	if(height==treeHeight)
+	{
+		BTLeafNode leafNode(valueSize, compressed);
+		if((error = leafNode.read(pid, pf))!=0) return error;
+		if((error = entryCount(leafNode, 0, leafNode.getKeyCount(), count))!=0) return error;
+	}
+	else
+	{
+		const CachedNode* node;
+		if((error = readNonLeaf(pid, node))!=0) return error;
+		count = 0;
+		for(unsigned j=0; j<node->counts.size(); j++) count += node->counts[j];
+	}
+	return 0;
+}
+
+/*
+ * Count the index entries with a key smaller than searchKey
+ * (or smaller than or equal to searchKey if inclusive is set).
+ * @param searchKey[IN] the bound to count up to
+ * @param inclusive[IN] whether entries equal to searchKey are counted
+ * @param count[OUT] the number of entries below the bound
+ * @return error code. 0 if no error
+ */
+RC BTreeIndex::countBelow(int searchKey, bool inclusive, int& count)
+{
+	RC error;
+	count = 0;
+	if(treeHeight<=0) return 0;
+
+	// on the way down, every child left of the followed pointer lies entirely below searchKey
+	const CachedNode* node;
+	PageId nextPid = rootPid;
+	for(int height = 1; height < treeHeight; height++)
+	{
+		if((error = readNonLeaf(nextPid, node))!=0) return error;
+		// (entries equal to searchKey may lie left of an equal separating key)
+		int childIdx = inclusive ? childIndex(node->keys, searchKey) : firstChildIndex(node->keys, searchKey);
+		for(int j=0; j<childIdx; j++) count += node->counts[j];
+		nextPid = node->children[childIdx];
+	}
+
+	BTLeafNode leafNode(valueSize, compressed);
+	if((error = leafNode.read(nextPid, pf))!=0) return error;
+
+	int eid, storedKey;
+	RecordId storedRid;
+	leafNode.locate(searchKey, eid);
+	while(inclusive && leafNode.readEntry(eid, storedKey, storedRid)==0 && storedKey==searchKey) eid++;
+
+	int leafCount;
+	if((error = entryCount(leafNode, 0, eid, leafCount))!=0) return error;
+	count += leafCount;
+	return 0;
+}
+
+/*
+ * Count the index entries whose key lies in [lo, hi].
+ * @param lo[IN] the smallest key to count (inclusive)
+ * @param hi[IN] the largest key to count (inclusive)
+ * @param count[OUT] the number of entries in the range
+ * @return error code. 0 if no error
+ */
+RC BTreeIndex::countRange(int lo, int hi, int& count)
+{
+	RC error;
+	int below, upto;
+	count = 0;
+	if(lo > hi) return 0;
+
+	if((error = countBelow(hi, true, upto))!=0) return error;
+	if((error = countBelow(lo, false, below))!=0) return error;
+	count = upto - below;
+	return 0;
+}
+
+/*
+ * Store the first VALUE_PREFIX_LENGTH bytes of the value column in every
+ * leaf entry, so that queries on the value can be answered from the index.
+ * @return error code. 0 if no error
+ */
+RC BTreeIndex::includeValue()
+{
+	if(valueSize == VALUE_PREFIX_LENGTH) return 0;
+	if(treeHeight > 0 || compressed) return RC_INVALID_FILE_FORMAT; // layout of an existing index cannot change
+	valueSize = VALUE_PREFIX_LENGTH;
+	return 0;
+}
+
+/*
+ * Store the leaves of a new (empty) index compressed.
+ * @return error code. 0 if no error
+ */
+RC BTreeIndex::compressLeaves()
+{
+	if(compressed) return 0;
+	if(treeHeight > 0 || valueSize > 0) return RC_INVALID_FILE_FORMAT; // layout of an existing index cannot change
+	compressed = true;
+	return 0;
+}
+
+/*
+ * Start building a new (empty) index bottom-up.
+ * @param fillFactor[IN] the percentage of each node to fill (50 to 100)
+ * @return error code. 0 if no error, RC_INVALID_ATTRIBUTE if fillFactor
+ *         is out of range
+ */
+RC BTreeIndex::bulkStart(int fillFactor)
+{
+	if(treeHeight > 0 || pf.endPid() > 1) return RC_INVALID_FILE_FORMAT; // only a new index is built bottom-up
+
+	if(fillFactor < 50 || fillFactor > 100) return RC_INVALID_ATTRIBUTE;
+
+	bulk.fillFactor = fillFactor;
+	delete bulk.leaf;
+	bulk.leaf = new BTLeafNode(valueSize, compressed);
+	bulk.leafTarget = max(1, bulk.leaf->getMaxKeyCount()*bulk.fillFactor/100);
+	bulk.nextPid = 1;
+	bulk.leafPid = bulk.nextPid++;
+	bulk.leafCount = 0;
+	bulk.hasKey = false;
+	bulk.rids.clear();
+	bulk.firstKeys.clear();
+	bulk.leafPids.clear();
+	bulk.leafCounts.clear();
+	return 0;
+}
+
+/*
+ * Add an entry to an index being built by bulkStart().
+ * @param key[IN] the key, not smaller than the key of the entry before
+ * @param rid[IN] the RecordId of the record
+ * @param value[IN] the value of the record (stored by a covering index)
+ * @return error code. 0 if no error
+ */
+RC BTreeIndex::bulkInsert(int key, const RecordId& rid, const string& value)
+{
+	RC error;
+
+	// a leaf slot holding key 0 is empty (see BTLeafNode::getKeyCount())
+	if(key==0) return RC_INVALID_ATTRIBUTE;
+
+	// the entries of a covering index carry their values: no posting lists
+	if(valueSize > 0) return bulkAdd(key, rid, value);
+
+	if(bulk.hasKey && key!=bulk.key && (error = bulkFlushKey())!=0) return error;
+	bulk.hasKey = true;
+	bulk.key = key;
+	bulk.rids.push_back(rid);
+	return 0;
+}
+
+/*
+ * Add the collected entries of bulk.key to the leaves.
+ * @return error code. 0 if no error
+ */
+RC BTreeIndex::bulkFlushKey()
+{
+	RC error;
+
+	if(bulk.rids.size() >= (unsigned)POSTING_MIN_ENTRIES)
+	{
+		// the list goes to the pages right behind the leaf that points to it
+		RecordId head;
+		head.sid = BTPostingNode::POSTING_SID;
+		head.pid = bulk.nextPid;
+		if(bulk.leaf->getKeyCount() >= bulk.leafTarget || bulk.leaf->insert(bulk.key, head)!=0)
+		{
+			if((error = bulkNextLeaf())!=0) return error;
+			head.pid = bulk.nextPid;
+			if((error = bulk.leaf->insert(bulk.key, head))!=0) return error;
+		}
+
+		vector<PageId> pages;
+		sort(bulk.rids.begin(), bulk.rids.end());
+		if((error = writePostingList(bulk.rids, pages, bulk.nextPid))!=0) return error;
+		bulk.nextPid += pages.size();
+		bulk.leafCount += bulk.rids.size();
+	}
+	else
+	{
+		for(unsigned i = 0; i < bulk.rids.size(); i++)
+			if((error = bulkAdd(bulk.key, bulk.rids[i], ""))!=0) return error;
+	}
+	bulk.rids.clear();
+	bulk.hasKey = false;
+	return 0;
+}
+
+/*
+ * Add (key, rid) to the leaf being filled, or to the next leaf if it is full.
+ * @return error code. 0 if no error
+ */
+RC BTreeIndex::bulkAdd(int key, const RecordId& rid, const string& value)
+{
+	RC error;
+
+	if(bulk.leaf->getKeyCount() >= bulk.leafTarget || bulk.leaf->insert(key, rid, value)!=0)
+	{
+		if((error = bulkNextLeaf())!=0) return error;
+		if((error = bulk.leaf->insert(key, rid, value))!=0) return error;
+	}
+	bulk.leafCount++;
+	return 0;
+}
+
+/*
+ * Write the leaf being filled, pointing to the page allocated for the
+ * next one, and start the next one.
+ * @return error code. 0 if no error
+ */
+RC BTreeIndex::bulkNextLeaf()
+{
+	RC error;
+	PageId pid = bulk.nextPid++;
+
+	bulk.leaf->setNextNodePtr(pid);
+	if((error = bulkWriteLeaf())!=0) return error;
+
+	delete bulk.leaf;
+	bulk.leaf = new BTLeafNode(valueSize, compressed);
+	bulk.leaf->setPrevNodePtr(bulk.leafPid);
+	bulk.leafPid = pid;
+	bulk.leafCount = 0;
+	return 0;
+}
+
+/*
+ * Write the leaf being filled, and note its first key, pid and entry count
+ * for the level above.
+ * @return error code. 0 if no error
+ */
+RC BTreeIndex::bulkWriteLeaf()
+{
+	RC error;
+	int key;
+	RecordId rid;
+
+	if((error = bulk.leaf->write(bulk.leafPid, pf))!=0) return error;
+	bulk.leaf->readEntry(0, key, rid);
+	bulk.firstKeys.push_back(key);
+	bulk.leafPids.push_back(bulk.leafPid);
+	bulk.leafCounts.push_back(bulk.leafCount);
+	return 0;
+}
+
+/*
+ * Write the last leaf, the nonleaf levels and the header of an index
+ * being built by bulkStart(). Each level groups the nodes below it into
+ * nodes filled to the fill factor, with the children spread evenly.
+ * @return error code. 0 if no error
+ */
+RC BTreeIndex::bulkFinish()
+{
+	RC error;
+
+	if(bulk.hasKey && (error = bulkFlushKey())!=0) return error;
+	if(bulk.leaf->getKeyCount() > 0 && (error = bulkWriteLeaf())!=0) return error;
+	delete bulk.leaf;
+	bulk.leaf = NULL;
+	if(bulk.leafPids.empty()) return writeHeader(); // no entries: still an empty index
+
+	vector<int> keys;
+	vector<PageId> pids;
+	vector<int> counts;
+	keys.swap(bulk.firstKeys);
+	pids.swap(bulk.leafPids);
+	counts.swap(bulk.leafCounts);
+
+	int height = 1;
+	int perNode = max(4, (BTNonLeafNode::MAX_KEYS+1)*bulk.fillFactor/100);
+	while(pids.size() > 1)
+	{
+		vector<int> upKeys;
+		vector<PageId> upPids;
+		vector<int> upCounts;
+		int n = pids.size();
+		int nodes = (n + perNode-1)/perNode;
+		for(int i = 0, first = 0; i < nodes; i++)
+		{
+			int last = first + n/nodes + (i < n%nodes ? 1 : 0);
+			BTNonLeafNode node;
+			int total = counts[first] + counts[first+1];
+			node.initializeRoot(pids[first], counts[first], keys[first+1], pids[first+1], counts[first+1]);
+			for(int j = first+2; j < last; j++)
+			{
+				// behind the last child, also among equal keys
+				if((error = node.insert(keys[j], pids[j], counts[j], j-first-1))!=0) return error;
+				total += counts[j];
+			}
+
+			PageId pid = bulk.nextPid++;
+			if((error = node.write(pid, pf))!=0) return error;
+			cacheNonLeaf(pid, node);
+			upKeys.push_back(keys[first]);
+			upPids.push_back(pid);
+			upCounts.push_back(total);
+			first = last;
+		}
+		keys.swap(upKeys);
+		pids.swap(upPids);
+		counts.swap(upCounts);
+		height++;
+	}
+
+	rootPid = pids[0];
+	treeHeight = height;
+	rightPath.clear();
+	return writeHeader();
+}
+
+/*
+ * Walk the leaf chain and describe the leaf level.
+ * @param leaves[OUT] the # of leaves
+ * @param keys[OUT] the # of keys in the leaves (a posting list is one key)
+ * @param capacity[OUT] the # of keys the leaves have room for
+ * @param backJumps[OUT] the # of leaves whose next leaf is stored before them
+ * @return error code. 0 if no error
+ */
+RC BTreeIndex::getLeafStats(int& leaves, int& keys, int& capacity, int& backJumps)
+{
+	RC error;
+	IndexCursor cursor;
+	BTLeafNode leafNode(valueSize, compressed);
+
+	leaves = keys = capacity = backJumps = 0;
+	if(treeHeight==0) return 0;
+
+	locate(INT_MIN, cursor);
+	for(PageId pid = cursor.pid; pid > 0; pid = leafNode.getNextNodePtr())
+	{
+		if((error = leafNode.read(pid, pf))!=0) return error;
+		leaves++;
+		keys += leafNode.getKeyCount();
+		capacity += leafNode.getMaxKeyCount();
+		if(leafNode.getNextNodePtr() > 0 && leafNode.getNextNodePtr() < pid) backJumps++;
+	}
 	return 0;
 }
@@ -17,6 +17,9 @@
 #include <iostream>
 #include <cstring>
 #include <stdlib.h>             
+#include <sys/stat.h>
+#include <map>
+#include <vector>
 /**
  * The data structure to point to a particular entry at a b+tree leaf node.
  * An IndexCursor consists of pid (PageId of the leaf node) and 
@@ -27,16 +30,43 @@ typedef struct {
   // PageId of the index entry
   PageId  pid;  
   // The entry number inside the node
+  // (-1 means the last entry of the node; only produced by backward scans)
   int     eid;  
+  // the last entry returned by readForward() (lastRid.pid = -1 if none yet).
+  // if a concurrent writer shifted or split the leaf in the meantime, the
+  // scan resumes right behind this entry.
+  int      lastKey;
+  RecordId lastRid;
+  // the position in the posting list (see BTPostingNode) of the entry at
+  // eid: postingHead is the first page of the list, postingPid the page and
+  // postingPos the byte offset of the next rid (the index of the next rid
+  // in the page for backward scans, -1 for the last one). postingPid = 0
+  // if the list is not being read; postingHead then tells whether the last
+  // entry returned was the end of a list.
+  PageId   postingHead;
+  PageId   postingPid;
+  int      postingPos;
 } IndexCursor;
 
+class BTLeafNode;
+class BTNonLeafNode;
+
 /**
  * Implements a B-Tree index for bruinbase.
  * 
  */
 class BTreeIndex {
  public:
+  // number of value bytes kept in the leaf entries of a covering index.
+  // values shorter than this are stored completely.
+  static const int VALUE_PREFIX_LENGTH = 28;
+
+  // once a leaf holds this many entries with the same key, their rids move
+  // to a posting list (not in a covering index, whose entries carry values)
+  static const int POSTING_MIN_ENTRIES = 32;
+
   BTreeIndex();
+  ~BTreeIndex();
 
   /**
    * Open the index file in read or write mode.
@@ -57,10 +87,71 @@ class BTreeIndex {
    * Insert (key, RecordId) pair to the index.
    * @param key[IN] the key for the value inserted into the index
    * @param rid[IN] the RecordId for the record being inserted into the index
-   * @return error code. 0 if no error
+   * @return error code. 0 if no error, RC_INVALID_ATTRIBUTE for key 0,
+   *         which marks an empty slot in a leaf
    */
   RC insert(int key, const RecordId& rid);
 
+  /**
+   * Insert (key, RecordId) pair to the index. For a covering index the
+   * first VALUE_PREFIX_LENGTH bytes of value are stored with the entry.
+   * @param key[IN] the key for the value inserted into the index
+   * @param rid[IN] the RecordId for the record being inserted into the index
+   * @param value[IN] the value of the record being inserted
+   * @return error code. 0 if no error, RC_INVALID_ATTRIBUTE for key 0,
+   *         which marks an empty slot in a leaf
+   */
+  RC insert(int key, const RecordId& rid, const std::string& value);
+
+  /**
+   * Turn a new (empty) index into a covering index that stores a prefix
+   * of the value column in every leaf entry.
+   * @return error code. 0 if no error, an error code if the index
+   *         already holds entries without values
+   */
+  RC includeValue();
+
+  /**
+   * @return true if the leaf entries carry a prefix of the value column
+   */
+  bool includesValue() const { return valueSize > 0; }
+
+  /**
+   * Make a new (empty) index store its leaves compressed (see
+   * BTLeafNode(int, bool)), so that a leaf holds more entries and range
+   * scans read fewer leaves. Not available for a covering index.
+   * @return error code. 0 if no error, an error code if the index
+   *         already holds entries or includes values
+   */
+  RC compressLeaves();
+
+  /**
+   * @return true if the leaves are stored compressed
+   */
+  bool leavesCompressed() const { return compressed; }
+
+  /**
+   * @return the size of the index file in pages
+   */
+  int getPageCount() const { return pf.endPid(); }
+
+  /**
+   * @return the height of the tree (0 if it is empty, 1 if the root is a leaf)
+   */
+  int getTreeHeight() const { return treeHeight; }
+
+  /**
+   * Keep up to pages modified nodes in memory across inserts, and write
+   * each of them once, when it is evicted or the index is closed.
+   * @param pages[IN] the max # of dirty nodes to keep (0: write through)
+   */
+  void setWriteBuffer(int pages) { pf.setWriteBuffer(pages); }
+
+  /**
+   * @return the # of node writes absorbed by the write buffer since open()
+   */
+  int getCoalescedWriteCount() const { return pf.getCoalescedWriteCount(); }
+
   /**
    * Run the standard B+Tree key search algorithm and identify the
    * leaf node where searchKey may exist. If an index entry with
@@ -81,17 +172,41 @@ class BTreeIndex {
    */
   RC locate(int searchKey, IndexCursor& cursor);
 
-/**
-   * Recursive function for insertion
-   * Using the returned "IndexCursor", you will have to call readForward()
-   * to retrieve the actual (key, rid) pair from the index.
-   * @param key[IN] the key to find
-   * @param cursor[OUT] the cursor pointing to the index entry with 
-   *                    searchKey or immediately behind the largest key 
-   *                    smaller than searchKey.
-   * @return 0 if searchKey is found. Othewise, an error code
+  /**
+   * Run locate() for a batch of keys at once. The keys are sorted and the
+   * tree is traversed once, so every node on the way is visited at most
+   * once per batch and keys that fall into the same leaf share its read.
+   * @param keys[IN] the keys to find (in any order)
+   * @param n[IN] the number of keys
+   * @param cursors[OUT] cursors[i] is set as locate(keys[i], cursors[i]) would
+   * @return error code. 0 if no error
    */
-  RC helper_insert(int key, const RecordId& rid, PageId rootPid, int height,int& midKey, PageId& insertPid);
+  RC locateMany(const int* keys, int n, IndexCursor* cursors);
+
+  /**
+   * Recursive function for insertion.
+   * Insert (key, rid) into the subtree rooted at pagePid. If the node at
+   * pagePid had to be split, the new sibling is reported through midKey,
+   * insertPid and insertCount so that the caller can add it to the parent.
+   * @param key[IN] the key to insert
+   * @param rid[IN] the RecordId to insert
+   * @param value[IN] the value to keep in the entry of a covering index
+   * @param pagePid[IN] the root of the subtree
+   * @param height[IN] the level of pagePid (1 is the root level)
+   * @param midKey[OUT] the key to insert into the parent, -1 if no split
+   * @param insertPid[OUT] the PageId of the new sibling, -1 if no split
+   * @param insertCount[OUT] the number of entries under the new sibling
+   * @param rightEdge[IN] true if pagePid is the right-most node on its level
+   * @return error code. 0 if no error
+   */
+  RC helper_insert(int key, const RecordId& rid, const std::string& value, PageId pagePid, int height, int& midKey, PageId& insertPid, int& insertCount, bool rightEdge);
+
+  /**
+   * Insert (key, rid) into the right-most leaf through rightPath, without
+   * searching the tree. appended is false (and nothing is written) if the
+   * leaf is full; the insert then has to go through helper_insert().
+   */
+  RC appendRightmost(int key, const RecordId& rid, const std::string& value, bool& appended);
 
   /**
    * Read the (key, rid) pair at the location specified by the index cursor,
@@ -102,15 +217,265 @@ class BTreeIndex {
    * @return error code. 0 if no error
    */
   RC readForward(IndexCursor& cursor, int& key, RecordId& rid);
+
+  /**
+   * Same as above, but also returns the value stored in the entry.
+   * complete is set to false when the index does not cover the value or
+   * the value was longer than VALUE_PREFIX_LENGTH; the record has to be
+   * read from the table in that case.
+   * @param cursor[IN/OUT] the cursor pointing to an leaf-node index entry in the b+tree
+   * @param key[OUT] the key stored at the index cursor location
+   * @param rid[OUT] the RecordId stored at the index cursor location
+   * @param value[OUT] the value (prefix) stored at the index cursor location
+   * @param complete[OUT] true if value holds the complete record value
+   * @return error code. 0 if no error
+   */
+  RC readForward(IndexCursor& cursor, int& key, RecordId& rid, std::string& value, bool& complete);
+
+  /**
+   * Identify the index entry with the largest key that is smaller than
+   * or equal to searchKey, and set the cursor to its location so that
+   * readBackward() returns the entries in descending key order.
+   * locateBackward(INT_MAX, cursor) positions the cursor at the largest
+   * key in the index. If every key is larger than searchKey,
+   * cursor.pid is set to 0 and readBackward() reports the end of the tree.
+   * @param searchKey[IN] the upper bound (inclusive) of the scan
+   * @param cursor[OUT] the cursor pointing to the starting index entry
+   * @return error code. 0 if no error
+   */
+  RC locateBackward(int searchKey, IndexCursor& cursor);
+
+  /**
+   * Read the (key, rid) pair at the location specified by the index cursor,
+   * and move backward the cursor to the previous entry, following the
+   * previous-sibling pointers of the leaf nodes.
+   * @param cursor[IN/OUT] the cursor pointing to an leaf-node index entry in the b+tree
+   * @param key[OUT] the key stored at the index cursor location
+   * @param rid[OUT] the RecordId stored at the index cursor location
+   * @return error code. 0 if no error, RC_END_OF_TREE past the first entry
+   */
+  RC readBackward(IndexCursor& cursor, int& key, RecordId& rid);
+  
+  /**
+   * Count the index entries whose key lies in [lo, hi], using the
+   * per-child entry counts of the nonleaf nodes. This reads two
+   * root-to-leaf paths no matter how many entries are in the range.
+   * @param lo[IN] the smallest key to count (inclusive)
+   * @param hi[IN] the largest key to count (inclusive)
+   * @param count[OUT] the number of entries in the range
+   * @return error code. 0 if no error
+   */
+  RC countRange(int lo, int hi, int& count);
+
+  /**
+   * Start building a new (empty) index bottom-up: the entries are passed
+   * to bulkInsert() in key order, and bulkFinish() completes the index.
+   * Every leaf is filled to fillFactor percent and written once, right
+   * behind the leaf before it (and the posting lists of that leaf's keys),
+   * so that a range scan reads the file front to back. The nonleaf levels
+   * are written behind the leaves.
+   * @param fillFactor[IN] the percentage of each node to fill (50 to 100)
+   * @return error code. 0 if no error, RC_INVALID_ATTRIBUTE if fillFactor is
+   *         out of range, another error code if the index is not empty
+   */
+  RC bulkStart(int fillFactor);
+
+  /**
+   * Add an entry to an index being built by bulkStart().
+   * @param key[IN] the key, not smaller than the key of the entry before
+   * @param rid[IN] the RecordId of the record
+   * @param value[IN] the value of the record (stored by a covering index)
+   * @return error code. 0 if no error, RC_INVALID_ATTRIBUTE for key 0
+   */
+  RC bulkInsert(int key, const RecordId& rid, const std::string& value);
+
+  /**
+   * Write the last leaf, the nonleaf levels and the header of an index
+   * being built by bulkStart().
+   * @return error code. 0 if no error
+   */
+  RC bulkFinish();
+
+  /**
+   * Walk the leaf chain and describe the leaf level.
+   * @param leaves[OUT] the # of leaves
+   * @param keys[OUT] the # of keys in the leaves (a posting list is one key)
+   * @param capacity[OUT] the # of keys the leaves have room for
+   * @param backJumps[OUT] the # of leaves whose next leaf is stored before
+   *                       them, i.e. where a range scan seeks backwards
+   * @return error code. 0 if no error
+   */
+  RC getLeafStats(int& leaves, int& keys, int& capacity, int& backJumps);
   
  private:
+  /**
+   * A nonleaf node decoded into memory: children[j] covers the keys in
+   * [keys[j-1], keys[j]) and holds counts[j] entries. Lookups binary search
+   * keys instead of scanning and parsing the page.
+   */
+  struct CachedNode {
+    std::vector<int>    keys;
+    std::vector<PageId> children; // empty if the node is not cached
+    std::vector<int>    counts;
+  };
+
+  /**
+   * The decoded nonleaf levels of an index file, kept for the lifetime of
+   * the process so that a lookup only reads the leaf page. fileStat
+   * identifies the version of the file the cache was built from; when the
+   * file changes behind our back (a LOAD in another process), it is dropped.
+   */
+  struct NodeCache {
+    bool        valid;      // false until the header has been cached
+    struct stat fileStat;   // the file the cached nodes were read from
+    PageId      rootPid;
+    int         treeHeight;
+    int         valueSize;
+    bool        compressed;
+    std::vector<CachedNode> nodes; // indexed by PageId
+  };
+
+  static std::map<std::string, NodeCache> nodeCaches;
+
+  /**
+   * Recursive function for locateMany(): position the cursors of the
+   * probes order[lo..hi) (sorted by key) in the subtree rooted at pid.
+   */
+  RC locateBatch(PageId pid, int height, const int* keys, const std::vector<int>& order,
+                 int lo, int hi, IndexCursor* cursors);
+
+  /**
+   * Return the decoded nonleaf node at pid, reading it if it is not cached.
+   */
+  RC readNonLeaf(PageId pid, const CachedNode*& node);
+
+  /**
+   * Store the decoded content of a nonleaf node that was just written to pid.
+   */
+  void cacheNonLeaf(PageId pid, BTNonLeafNode& node);
+
+  /**
+   * Count the entries with a key below searchKey (or equal to it if
+   * inclusive is set) by summing the counts left of the search path.
+   */
+  RC countBelow(int searchKey, bool inclusive, int& count);
+
+  /**
+   * Return the number of entries in the subtree rooted at pid.
+   */
+  RC subtreeCount(PageId pid, int height, int& count);
+
+  /**
+   * Insert (key, rid) into the leaf at pid and write it, or append rid to
+   * the posting list of key in the leaf. A key that reaches
+   * POSTING_MIN_ENTRIES entries in the leaf gets a posting list.
+   * @param inserted[OUT] false if the leaf is full and nothing was written
+   */
+  RC insertIntoLeaf(BTLeafNode& leafNode, PageId pid, int key, const RecordId& rid,
+                    const std::string& value, bool& inserted);
+
+  /**
+   * Append rid to the posting list starting at head, keeping it sorted.
+   */
+  RC appendPosting(PageId head, const RecordId& rid);
+
+  /**
+   * Read all rids of the posting list starting at head and its pages.
+   */
+  RC readPostingList(PageId head, std::vector<RecordId>& rids, std::vector<PageId>& pages);
+
+  /**
+   * Write the sorted rids as a posting list into pages, adding pages at
+   * the end of the file if there are not enough. pages[0] is the head.
+   */
+  RC writePostingList(const std::vector<RecordId>& rids, std::vector<PageId>& pages);
+
+  /**
+   * Same as above, but the added pages are numbered from newPid on.
+   */
+  RC writePostingList(const std::vector<RecordId>& rids, std::vector<PageId>& pages, PageId newPid);
+
+  /**
+   * The state of a bulk load (see bulkStart()): the leaf being filled,
+   * the entries of the last key (a posting list if there are enough), and
+   * the first key, pid and entry count of every leaf written so far.
+   */
+  struct BulkLoad {
+    BTLeafNode* leaf;        // the leaf being filled
+    int      fillFactor;
+    int      leafTarget;   // keys per leaf
+    PageId   nextPid;      // the next page to allocate
+    PageId   leafPid;      // the page of the leaf being filled
+    int      leafCount;    // entries in that leaf, with the rids of posting lists
+    bool     hasKey;       // whether there are entries of key
+    int      key;
+    std::vector<RecordId> rids;   // the entries of key not in a leaf yet
+    std::vector<int>    firstKeys;
+    std::vector<PageId> leafPids;
+    std::vector<int>    leafCounts;
+  };
+
+  /**
+   * Add the entries of bulk.key to the leaves, as a posting list if there
+   * are enough of them.
+   */
+  RC bulkFlushKey();
+
+  /**
+   * Add (key, rid) to the leaf being filled, moving on to the next leaf
+   * if it is full.
+   */
+  RC bulkAdd(int key, const RecordId& rid, const std::string& value);
+
+  /**
+   * Write the leaf being filled and start the next one.
+   */
+  RC bulkNextLeaf();
+
+  /**
+   * Write the leaf being filled, and note its first key, pid and count.
+   */
+  RC bulkWriteLeaf();
+
+  /**
+   * Return the number of (key, rid) entries stored in the entries
+   * [from, to) of the leaf, counting every rid of a posting list.
+   */
+  RC entryCount(BTLeafNode& leafNode, int from, int to, int& count);
+
+  /**
+   * Write rootPid, treeHeight and valueSize to page 0. Called by close()
+   * and whenever the root changes, so that readers opening the index while
+   * it is being written start from a valid root.
+   */
+  RC writeHeader();
+
+  /**
+   * Move eid (and pid, if needed) right behind the last entry returned
+   * through the cursor, in case a concurrent insert shifted the entries.
+   */
+  RC resumeCursor(const IndexCursor& cursor, BTLeafNode& leafNode, PageId& pid, int& eid);
+
   char buffer[PageFile::PAGE_SIZE]; // to store rootPid and treeHeight before writing to disk.
   PageFile pf;         /// the PageFile used to store the actual b+tree in disk
+  char     mode;       /// 'r' or 'w'
+  std::string indexname; /// the name of the index file
+  NodeCache* cache;    /// the node cache of the index file
 
   PageId   rootPid;    /// the PageId of the root node
   int      treeHeight; /// the height of the tree
-  /// Note that the content of the above two variables will be gone when
-  /// this class is destructed. Make sure to store the values of the two 
+  int      valueSize;  /// value bytes in each leaf entry (0: not covering)
+  bool     compressed; /// whether the leaves are compressed on disk
+
+  BulkLoad bulk;       /// the state of a bulk load
+
+  /// the nodes from the root to the right-most leaf (empty if not known)
+  /// and the smallest key that belongs to that leaf, so that ascending
+  /// inserts append to the leaf directly
+  std::vector<PageId> rightPath;
+  int      rightLowKey;
+  /// Note that the content of the above variables will be gone when
+  /// this class is destructed. Make sure to store the values of the
   /// variables in disk, so that they can be reconstructed when the index
   /// is opened again later.
 };
@@ -13,7 +13,212 @@ using namespace std;
 
 BTLeafNode::BTLeafNode()
 {
-	fill(buffer, buffer + PageFile::PAGE_SIZE, 0);
+	valueSize = 0;
+	compressed = false;
+	nodeSize = PageFile::PAGE_SIZE;
+	fill(buffer, buffer + nodeSize, 0);
+}
+
+/*
+ * Constructor for Leaf Nodes of a covering index
+ * Every entry additionally stores the first valueSize bytes of the value
+ */
+
+BTLeafNode::BTLeafNode(int valueSize)
+{
+	this->valueSize = valueSize;
+	compressed = false;
+	nodeSize = PageFile::PAGE_SIZE;
+	fill(buffer, buffer + nodeSize, 0);
+}
+
+/*
+ * Constructor for Leaf Nodes that are stored compressed on disk
+ * The buffer holds the decoded node: up to COMPRESSED_MAX_KEYS plain
+ * (key, rid) entries followed by the sibling pointers
+ */
+
+BTLeafNode::BTLeafNode(int valueSize, bool compressed)
+{
+	this->valueSize = valueSize;
+	this->compressed = compressed && valueSize == 0;
+	nodeSize = this->compressed ? COMPRESSED_NODE_SIZE : PageFile::PAGE_SIZE;
+	memset(buffer, 0, nodeSize);
+}
+
+/*
+ * The layout of a compressed leaf page:
+ *   |# entries|prev pid|next pid|first key|base pid|key bits|pid bits|sid bits|pad|
+ * followed by a bit stream with, for every entry, the difference of its
+ * key to the key before (not for the first entry), its pid - base pid and
+ * its sid, each in the given number of bits (low bits first).
+ */
+static const int PACKED_HEADER_SIZE = 5*sizeof(int) + 4;
+
+/*
+ * The number of bits needed to store x.
+ */
+static int bitWidth(unsigned int x)
+{
+	int bits = 0;
+	while(x) { bits++; x >>= 1; }
+	return bits;
+}
+
+/*
+ * The bit widths and the base pid for packing the count entries of 12
+ * bytes in entries, and the size of the packed page.
+ */
+static int packedSize(const char* entries, int count, int& keyBits, int& pidBits, int& sidBits, PageId& basePid)
+{
+	const int groupSize = sizeof(int) + sizeof(RecordId);
+	unsigned int maxDelta = 0, maxSid = 0;
+	PageId maxPid = 0;
+	int prevKey = 0;
+	basePid = 0;
+	for(int i=0; i<count; i++)
+	{
+		int key;
+		RecordId rid;
+		memcpy(&key, entries + i*groupSize, sizeof(int));
+		memcpy(&rid, entries + i*groupSize + sizeof(int), sizeof(RecordId));
+		if(i > 0) maxDelta = max(maxDelta, (unsigned int)key - (unsigned int)prevKey);
+		if(i == 0 || rid.pid < basePid) basePid = rid.pid;
+		if(i == 0 || rid.pid > maxPid) maxPid = rid.pid;
+		maxSid = max(maxSid, (unsigned int)rid.sid);
+		prevKey = key;
+	}
+	keyBits = bitWidth(maxDelta);
+	pidBits = bitWidth((unsigned int)(maxPid - basePid));
+	sidBits = bitWidth(maxSid);
+	if(count == 0) return PACKED_HEADER_SIZE;
+	return PACKED_HEADER_SIZE + ((count-1)*keyBits + count*(pidBits+sidBits) + 7)/8;
+}
+
+/*
+ * Append the low bits of v to the bit stream out at bit position pos.
+ */
+static void putBits(unsigned char* out, int& pos, unsigned int v, int bits)
+{
+	for(int i=0; i<bits; )
+	{
+		int shift = pos & 7;
+		int n = min(8 - shift, bits - i);
+		out[pos >> 3] |= ((v >> i) & ((1u << n) - 1)) << shift;
+		i += n;
+		pos += n;
+	}
+}
+
+/*
+ * Read bits bits from the bit stream in at bit position pos.
+ * The bytes holding them are gathered into one word and shifted out at once.
+ */
+static unsigned int getBits(const unsigned char* in, int& pos, int bits)
+{
+	if(bits == 0) return 0;
+	int first = pos >> 3;
+	int shift = pos & 7;
+	unsigned long long word = 0;
+	for(int i=0; i < (shift + bits + 7)/8; i++)
+		word |= (unsigned long long)in[first + i] << (8*i);
+	pos += bits;
+	return (unsigned int)((word >> shift) & ((1ull << bits) - 1));
+}
+
+/*
+ * Encode the node into the disk page page.
+ * @return 0 if successful, RC_NODE_FULL if the entries do not fit
+ */
+RC BTLeafNode::pack(char* page)
+{
+	const int groupSize = sizeof(int) + sizeof(RecordId);
+	int count = getKeyCount();
+	int keyBits, pidBits, sidBits;
+	PageId basePid;
+	if(packedSize(buffer, count, keyBits, pidBits, sidBits, basePid) > PageFile::PAGE_SIZE) return RC_NODE_FULL;
+
+	memset(page, 0, PageFile::PAGE_SIZE);
+	PageId prevPid = getPrevNodePtr(), nextPid = getNextNodePtr();
+	int firstKey = 0;
+	if(count > 0) memcpy(&firstKey, buffer, sizeof(int));
+	memcpy(page, &count, sizeof(int));
+	memcpy(page + sizeof(int), &prevPid, sizeof(PageId));
+	memcpy(page + 2*sizeof(int), &nextPid, sizeof(PageId));
+	memcpy(page + 3*sizeof(int), &firstKey, sizeof(int));
+	memcpy(page + 4*sizeof(int), &basePid, sizeof(PageId));
+	page[5*sizeof(int)] = keyBits;
+	page[5*sizeof(int)+1] = pidBits;
+	page[5*sizeof(int)+2] = sidBits;
+
+	unsigned char* bits = (unsigned char*)page + PACKED_HEADER_SIZE;
+	int pos = 0, prevKey = firstKey;
+	for(int i=0; i<count; i++)
+	{
+		int key;
+		RecordId rid;
+		memcpy(&key, buffer + i*groupSize, sizeof(int));
+		memcpy(&rid, buffer + i*groupSize + sizeof(int), sizeof(RecordId));
+		if(i > 0) putBits(bits, pos, (unsigned int)key - (unsigned int)prevKey, keyBits);
+		putBits(bits, pos, (unsigned int)(rid.pid - basePid), pidBits);
+		putBits(bits, pos, (unsigned int)rid.sid, sidBits);
+		prevKey = key;
+	}
+	return 0;
+}
+
+/*
+ * The last page decoded by unpack() and its decoded content. A scan
+ * decodes the same leaf once for every entry it reads from it.
+ */
+static bool unpackedValid = false;
+static char unpackedPage[PageFile::PAGE_SIZE];
+static char unpackedNode[BTLeafNode::COMPRESSED_NODE_SIZE];
+
+/*
+ * Decode the disk page page into the node.
+ */
+void BTLeafNode::unpack(const char* page)
+{
+	if(unpackedValid && memcmp(page, unpackedPage, PageFile::PAGE_SIZE)==0)
+	{
+		memcpy(buffer, unpackedNode, nodeSize);
+		return;
+	}
+
+	const int groupSize = sizeof(int) + sizeof(RecordId);
+	int count, firstKey;
+	PageId prevPid, nextPid, basePid;
+	memcpy(&count, page, sizeof(int));
+	memcpy(&prevPid, page + sizeof(int), sizeof(PageId));
+	memcpy(&nextPid, page + 2*sizeof(int), sizeof(PageId));
+	memcpy(&firstKey, page + 3*sizeof(int), sizeof(int));
+	memcpy(&basePid, page + 4*sizeof(int), sizeof(PageId));
+	int keyBits = page[5*sizeof(int)];
+	int pidBits = page[5*sizeof(int)+1];
+	int sidBits = page[5*sizeof(int)+2];
+	if(count < 0 || count > COMPRESSED_MAX_KEYS) count = 0; // not a compressed leaf
+
+	memset(buffer, 0, nodeSize);
+	const unsigned char* bits = (const unsigned char*)page + PACKED_HEADER_SIZE;
+	int pos = 0;
+	unsigned int key = firstKey;
+	for(int i=0; i<count; i++)
+	{
+		RecordId rid;
+		if(i > 0) key += getBits(bits, pos, keyBits);
+		rid.pid = basePid + getBits(bits, pos, pidBits);
+		rid.sid = getBits(bits, pos, sidBits);
+		int storedKey = key;
+		memcpy(buffer + i*groupSize, &storedKey, sizeof(int));
+		memcpy(buffer + i*groupSize + sizeof(int), &rid, sizeof(RecordId));
+	}
+	setPrevNodePtr(prevPid);
+	setNextNodePtr(nextPid);
+
+	memcpy(unpackedPage, page, PageFile::PAGE_SIZE);
+	memcpy(unpackedNode, buffer, nodeSize);
+	unpackedValid = true;
 }
 
 /*
@@ -27,7 +232,13 @@ RC BTLeafNode::read(PageId pid, const PageFile& pf)
 	/* read function in PageFile loads the disk page with given pid into memory buffer */
 	/* buffer is declared as char array of size = PAGE_SIZE (1024 bytes) */
 	/* 1 Page = 1 Node */
-	return pf.read(pid,buffer); 
+	if(!compressed) return pf.read(pid,buffer); 
+
+	char page[PageFile::PAGE_SIZE];
+	RC error = pf.read(pid, page);
+	if(error!=0) return error;
+	unpack(page);
+	return 0;
 }
     
 /*
@@ -39,7 +250,12 @@ RC BTLeafNode::read(PageId pid, const PageFile& pf)
 RC BTLeafNode::write(PageId pid, PageFile& pf)
 { 
 	/* same as read - just that it loads memory buffer into disk page now*/
-	return pf.write(pid,buffer);
+	if(!compressed) return pf.write(pid,buffer);
+
+	char page[PageFile::PAGE_SIZE];
+	RC error = pack(page);
+	if(error!=0) return error;
+	return pf.write(pid, page);
 }
 
 /*
@@ -48,20 +264,20 @@ RC BTLeafNode::write(PageId pid, PageFile& pf)
  */
 int BTLeafNode::getKeyCount()
 { 
-	int keyCount = 0;
-	char* temp = buffer;
-	const int groupSize = sizeof(int) + sizeof(RecordId); // 4+(4+4) = 12 bytes
-	int limit = PageFile::PAGE_SIZE - sizeof(PageId) - groupSize;
-	//int maxKeys = (PageFile::PAGE_SIZE - sizeof(PageId))/groupSize;
-	for(int i=0;i<=limit;i=i+groupSize)
+	const int groupSize = sizeof(int) + sizeof(RecordId) + valueSize; // 4+(4+4) = 12 bytes + value prefix
+	int maxKeys = (nodeSize - 2*sizeof(PageId))/groupSize;
+
+	// the used slots come first: binary search for the first empty one
+	int lo = 0, hi = maxKeys;
+	while(lo < hi)
 	{
+		int mid = (lo + hi)/2;
 		int storedKey;
-		memcpy(&storedKey,temp,sizeof(int));
-		if(storedKey==0) break;
-		else keyCount++;
-		temp = temp + groupSize;
+		memcpy(&storedKey, buffer + mid*groupSize, sizeof(int));
+		if(storedKey==0) hi = mid;
+		else lo = mid + 1;
 	}
-	return keyCount;
+	return lo;
 	
 /*  Note: We can also maintain a variable to store this information about number of keys.
 	With each insertion, we increment this variable and simply return it in this function.
@@ -69,6 +285,16 @@ int BTLeafNode::getKeyCount()
 
 }
 
+/*
+ * Return the number of keys the node has room for.
+ * @return the max number of keys in the node
+ */
+int BTLeafNode::getMaxKeyCount()
+{
+	const int groupSize = sizeof(int) + sizeof(RecordId) + valueSize; // key + (4+4) bytes + value prefix
+	return (nodeSize - 2*sizeof(PageId))/groupSize;
+}
+
 /*
  * Insert a (key, rid) pair to the node.
  * @param key[IN] the key to insert
@@ -76,12 +302,25 @@ int BTLeafNode::getKeyCount()
  * @return 0 if successful. Return an error code if the node is full.
  */
 RC BTLeafNode::insert(int key, const RecordId& rid)
+{
+	return insert(key, rid, "");
+}
+
+/*
+ * Insert a (key, rid) pair together with the value prefix to the node.
+ * @param key[IN] the key to insert
+ * @param rid[IN] the RecordId to insert
+ * @param value[IN] the value of the record (only the first valueSize bytes are kept)
+ * @return 0 if successful. Return an error code if the node is full.
+ */
+RC BTLeafNode::insert(int key, const RecordId& rid, const string& value)
 { 
-	const int groupSize = sizeof(int) + sizeof(RecordId); // 4+(4+4) = 12 bytes
-	int maxKeys = (PageFile::PAGE_SIZE - sizeof(PageId))/groupSize;
+	const int groupSize = sizeof(int) + sizeof(RecordId) + valueSize; // 4+(4+4) = 12 bytes + value prefix
+	int maxKeys = (nodeSize - 2*sizeof(PageId))/groupSize;
 	int totalKeys = getKeyCount();
 	PageId nextpointer = getNextNodePtr();	
-	int limit = PageFile::PAGE_SIZE - sizeof(PageId) - groupSize;
+	PageId prevpointer = getPrevNodePtr();
+	int limit = nodeSize - 2*sizeof(PageId) - groupSize;
 	char* temp=buffer;
 	if(totalKeys!=maxKeys)
 	{
@@ -92,8 +331,8 @@ RC BTLeafNode::insert(int key, const RecordId& rid)
 			if(storedKey==0 || key<=storedKey) break;
 			temp = temp + groupSize;
 		}
-		char* temp1 = (char*)malloc(PageFile::PAGE_SIZE);
-		fill(temp1, temp1 + PageFile::PAGE_SIZE, 0); //clear temp1
+		char* temp1 = (char*)malloc(nodeSize);
+		fill(temp1, temp1 + nodeSize, 0); //clear temp1
 
 		memcpy(temp1, buffer, i);
 		//transfer first i keygroups in temp to temp1
@@ -101,14 +340,26 @@ RC BTLeafNode::insert(int key, const RecordId& rid)
 		//transfer key to temp1 after i keygroups
 		memcpy(temp1 + i + sizeof(int), &rid, sizeof(RecordId)); 
 		//transfer rid to temp1
+		memcpy(temp1 + i + sizeof(int) + sizeof(RecordId), value.c_str(), min((int)value.size(), valueSize));
+		//transfer value prefix to temp1 (NUL-terminated unless it was truncated)
 
 		memcpy(temp1+groupSize+i, buffer+i, totalKeys*groupSize - i);
 
-		memcpy(temp1+PageFile::PAGE_SIZE-sizeof(PageId), &nextpointer, sizeof(PageId));
+		memcpy(temp1+nodeSize-sizeof(PageId), &nextpointer, sizeof(PageId));
+		memcpy(temp1+nodeSize-2*sizeof(PageId), &prevpointer, sizeof(PageId));
+
+		// transfer everything else which was not transferred (including pageids of siblings)
 
-		// transfer everything else which was not transferred (including pageid of sibling)
+		// a compressed node is full when its entries no longer pack into a page
+		int keyBits, pidBits, sidBits;
+		PageId basePid;
+		if(compressed && packedSize(temp1, totalKeys+1, keyBits, pidBits, sidBits, basePid) > PageFile::PAGE_SIZE)
+		{
+			free(temp1);
+			return RC_NODE_FULL;
+		}
 
-		memcpy(buffer,temp1,PageFile::PAGE_SIZE); 
+		memcpy(buffer,temp1,nodeSize); 
 
 		// Buffer updated
 		
@@ -132,6 +383,21 @@ RC BTLeafNode::insert(int key, const RecordId& rid)
  * @return 0 if successful. Return an error code if there is an error.
  */
 RC BTLeafNode::insertAndSplit(int key, const RecordId& rid, BTLeafNode& sibling, int& siblingKey)
+{
+	return insertAndSplit(key, rid, "", sibling, siblingKey);
+}
+
+/*
+ * Insert the (key, rid) pair together with the value prefix to the node
+ * and split the node half and half with sibling.
+ * @param key[IN] the key to insert.
+ * @param rid[IN] the RecordId to insert.
+ * @param value[IN] the value of the record (only the first valueSize bytes are kept)
+ * @param sibling[IN] the sibling node to split with. This node MUST be EMPTY when this function is called.
+ * @param siblingKey[OUT] the first key in the sibling node after split.
+ * @return 0 if successful. Return an error code if there is an error.
+ */
+RC BTLeafNode::insertAndSplit(int key, const RecordId& rid, const string& value, BTLeafNode& sibling, int& siblingKey)
 { 
 	if(sibling.getKeyCount()>0) 
 		{
@@ -140,20 +406,27 @@ RC BTLeafNode::insertAndSplit(int key, const RecordId& rid, BTLeafNode& sibling,
 		}
 	// check that the sibling is empty
 
-	const int groupSize = sizeof(int) + sizeof(RecordId); // 4+(4+4) = 12 bytes
-	int maxKeys = (PageFile::PAGE_SIZE - sizeof(PageId))/groupSize;
+	const int groupSize = sizeof(int) + sizeof(RecordId) + valueSize; // 4+(4+4) = 12 bytes + value prefix
+	int maxKeys = (nodeSize - 2*sizeof(PageId))/groupSize;
 	int totalKeys=0;
 
-	if((totalKeys=getKeyCount()+1)<=maxKeys) return RC_NODE_FULL;
+	if((totalKeys=getKeyCount()+1)<=maxKeys && !compressed) return RC_NODE_FULL;
 	// split only if this node cannot accommodate one more group
+	// (a compressed node may be full in bytes before it is full in entries)
 
 	// start splitting now - divide the keys into half
 	int temptotalkeys = getKeyCount();
 	int firstHalf = ceil(temptotalkeys/2.0);
 	// get half keys
 
-	memcpy(sibling.buffer, buffer+firstHalf*groupSize, PageFile::PAGE_SIZE-sizeof(PageId)-firstHalf*groupSize);
-	// store the remaining half keys to sibling's buffer
+	// on the right edge of the tree a key above all others starts a new node
+	// and this one stays full, so ascending inserts fill every leaf
+	int lastKey;
+	memcpy(&lastKey, buffer+(temptotalkeys-1)*groupSize, sizeof(int));
+	if(getNextNodePtr()==0 && key>lastKey) firstHalf = temptotalkeys;
+
+	memcpy(sibling.buffer, buffer+firstHalf*groupSize, (temptotalkeys-firstHalf)*groupSize);
+	// store the remaining half keys to sibling's buffer (sibling pointers are set below)
 
 	sibling.setNextNodePtr(getNextNodePtr());
 	// sibling's sibling updated to be the next node of current node
@@ -161,26 +434,42 @@ RC BTLeafNode::insertAndSplit(int key, const RecordId& rid, BTLeafNode& sibling,
 	memcpy(&siblingKey, sibling.buffer, sizeof(int));
 	// update siblingKey as first key of sibling node
 
-	fill(buffer+firstHalf*groupSize, buffer + PageFile::PAGE_SIZE - sizeof(PageId), 0);
-	// prepare buffer of current node by clearing out other keys and pid info
+	fill(buffer+firstHalf*groupSize, buffer + nodeSize - 2*sizeof(PageId), 0);
+	// prepare buffer of current node by clearing out the moved keys (sibling pointers are kept)
 
 	int tempKey;
 	memcpy(&tempKey, sibling.buffer, sizeof(int));
 	// get first key of sibling to check if the keygroup goes into this node or not
 
-	if(key<tempKey) // keygroup goes into current buffer
+	if(firstHalf<temptotalkeys && key<tempKey) // keygroup goes into current buffer
 	{
-		insert(key, rid);
+		insert(key, rid, value);
 	}
 	else // keygroup goes into sibling buffer
 	{
-		sibling.insert(key, rid);
+		sibling.insert(key, rid, value);
 		memcpy(&siblingKey, sibling.buffer, sizeof(int)); //needs to be updated again
 	}
 	
 	return 0; 
 }
 
+/*
+ * Remove the eid entry from the node.
+ * @param eid[IN] the entry number to remove
+ * @return 0 if successful. Return an error code if there is an error.
+ */
+RC BTLeafNode::remove(int eid)
+{
+	const int groupSize = sizeof(int) + sizeof(RecordId) + valueSize; // 4+(4+4) = 12 bytes + value prefix
+	int tempkeys = getKeyCount();
+	if(eid < 0 || eid >= tempkeys) return RC_INVALID_CURSOR;
+
+	memmove(buffer + eid*groupSize, buffer + (eid+1)*groupSize, (tempkeys-eid-1)*groupSize);
+	fill(buffer + (tempkeys-1)*groupSize, buffer + tempkeys*groupSize, 0);
+	return 0;
+}
+
 /**
  * If searchKey exists in the node, set eid to the index entry
  * with searchKey and return 0. If not, set eid to the index entry
@@ -194,7 +483,7 @@ RC BTLeafNode::insertAndSplit(int key, const RecordId& rid, BTLeafNode& sibling,
  */
 RC BTLeafNode::locate(int searchKey, int& eid)
 { 
-	const int groupSize = sizeof(int) + sizeof(RecordId); // 4+(4+4) = 12 bytes
+	const int groupSize = sizeof(int) + sizeof(RecordId) + valueSize; // 4+(4+4) = 12 bytes + value prefix
 	char* temp = buffer;
 	int storedKey;
 	int tempkeys = getKeyCount();
@@ -229,7 +518,7 @@ RC BTLeafNode::locate(int searchKey, int& eid)
  */
 RC BTLeafNode::readEntry(int eid, int& key, RecordId& rid)
 { 
-	const int groupSize = sizeof(int) + sizeof(RecordId); // 4+(4+4) = 12 bytes
+	const int groupSize = sizeof(int) + sizeof(RecordId) + valueSize; // 4+(4+4) = 12 bytes + value prefix
 	int tempkeys = getKeyCount();
 	if(eid < 0 || eid >= tempkeys) return RC_INVALID_CURSOR; 
 	else
@@ -242,6 +531,25 @@ RC BTLeafNode::readEntry(int eid, int& key, RecordId& rid)
 	}
 }
 
+/*
+ * Read the value prefix stored with the eid entry.
+ * @param eid[IN] the entry number to read the value from
+ * @param value[OUT] the stored value (prefix)
+ * @return 0 if the complete value is stored in the entry,
+ *         RC_VALUE_TRUNCATED if only a prefix of it is stored.
+ */
+RC BTLeafNode::readValue(int eid, string& value)
+{
+	const int groupSize = sizeof(int) + sizeof(RecordId) + valueSize;
+	if(eid < 0 || eid >= getKeyCount()) return RC_INVALID_CURSOR;
+	if(valueSize == 0) { value.erase(); return RC_VALUE_TRUNCATED; }
+
+	char* temp = buffer + eid*groupSize + sizeof(int) + sizeof(RecordId);
+	int length = strnlen(temp, valueSize);
+	value.assign(temp, length);
+	return (length < valueSize) ? 0 : RC_VALUE_TRUNCATED;
+}
+
 /*
  * Return the pid of the next slibling node.
  * @return the PageId of the next sibling node 
@@ -251,7 +559,7 @@ PageId BTLeafNode::getNextNodePtr()
 	char* temp = buffer;
 	PageId pid;
 	int pidsize = sizeof(PageId);
-	memcpy(&pid, temp+PageFile::PAGE_SIZE-pidsize, pidsize);
+	memcpy(&pid, temp+nodeSize-pidsize, pidsize);
 	//cout<<"Pid returned = "<<pid;
 	return pid; 
 }
@@ -266,14 +574,41 @@ RC BTLeafNode::setNextNodePtr(PageId pid)
 	if(pid < 0)	return RC_INVALID_PID;
 	char* temp = buffer;
 	int pidsize = sizeof(PageId);
-	memcpy(temp+PageFile::PAGE_SIZE-pidsize, &pid, pidsize);
+	memcpy(temp+nodeSize-pidsize, &pid, pidsize);
+	return 0; 
+}
+
+/*
+ * Return the pid of the previous slibling node.
+ * @return the PageId of the previous sibling node (0 for the left-most leaf)
+ */
+PageId BTLeafNode::getPrevNodePtr()
+{ 
+	char* temp = buffer;
+	PageId pid;
+	int pidsize = sizeof(PageId);
+	memcpy(&pid, temp+nodeSize-2*pidsize, pidsize);
+	return pid; 
+}
+
+/*
+ * Set the pid of the previous slibling node.
+ * @param pid[IN] the PageId of the previous sibling node 
+ * @return 0 if successful. Return an error code if there is an error.
+ */
+RC BTLeafNode::setPrevNodePtr(PageId pid)
+{ 
+	if(pid < 0)	return RC_INVALID_PID;
+	char* temp = buffer;
+	int pidsize = sizeof(PageId);
+	memcpy(temp+nodeSize-2*pidsize, &pid, pidsize);
 	return 0; 
 }
 
 // print function for testing
 void BTLeafNode::printLeaf()
 {
-	const int groupSize = 12;
+	const int groupSize = sizeof(int) + sizeof(RecordId) + valueSize;
 	int storedKey;
 	char* temp = buffer;
 	int tempkeys = getKeyCount();
@@ -324,22 +659,25 @@ RC BTNonLeafNode::write(PageId pid, PageFile& pf)
 	return pf.write(pid, buffer); 
 }
 
+/* Node format:	|PageId|Count|Key|PageId|Count|Key|PageId|Count|.....|Key|PageId|Count|
+
+   Count is the number of (key, rid) entries stored in the subtree under the
+   PageId in front of it. Child j (j = 0..keyCount) therefore starts at
+   offset 12*j and key j (j = 1..keyCount) lives at offset 12*j - 4.
+*/
+
 /*
  * Return the number of keys stored in the node.
  * @return the number of keys in the node
  */
-
-/* Node format:	|PageId|(blank 4 bytes)|Key|PageId|Key|PageId|.....|Key|PageId|
-*/
-
 int BTNonLeafNode::getKeyCount()
 { 
 	int keyCount = 0;
-	char* temp = buffer+8; //skip first 8 bytes (pid + empty)
-	const int groupSize = sizeof(int) + sizeof(PageId); // 4+4 = 8 bytes
+	const int groupSize = sizeof(int) + sizeof(PageId) + sizeof(int); // 4+4+4 = 12 bytes
+	int maxKeys = (PageFile::PAGE_SIZE - sizeof(PageId) - sizeof(int))/groupSize;
+	char* temp = buffer + sizeof(PageId) + sizeof(int); //skip first 8 bytes (pid + count)
 	int storedKey;
-	//int maxKeys = (PageFile::PAGE_SIZE - sizeof(PageId))/groupSize;
-	for(int i=groupSize; i<=PageFile::PAGE_SIZE - groupSize; i=i+groupSize) //8, 1016
+	for(int i=0; i<maxKeys; i++)
 	{
 		memcpy(&storedKey, temp, sizeof(int));
 		if(storedKey!=0) keyCount++;
@@ -355,110 +693,163 @@ int BTNonLeafNode::getKeyCount()
  * Insert a (key, pid) pair to the node.
  * @param key[IN] the key to insert
  * @param pid[IN] the PageId to insert
+ * @param count[IN] the number of entries in the subtree under pid
+ * @return 0 if successful. Return an error code if the node is full.
+ */
+RC BTNonLeafNode::insert(int key, PageId pid, int count)
+{ 
+	return insert(key, pid, count, insertPosition(key) - 1);
+}
+
+/*
+ * Insert a (key, pid) pair to the node, pid as the child right behind
+ * child childIdx.
+ * @param key[IN] the key to insert
+ * @param pid[IN] the PageId to insert
+ * @param count[IN] the number of entries in the subtree under pid
+ * @param childIdx[IN] the position of the child pid was split from
  * @return 0 if successful. Return an error code if the node is full.
  */
-RC BTNonLeafNode::insert(int key, PageId pid)
+RC BTNonLeafNode::insert(int key, PageId pid, int count, int childIdx)
 { 
-	int groupSize = sizeof(int) + sizeof(PageId); //8 bytes
-	int maxKeys = (PageFile::PAGE_SIZE - sizeof(PageId))/groupSize;
-	int limit = PageFile::PAGE_SIZE - groupSize;
+	const int groupSize = sizeof(int) + sizeof(PageId) + sizeof(int); //12 bytes
+	int maxKeys = (PageFile::PAGE_SIZE - sizeof(PageId) - sizeof(int))/groupSize;
 	int tempkeys = getKeyCount();
-	//cout<<"Total Keys here = "<<tempkeys<<endl;
 	if(tempkeys==maxKeys) return RC_NODE_FULL;
-	else
-		{
-			char* temp = buffer + groupSize;
-			int storedKey, i=8; // we know i should be 8
-			for(i=groupSize; i<=limit; i=i+groupSize)
-			{
-				memcpy(&storedKey, temp, sizeof(int));
-				if(storedKey==0) break;
-				if(key<=storedKey) break;
-				temp = temp + groupSize;
-			}
-			char* temp1 = (char*)malloc(PageFile::PAGE_SIZE);
-			fill(temp1, temp1 + PageFile::PAGE_SIZE, 0); //clear temp1
-			memcpy(temp1, buffer, i);
-			memcpy(temp1+i, &key, sizeof(int));
-			memcpy(temp1+i+sizeof(int), &pid, sizeof(PageId));
-			memcpy(temp1+groupSize+i, buffer+i, (tempkeys+1)*groupSize - i);
-			memcpy(buffer, temp1, PageFile::PAGE_SIZE);
-		}
+
+	// the new key goes to position j; keys j.. move one group to the right
+	int j = childIdx + 1;
+
+	char* pos = buffer + j*groupSize - sizeof(int);
+	char* end = buffer + (tempkeys+1)*groupSize - sizeof(int); // end of the last count
+	memmove(pos + groupSize, pos, end - pos);
+	memcpy(pos, &key, sizeof(int));
+	memcpy(pos + sizeof(int), &pid, sizeof(PageId));
+	memcpy(pos + sizeof(int) + sizeof(PageId), &count, sizeof(int));
 
 	return 0; 
 }
 
+/*
+ * @return the position (1..keyCount+1) a new key goes to when only the key
+ *         is known: in front of the first stored key >= key
+ */
+int BTNonLeafNode::insertPosition(int key)
+{
+	const int groupSize = sizeof(int) + sizeof(PageId) + sizeof(int);
+	int tempkeys = getKeyCount();
+	int j, storedKey;
+	for(j=1; j<=tempkeys; j++)
+	{
+		memcpy(&storedKey, buffer + j*groupSize - sizeof(int), sizeof(int));
+		if(key<=storedKey) break;
+	}
+	return j;
+}
+
 /*
  * Insert the (key, pid) pair to the node
  * and split the node half and half with sibling.
  * The middle key after the split is returned in midKey.
  * @param key[IN] the key to insert
  * @param pid[IN] the PageId to insert
+ * @param count[IN] the number of entries in the subtree under pid
  * @param sibling[IN] the sibling node to split with. This node MUST be empty when this function is called.
  * @param midKey[OUT] the key in the middle after the split. This key should be inserted to the parent node.
  * @return 0 if successful. Return an error code if there is an error.
  */
-RC BTNonLeafNode::insertAndSplit(int key, PageId pid, BTNonLeafNode& sibling, int& midKey)
-{ 
-	/* 
-	Node Format:
-	
-	|PageId|Blank(4 bytes)|Key|PageId|...|Key|PageId| */
+RC BTNonLeafNode::insertAndSplit(int key, PageId pid, int count, BTNonLeafNode& sibling, int& midKey)
+{
+	return insertAndSplit(key, pid, count, sibling, midKey, false);
+}
+
+/*
+ * Insert the (key, pid) pair to the node and split it with sibling. On the
+ * right edge of the tree a key above all others leaves this node full and
+ * only the last two children to the sibling, instead of half of them.
+ * @param key[IN] the key to insert
+ * @param pid[IN] the PageId to insert
+ * @param count[IN] the number of entries in the subtree under pid
+ * @param sibling[IN] the sibling node to split with. This node MUST be empty when this function is called.
+ * @param midKey[OUT] the key in the middle after the split. This key should be inserted to the parent node.
+ * @param rightEdge[IN] true if the node is the right-most one on its level
+ * @return 0 if successful. Return an error code if there is an error.
+ */
+RC BTNonLeafNode::insertAndSplit(int key, PageId pid, int count, BTNonLeafNode& sibling, int& midKey, bool rightEdge)
+{
+	return insertAndSplit(key, pid, count, insertPosition(key) - 1, sibling, midKey, rightEdge);
+}
 
+/*
+ * Same as above, with pid going right behind child childIdx, the child it
+ * was split from. Separators of duplicate keys are equal, so only the
+ * position of the child keeps the leaves in order.
+ */
+RC BTNonLeafNode::insertAndSplit(int key, PageId pid, int count, int childIdx, BTNonLeafNode& sibling, int& midKey, bool rightEdge)
+{ 
 	// Check that the sibling node is empty
 	if(sibling.getKeyCount()!=0) return RC_INVALID_ATTRIBUTE;
 
-	int groupSize = sizeof(PageId) + sizeof(int);
-	int maxKeys = (PageFile::PAGE_SIZE-sizeof(PageId))/groupSize;
+	const int groupSize = sizeof(int) + sizeof(PageId) + sizeof(int);
+	const int maxKeys = (PageFile::PAGE_SIZE - sizeof(PageId) - sizeof(int))/groupSize;
 	int tempkeys = getKeyCount();
 	
 	// Check if we need to actually split (i.e. check if insertion leads to overflow)
 	if(!(tempkeys >= maxKeys)) return RC_INVALID_FILE_FORMAT;
-	
-	// Clear sibling buffer
-	fill(sibling.buffer, sibling.buffer + PageFile::PAGE_SIZE, 0);
 
-	// Calculate keys to remain in the first half
-	int numHalfKeys = ceil(tempkeys/2.0);
-	int halfIndex = numHalfKeys*groupSize + groupSize; // initial offset of 8
-	
-	//REMOVING THE MEDIAN KEY
-	
-	int keyFH, keySH;
-	memcpy(&keyFH, buffer+halfIndex-groupSize, sizeof(int)); // last key of fh
-	memcpy(&keySH, buffer+halfIndex, sizeof(int)); // first key of sh
-	
-	if(key > keySH) // then keySH = median
-	{
-		memcpy(sibling.buffer+8, buffer+halfIndex+8, PageFile::PAGE_SIZE-halfIndex-8);
-		memcpy(&midKey, buffer+halfIndex, sizeof(int));
-		memcpy(sibling.buffer, buffer+halfIndex+4, sizeof(PageId));
-		fill(buffer+halfIndex, buffer + PageFile::PAGE_SIZE, 0);
+	// Lay out all keys and children (including the new pair) side by side
+	int keys[maxKeys+1];
+	PageId pids[maxKeys+2];
+	int counts[maxKeys+2];
 
-		// Insert new key and pid into buffer of sibling's node 
-		sibling.insert(key, pid);
-		
+	pids[0] = getChildPtr(0);
+	counts[0] = getChildCount(0);
+	int n = 0;
+	bool inserted = false;
+	for(int j=1; j<=tempkeys; j++)
+	{
+		int storedKey;
+		memcpy(&storedKey, buffer + j*groupSize - sizeof(int), sizeof(int));
+		if(!inserted && j==childIdx+1)
+		{
+			n++;
+			keys[n-1] = key; pids[n] = pid; counts[n] = count;
+			inserted = true;
+		}
+		n++;
+		keys[n-1] = storedKey; pids[n] = getChildPtr(j); counts[n] = getChildCount(j);
 	}
-
-	else if(key < keyFH) // then keyFH = median
+	if(!inserted)
 	{
-		memcpy(sibling.buffer+groupSize, buffer+halfIndex, PageFile::PAGE_SIZE-halfIndex);
-		memcpy(&midKey, buffer+halfIndex-8, sizeof(int));
-		memcpy(sibling.buffer, buffer+halfIndex-4, sizeof(PageId));
-		fill(buffer+halfIndex-groupSize, buffer + PageFile::PAGE_SIZE, 0); 
-		
-		// Insert new key and pid into buffer of current node
-		insert(key, pid);		
+		n++;
+		keys[n-1] = key; pids[n] = pid; counts[n] = count;
 	}
-	
-	else // then key = median
+
+	// keys[0..half-1] stay, keys[half] moves up, keys[half+1..n-1] go to the sibling
+	int half = (rightEdge && keys[n-1]==key) ? n-2 : n/2;
+	midKey = keys[half];
+
+	fill(buffer, buffer + PageFile::PAGE_SIZE, 0);
+	fill(sibling.buffer, sibling.buffer + PageFile::PAGE_SIZE, 0);
+
+	memcpy(buffer, &pids[0], sizeof(PageId));
+	memcpy(buffer + sizeof(PageId), &counts[0], sizeof(int));
+	for(int j=1; j<=half; j++)
 	{
-		memcpy(sibling.buffer+groupSize, buffer+halfIndex, PageFile::PAGE_SIZE-halfIndex);
-		fill(buffer+halfIndex, buffer + PageFile::PAGE_SIZE, 0); 
-		midKey = key;
-		memcpy(sibling.buffer, &pid, sizeof(PageId));
+		char* pos = buffer + j*groupSize - sizeof(int);
+		memcpy(pos, &keys[j-1], sizeof(int));
+		memcpy(pos + sizeof(int), &pids[j], sizeof(PageId));
+		memcpy(pos + sizeof(int) + sizeof(PageId), &counts[j], sizeof(int));
+	}
 
-		// no key insertion here.
+	memcpy(sibling.buffer, &pids[half+1], sizeof(PageId));
+	memcpy(sibling.buffer + sizeof(PageId), &counts[half+1], sizeof(int));
+	for(int j=1; j<n-half; j++)
+	{
+		char* pos = sibling.buffer + j*groupSize - sizeof(int);
+		memcpy(pos, &keys[half+j], sizeof(int));
+		memcpy(pos + sizeof(int), &pids[half+1+j], sizeof(PageId));
+		memcpy(pos + sizeof(int) + sizeof(PageId), &counts[half+1+j], sizeof(int));
 	}
 	return 0;
 }
@@ -472,52 +863,322 @@ RC BTNonLeafNode::insertAndSplit(int key, PageId pid, BTNonLeafNode& sibling, in
  */
 RC BTNonLeafNode::locateChildPtr(int searchKey, PageId& pid)
 { 
-	int groupSize = sizeof(int) + sizeof(PageId);
-	char* temp = buffer + groupSize;
-	int storedKey;
-	bool check = true;
+	pid = getChildPtr(locateChildIndex(searchKey));
+	return 0;
+}
 
-	/* Node format:
-	|PageId|(blank 4 bytes)|Key|PageId|Key|PageId|.....|Key|PageId|
-	*/
+/*
+ * Given the searchKey, find the position of the child-node pointer to follow.
+ * @param searchKey[IN] the searchKey that is being looked up.
+ * @return the child position j (0..keyCount), i.e. the number of keys <= searchKey
+ */
+int BTNonLeafNode::locateChildIndex(int searchKey)
+{
+	const int groupSize = sizeof(int) + sizeof(PageId) + sizeof(int);
 	int tempkeys = getKeyCount();
-	for(int i=groupSize; i<(tempkeys+1)*groupSize; i=i+groupSize)
+	int storedKey;
+
+	//Keep checking till searchKey is less than storedKey
+	for(int j=1; j<=tempkeys; j++)
 	{
-		check = (i==groupSize);
-		memcpy(&storedKey, temp, sizeof(int));
-		if(storedKey > searchKey && check)
-		{
-			memcpy(&pid, buffer, sizeof(PageId));
-			return 0;
-		}
-		else if(storedKey>searchKey)
-		{
-			memcpy(&pid, temp-sizeof(PageId), sizeof(PageId));
-			return 0;
-		}
-		//Keep checking till searchKey is less than storedKey
-		temp = temp + groupSize; 
-		
+		memcpy(&storedKey, buffer + j*groupSize - sizeof(int), sizeof(int));
+		if(storedKey > searchKey) return j-1;
 	}
-	
+
 	// This implies that the SearchKey is greater than all keys
-	memcpy(&pid, temp-sizeof(PageId), sizeof(PageId));
+	return tempkeys;
+}
+
+/*
+ * Return the key at position j, which separates child j-1 from child j.
+ * @param j[IN] the key position (1..keyCount)
+ * @return the key
+ */
+int BTNonLeafNode::getKey(int j)
+{
+	const int groupSize = sizeof(int) + sizeof(PageId) + sizeof(int);
+	int key;
+	memcpy(&key, buffer + j*groupSize - sizeof(int), sizeof(int));
+	return key;
+}
+
+/*
+ * Return the child-node pointer at position j.
+ * @param j[IN] the child position (0..keyCount)
+ * @return the PageId of the child
+ */
+PageId BTNonLeafNode::getChildPtr(int j)
+{
+	const int groupSize = sizeof(int) + sizeof(PageId) + sizeof(int);
+	PageId pid;
+	memcpy(&pid, buffer + j*groupSize, sizeof(PageId));
+	return pid;
+}
+
+/*
+ * Return the number of entries in the subtree of the child at position j.
+ * @param j[IN] the child position (0..keyCount)
+ * @return the number of (key, rid) entries under the child
+ */
+int BTNonLeafNode::getChildCount(int j)
+{
+	const int groupSize = sizeof(int) + sizeof(PageId) + sizeof(int);
+	int count;
+	memcpy(&count, buffer + j*groupSize + sizeof(PageId), sizeof(int));
+	return count;
+}
+
+/*
+ * Set the number of entries in the subtree of the child at position j.
+ * @param j[IN] the child position (0..keyCount)
+ * @param count[IN] the number of (key, rid) entries under the child
+ * @return 0 if successful. Return an error code if there is an error.
+ */
+RC BTNonLeafNode::setChildCount(int j, int count)
+{
+	const int groupSize = sizeof(int) + sizeof(PageId) + sizeof(int);
+	if(j < 0 || j > getKeyCount()) return RC_INVALID_CURSOR;
+	memcpy(buffer + j*groupSize + sizeof(PageId), &count, sizeof(int));
 	return 0;
 }
 
+/*
+ * Return the number of entries in the whole subtree of this node.
+ * @return the sum of the child counts
+ */
+int BTNonLeafNode::getTotalCount()
+{
+	int total = 0;
+	int tempkeys = getKeyCount();
+	for(int j=0; j<=tempkeys; j++) total += getChildCount(j);
+	return total;
+}
+
 /*
  * Initialize the root node with (pid1, key, pid2).
  * @param pid1[IN] the first PageId to insert
+ * @param count1[IN] the number of entries in the subtree under pid1
  * @param key[IN] the key that should be inserted between the two PageIds
  * @param pid2[IN] the PageId to insert behind the key
+ * @param count2[IN] the number of entries in the subtree under pid2
  * @return 0 if successful. Return an error code if there is an error.
  */
-RC BTNonLeafNode::initializeRoot(PageId pid1, int key, PageId pid2)
+RC BTNonLeafNode::initializeRoot(PageId pid1, int count1, int key, PageId pid2, int count2)
 { 
 	fill(buffer, buffer + PageFile::PAGE_SIZE, 0); // set buffer to zero
 	char* temp = buffer;
 	int psize = sizeof(PageId);
 	memcpy(temp, &pid1, psize); //set pid of temp;
-	RC err = insert(key, pid2);
+	memcpy(temp + psize, &count1, sizeof(int));
+	RC err = insert(key, pid2, count2);
 	return err;
 }
+
+
+
+
+/*
+ * Offsets of the header fields of a posting page.
+ */
+static const int POSTING_NEXT  = 0;
+static const int POSTING_PREV  = sizeof(int);
+static const int POSTING_COUNT = 2*sizeof(int);
+static const int POSTING_BYTES = 3*sizeof(int);
+static const int POSTING_TAIL  = 4*sizeof(int);
+static const int POSTING_TOTAL = 5*sizeof(int);
+static const int POSTING_LAST  = 6*sizeof(int);
+
+/*
+ * Constructor for Posting Nodes
+ * Clear buffer - set buffer to 0
+ */
+BTPostingNode::BTPostingNode()
+{
+	memset(buffer, 0, PageFile::PAGE_SIZE);
+}
+
+/*
+ * Read the content of the node from the page pid in the PageFile pf.
+ * @param pid[IN] the PageId to read
+ * @param pf[IN] PageFile to read from
+ * @return 0 if successful. Return an error code if there is an error.
+ */
+RC BTPostingNode::read(PageId pid, const PageFile& pf)
+{
+	return pf.read(pid, buffer);
+}
+
+/*
+ * Write the content of the node to the page pid in the PageFile pf.
+ * @param pid[IN] the PageId to write to
+ * @param pf[IN] PageFile to write to
+ * @return 0 if successful. Return an error code if there is an error.
+ */
+RC BTPostingNode::write(PageId pid, PageFile& pf)
+{
+	return pf.write(pid, buffer);
+}
+
+/*
+ * Append rid behind the rids in the page.
+ * @param rid[IN] the RecordId to append
+ * @return 0 if successful. RC_NODE_FULL if the page has no room left,
+ *         RC_INVALID_RID if rid is smaller than the last rid in the page.
+ */
+RC BTPostingNode::append(const RecordId& rid)
+{
+	int count, bytes;
+	RecordId last;
+	memcpy(&count, buffer+POSTING_COUNT, sizeof(int));
+	memcpy(&bytes, buffer+POSTING_BYTES, sizeof(int));
+	memcpy(&last, buffer+POSTING_LAST, sizeof(RecordId));
+	if(count == 0) last.pid = 0;
+	else if(rid < last) return RC_INVALID_RID;
+
+	// the varint, 7 bits per byte (the high bit marks that more follow)
+	unsigned int v = (unsigned int)(rid.pid - last.pid)*RecordFile::RECORDS_PER_PAGE + rid.sid;
+	unsigned char varint[5];
+	int length = 0;
+	do {
+		varint[length] = v & 0x7f;
+		v >>= 7;
+		if(v) varint[length] |= 0x80;
+		length++;
+	} while(v);
+	if(HEADER_SIZE + bytes + length > PageFile::PAGE_SIZE) return RC_NODE_FULL;
+
+	memcpy(buffer + HEADER_SIZE + bytes, varint, length);
+	count++;
+	bytes += length;
+	memcpy(buffer+POSTING_COUNT, &count, sizeof(int));
+	memcpy(buffer+POSTING_BYTES, &bytes, sizeof(int));
+	memcpy(buffer+POSTING_LAST, &rid, sizeof(RecordId));
+	return 0;
+}
+
+/*
+ * Read the rid at offset and move offset to the next one.
+ * @param offset[IN/OUT] the byte offset of the rid (HEADER_SIZE for the first)
+ * @param prev[IN] the rid before it in the page (ignored for the first)
+ * @param rid[OUT] the rid
+ * @return 0 if successful. RC_END_OF_TREE if there are no more rids in the page.
+ */
+RC BTPostingNode::readEntry(int& offset, const RecordId& prev, RecordId& rid)
+{
+	int bytes;
+	memcpy(&bytes, buffer+POSTING_BYTES, sizeof(int));
+	if(offset < HEADER_SIZE || offset >= HEADER_SIZE + bytes) return RC_END_OF_TREE;
+	PageId base = (offset == HEADER_SIZE) ? 0 : prev.pid;
+
+	unsigned int v = 0;
+	int shift = 0;
+	unsigned char c;
+	do {
+		c = buffer[offset++];
+		v |= (unsigned int)(c & 0x7f) << shift;
+		shift += 7;
+	} while((c & 0x80) && offset < HEADER_SIZE + bytes);
+
+	rid.pid = base + v/RecordFile::RECORDS_PER_PAGE;
+	rid.sid = v%RecordFile::RECORDS_PER_PAGE;
+	return 0;
+}
+
+/*
+ * Return the number of rids in the page.
+ */
+int BTPostingNode::getCount()
+{
+	int count;
+	memcpy(&count, buffer+POSTING_COUNT, sizeof(int));
+	return count;
+}
+
+/*
+ * Return the byte offset behind the last rid in the page.
+ */
+int BTPostingNode::getEndOffset()
+{
+	int bytes;
+	memcpy(&bytes, buffer+POSTING_BYTES, sizeof(int));
+	return HEADER_SIZE + bytes;
+}
+
+/*
+ * Return the pid of the next page in the chain (0 if there is none).
+ */
+PageId BTPostingNode::getNextNodePtr()
+{
+	PageId pid;
+	memcpy(&pid, buffer+POSTING_NEXT, sizeof(PageId));
+	return pid;
+}
+
+/*
+ * Set the pid of the next page in the chain.
+ */
+RC BTPostingNode::setNextNodePtr(PageId pid)
+{
+	if(pid < 0) return RC_INVALID_PID;
+	memcpy(buffer+POSTING_NEXT, &pid, sizeof(PageId));
+	return 0;
+}
+
+/*
+ * Return the pid of the previous page in the chain (0 for the first).
+ */
+PageId BTPostingNode::getPrevNodePtr()
+{
+	PageId pid;
+	memcpy(&pid, buffer+POSTING_PREV, sizeof(PageId));
+	return pid;
+}
+
+/*
+ * Set the pid of the previous page in the chain.
+ */
+RC BTPostingNode::setPrevNodePtr(PageId pid)
+{
+	if(pid < 0) return RC_INVALID_PID;
+	memcpy(buffer+POSTING_PREV, &pid, sizeof(PageId));
+	return 0;
+}
+
+/*
+ * Return the pid of the last page of the chain (first page only).
+ */
+PageId BTPostingNode::getTailPtr()
+{
+	PageId pid;
+	memcpy(&pid, buffer+POSTING_TAIL, sizeof(PageId));
+	return pid;
+}
+
+/*
+ * Set the pid of the last page of the chain (first page only).
+ */
+RC BTPostingNode::setTailPtr(PageId pid)
+{
+	if(pid < 0) return RC_INVALID_PID;
+	memcpy(buffer+POSTING_TAIL, &pid, sizeof(PageId));
+	return 0;
+}
+
+/*
+ * Return the number of rids in the whole chain (first page only).
+ */
+int BTPostingNode::getTotalCount()
+{
+	int count;
+	memcpy(&count, buffer+POSTING_TOTAL, sizeof(int));
+	return count;
+}
+
+/*
+ * Set the number of rids in the whole chain (first page only).
+ */
+RC BTPostingNode::setTotalCount(int count)
+{
+	memcpy(buffer+POSTING_TOTAL, &count, sizeof(int));
+	return 0;
+}
@@ -18,12 +18,37 @@
  */
 class BTLeafNode {
   public:
+   /**
+    * The max # of entries in a compressed leaf. On a page an entry takes
+    * at most 32 + 31 + 4 bits (key delta, pid offset, sid; a sid is below
+    * RecordFile::RECORDS_PER_PAGE), so 119 entries always fit, and both
+    * halves of a split of a full node do.
+    */
+    static const int COMPRESSED_MAX_KEYS = 235;
+    static const int COMPRESSED_NODE_SIZE = COMPRESSED_MAX_KEYS*(sizeof(int) + sizeof(RecordId)) + 2*sizeof(PageId);
+
     /**
     * Constructor for Non leaf nodes
     * Initializes all variables
     */
     BTLeafNode();
 
+    /**
+    * Constructor for the leaf nodes of a covering index
+    * @param valueSize[IN] the number of value bytes stored with every entry
+    */
+    BTLeafNode(int valueSize);
+
+    /**
+    * Constructor for the leaf nodes of an index with compressed leaves:
+    * on disk the keys are stored as differences to the key before and the
+    * pids as offsets from the smallest pid in the node, bit-packed with the
+    * sids, so that a leaf holds up to COMPRESSED_MAX_KEYS entries
+    * @param valueSize[IN] the number of value bytes stored with every entry
+    * @param compressed[IN] whether the node is compressed (only if valueSize is 0)
+    */
+    BTLeafNode(int valueSize, bool compressed);
+
     /**
     * Print function for testing
     * 
@@ -39,9 +64,21 @@ class BTLeafNode {
     */
     RC insert(int key, const RecordId& rid);
 
+   /**
+    * Insert the (key, rid) pair to the node and store the first
+    * valueSize bytes of value with it.
+    * @param key[IN] the key to insert
+    * @param rid[IN] the RecordId to insert
+    * @param value[IN] the value of the record
+    * @return 0 if successful. Return an error code if the node is full.
+    */
+    RC insert(int key, const RecordId& rid, const std::string& value);
+
    /**
     * Insert the (key, rid) pair to the node
     * and split the node half and half with sibling.
+    * If the node is the right-most leaf and key is larger than all keys
+    * in it, the node stays full and key alone goes to the sibling.
     * The first key of the sibling node is returned in siblingKey.
     * Remember that all keys inside a B+tree node should be kept sorted.
     * @param key[IN] the key to insert.
@@ -52,6 +89,18 @@ class BTLeafNode {
     */
     RC insertAndSplit(int key, const RecordId& rid, BTLeafNode& sibling, int& siblingKey);
 
+   /**
+    * Same as above, but also stores the first valueSize bytes of value.
+    */
+    RC insertAndSplit(int key, const RecordId& rid, const std::string& value, BTLeafNode& sibling, int& siblingKey);
+
+   /**
+    * Remove the eid entry from the node; the entries behind it move up.
+    * @param eid[IN] the entry number to remove
+    * @return 0 if successful. Return an error code if there is an error.
+    */
+    RC remove(int eid);
+
    /**
     * If searchKey exists in the node, set eid to the index entry
     * with searchKey and return 0. If not, set eid to the index entry
@@ -74,6 +123,15 @@ class BTLeafNode {
     */
     RC readEntry(int eid, int& key, RecordId& rid);
 
+   /**
+    * Read the value stored with the eid entry of a covering index.
+    * @param eid[IN] the entry number to read the value from
+    * @param value[OUT] the stored value, or its prefix if it was too long
+    * @return 0 if the complete value is stored in the entry,
+    *         RC_VALUE_TRUNCATED if only a prefix is stored (or none at all).
+    */
+    RC readValue(int eid, std::string& value);
+
    /**
     * Return the pid of the next slibling node.
     * @return the PageId of the next sibling node 
@@ -88,11 +146,31 @@ class BTLeafNode {
     */
     RC setNextNodePtr(PageId pid);
 
+   /**
+    * Return the pid of the previous slibling node.
+    * @return the PageId of the previous sibling node (0 if there is none)
+    */
+    PageId getPrevNodePtr();
+
+   /**
+    * Set the previous slibling node PageId.
+    * @param pid[IN] the PageId of the previous sibling node 
+    * @return 0 if successful. Return an error code if there is an error.
+    */
+    RC setPrevNodePtr(PageId pid);
+
    /**
     * Return the number of keys stored in the node.
     * @return the number of keys in the node
     */
     int getKeyCount();
+
+   /**
+    * Return the number of keys the node has room for. A compressed node
+    * may be full before: when its entries no longer pack into a page.
+    * @return the max number of keys in the node
+    */
+    int getMaxKeyCount();
  
    /**
     * Read the content of the node from the page pid in the PageFile pf.
@@ -111,19 +189,51 @@ class BTLeafNode {
     RC write(PageId pid, PageFile& pf);
 
   private:
+   /**
+    * Encode the node into a disk page.
+    * @param page[OUT] the page to encode the node into
+    * @return 0 if successful. RC_NODE_FULL if the entries do not fit.
+    */
+    RC pack(char* page);
+
+   /**
+    * Decode a disk page into the node.
+    * @param page[IN] the page written by pack()
+    */
+    void unpack(const char* page);
+
    /**
     * The main memory buffer for loading the content of the disk page 
-    * that contains the node.
+    * that contains the node (decoded, if the node is compressed).
     */
-    char buffer[PageFile::PAGE_SIZE];
+    char buffer[COMPRESSED_NODE_SIZE];
+
+   /**
+    * The number of value bytes stored after the rid of every entry
+    * (0 unless the node belongs to a covering index).
+    */
+    int valueSize;
+
+   /**
+    * Whether the node is compressed on disk, and the size of the
+    * part of buffer in use (PAGE_SIZE unless it is compressed).
+    */
+    bool compressed;
+    int nodeSize;
 }; 
 
 
 /**
  * BTNonLeafNode: The class representing a B+tree nonleaf node.
+ * Next to every child pointer, the node stores the number of (key, rid)
+ * entries in the subtree under the child, so that range counts can be
+ * answered from the nonleaf levels alone.
  */
 class BTNonLeafNode {
   public:
+    // the most keys a node holds: |pid|count| followed by (key, pid, count) groups
+    static const int MAX_KEYS = (PageFile::PAGE_SIZE - sizeof(PageId) - sizeof(int))/(sizeof(int) + sizeof(PageId) + sizeof(int));
+
    /**
     * Constructor for Non leaf nodes
     * Initializes all variables
@@ -135,9 +245,16 @@ class BTNonLeafNode {
     * Remember that all keys inside a B+tree node should be kept sorted.
     * @param key[IN] the key to insert
     * @param pid[IN] the PageId to insert
+    * @param count[IN] the number of entries in the subtree under pid
     * @return 0 if successful. Return an error code if the node is full.
     */
-    RC insert(int key, PageId pid);
+    RC insert(int key, PageId pid, int count);
+
+   /**
+    * Same as above, but pid goes right behind child childIdx (the child it
+    * was split from), wherever key would sort among equal keys.
+    */
+    RC insert(int key, PageId pid, int count, int childIdx);
 
    /**
     * Insert the (key, pid) pair to the node
@@ -147,11 +264,25 @@ class BTNonLeafNode {
     * Remember that all keys inside a B+tree node should be kept sorted.
     * @param key[IN] the key to insert
     * @param pid[IN] the PageId to insert
+    * @param count[IN] the number of entries in the subtree under pid
     * @param sibling[IN] the sibling node to split with. This node MUST be empty when this function is called.
     * @param midKey[OUT] the key in the middle after the split. This key should be inserted to the parent node.
     * @return 0 if successful. Return an error code if there is an error.
     */
-    RC insertAndSplit(int key, PageId pid, BTNonLeafNode& sibling, int& midKey);
+    RC insertAndSplit(int key, PageId pid, int count, BTNonLeafNode& sibling, int& midKey);
+
+   /**
+    * Same as above, but if rightEdge (the node is the right-most one on
+    * its level) and key is larger than all keys in the node, the node
+    * stays full and only the last key moves to the sibling, so that
+    * ascending inserts fill the nodes.
+    */
+    RC insertAndSplit(int key, PageId pid, int count, BTNonLeafNode& sibling, int& midKey, bool rightEdge);
+
+   /**
+    * Same as above, with pid going right behind child childIdx.
+    */
+    RC insertAndSplit(int key, PageId pid, int count, int childIdx, BTNonLeafNode& sibling, int& midKey, bool rightEdge);
 
    /**
     * Given the searchKey, find the child-node pointer to follow and
@@ -163,14 +294,59 @@ class BTNonLeafNode {
     */
     RC locateChildPtr(int searchKey, PageId& pid);
 
+   /**
+    * Given the searchKey, find the position of the child-node pointer
+    * to follow. Children are numbered 0..getKeyCount().
+    * @param searchKey[IN] the searchKey that is being looked up.
+    * @return the child position, i.e. the number of keys <= searchKey
+    */
+    int locateChildIndex(int searchKey);
+
+   /**
+    * Return the key at position j, which separates child j-1 from child j.
+    * @param j[IN] the key position (1..getKeyCount())
+    * @return the key
+    */
+    int getKey(int j);
+
+   /**
+    * Return the child-node pointer at position j.
+    * @param j[IN] the child position (0..getKeyCount())
+    * @return the PageId of the child
+    */
+    PageId getChildPtr(int j);
+
+   /**
+    * Return the number of (key, rid) entries under the child at position j.
+    * @param j[IN] the child position (0..getKeyCount())
+    * @return the entry count of the child's subtree
+    */
+    int getChildCount(int j);
+
+   /**
+    * Set the number of (key, rid) entries under the child at position j.
+    * @param j[IN] the child position (0..getKeyCount())
+    * @param count[IN] the entry count of the child's subtree
+    * @return 0 if successful. Return an error code if there is an error.
+    */
+    RC setChildCount(int j, int count);
+
+   /**
+    * Return the number of (key, rid) entries in the subtree of this node.
+    * @return the sum of all child counts
+    */
+    int getTotalCount();
+
    /**
     * Initialize the root node with (pid1, key, pid2).
     * @param pid1[IN] the first PageId to insert
+    * @param count1[IN] the number of entries in the subtree under pid1
     * @param key[IN] the key that should be inserted between the two PageIds
     * @param pid2[IN] the PageId to insert behind the key
+    * @param count2[IN] the number of entries in the subtree under pid2
     * @return 0 if successful. Return an error code if there is an error.
     */
-    RC initializeRoot(PageId pid1, int key, PageId pid2);
+    RC initializeRoot(PageId pid1, int count1, int key, PageId pid2, int count2);
 
    /**
     * Return the number of keys stored in the node.
@@ -195,6 +371,11 @@ class BTNonLeafNode {
     RC write(PageId pid, PageFile& pf);
 
   private:
+   /**
+    * @return the key position (1..keyCount+1) a new key sorts to
+    */
+    int insertPosition(int key);
+
    /**
     * The main memory buffer for loading the content of the disk page 
     * that contains the node.
@@ -202,4 +383,121 @@ class BTNonLeafNode {
     char buffer[PageFile::PAGE_SIZE];
 }; 
 
+
+/**
+ * BTPostingNode: a page of the posting list of a key with many entries.
+ * For such a key a leaf keeps the single entry (key, (pid, POSTING_SID)),
+ * where pid is the first page of a chain of posting pages that hold the
+ * RecordIds of the key in sorted order. A page is laid out as
+ *   |next pid|prev pid|# rids|# bytes|tail pid|total # rids|last rid|rids...|
+ * where the rids are varints of (pid - pid of the rid before) *
+ * RECORDS_PER_PAGE + sid (the first one of a page relative to pid 0), so
+ * that the rids of a load take about a byte each. The tail pid and the
+ * total # of rids are only kept in the first page of the chain.
+ */
+class BTPostingNode {
+  public:
+    // the sid of a leaf entry whose pid is the first page of a posting list
+    // (a record sid is always below RECORDS_PER_PAGE)
+    static const int POSTING_SID = RecordFile::RECORDS_PER_PAGE;
+
+    // the offset of the first rid in the page
+    static const int HEADER_SIZE = 6*sizeof(int) + sizeof(RecordId);
+
+   /**
+    * Constructor: an empty page
+    */
+    BTPostingNode();
+
+   /**
+    * Append rid behind the rids in the page.
+    * @param rid[IN] the RecordId to append
+    * @return 0 if successful. RC_NODE_FULL if the page has no room left,
+    *         RC_INVALID_RID if rid is smaller than the last rid in the page.
+    */
+    RC append(const RecordId& rid);
+
+   /**
+    * Read the rid at offset and move offset to the next one.
+    * @param offset[IN/OUT] the byte offset of the rid (HEADER_SIZE for the first)
+    * @param prev[IN] the rid before it in the page (ignored for the first)
+    * @param rid[OUT] the rid
+    * @return 0 if successful. RC_END_OF_TREE if there are no more rids in the page.
+    */
+    RC readEntry(int& offset, const RecordId& prev, RecordId& rid);
+
+   /**
+    * Return the number of rids in the page.
+    */
+    int getCount();
+
+   /**
+    * Return the byte offset behind the last rid in the page.
+    */
+    int getEndOffset();
+
+   /**
+    * Return the pid of the next page in the chain (0 if there is none).
+    */
+    PageId getNextNodePtr();
+
+   /**
+    * Set the pid of the next page in the chain.
+    */
+    RC setNextNodePtr(PageId pid);
+
+   /**
+    * Return the pid of the previous page in the chain (0 for the first).
+    */
+    PageId getPrevNodePtr();
+
+   /**
+    * Set the pid of the previous page in the chain.
+    */
+    RC setPrevNodePtr(PageId pid);
+
+   /**
+    * Return the pid of the last page of the chain (first page only).
+    */
+    PageId getTailPtr();
+
+   /**
+    * Set the pid of the last page of the chain (first page only).
+    */
+    RC setTailPtr(PageId pid);
+
+   /**
+    * Return the number of rids in the whole chain (first page only).
+    */
+    int getTotalCount();
+
+   /**
+    * Set the number of rids in the whole chain (first page only).
+    */
+    RC setTotalCount(int count);
+
+   /**
+    * Read the content of the node from the page pid in the PageFile pf.
+    * @param pid[IN] the PageId to read
+    * @param pf[IN] PageFile to read from
+    * @return 0 if successful. Return an error code if there is an error.
+    */
+    RC read(PageId pid, const PageFile& pf);
+
+   /**
+    * Write the content of the node to the page pid in the PageFile pf.
+    * @param pid[IN] the PageId to write to
+    * @param pf[IN] PageFile to write to
+    * @return 0 if successful. Return an error code if there is an error.
+    */
+    RC write(PageId pid, PageFile& pf);
+
+  private:
+   /**
+    * The main memory buffer for loading the content of the disk page 
+    * that contains the node.
+    */
+    char buffer[PageFile::PAGE_SIZE];
+};
+
 #endif /* BTREENODE_H */
@@ -0,0 +1,68 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/19/2026
+ */
+
+#include "BufferedIndex.h"
+#include <algorithm>
+
+using namespace std;
+
+// orders the buffered entries by key; stable_sort keeps duplicates in order
+struct EntryOrder {
+	template <class T> bool operator()(const T& a, const T& b) const { return a.key < b.key; }
+};
+
+BufferedIndex::BufferedIndex()
+{
+}
+
+RC BufferedIndex::open(const string& indexname, char mode)
+{
+	pending.clear();
+	return tree.open(indexname, mode);
+}
+
+RC BufferedIndex::close()
+{
+	RC error;
+	if((error = flush())!=0) return error;
+	return tree.close();
+}
+
+RC BufferedIndex::insert(int key, const RecordId& rid, const string& value)
+{
+	// the tree would refuse it at the flush, when the caller cannot tell
+	// which row it came from
+	if(key==0) return RC_INVALID_ATTRIBUTE;
+
+	Entry entry;
+	entry.key = key;
+	entry.rid = rid;
+	entry.value = value;
+	pending.push_back(entry);
+
+	if((int)pending.size() >= BUFFER_ENTRIES) return flush();
+	return 0;
+}
+
+RC BufferedIndex::flush()
+{
+	RC error;
+
+	// in key order, consecutive inserts go to the same leaf while it is in
+	// the write buffer of the tree, and ascending runs use its append path
+	stable_sort(pending.begin(), pending.end(), EntryOrder());
+	for(int i=0; i<(int)pending.size(); i++)
+	{
+		if((error = tree.insert(pending[i].key, pending[i].rid, pending[i].value))!=0)
+		{
+			pending.erase(pending.begin(), pending.begin()+i);
+			return error;
+		}
+	}
+	pending.clear();
+	return 0;
+}
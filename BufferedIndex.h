@@ -0,0 +1,102 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/19/2026
+ */
+
+#ifndef BUFFEREDINDEX_H
+#define BUFFEREDINDEX_H
+
+#include <string>
+#include <vector>
+#include "Bruinbase.h"
+#include "BTreeIndex.h"
+
+/**
+ * A write-optimized front end to BTreeIndex for insert-heavy loads.
+ * Inserts are collected in a buffer above the root and flushed down in
+ * batches sorted by key, so every leaf (and every node on the way) is
+ * visited once per batch for all of its new entries instead of once per
+ * entry. It only writes: the index file is an ordinary B+tree, which
+ * queries read with a BTreeIndex, in this process once the index is
+ * closed and in other processes at any time (they see the entries of the
+ * batches flushed so far).
+ */
+class BufferedIndex {
+ public:
+  // the number of inserts collected before they are flushed to the tree
+  static const int BUFFER_ENTRIES = 16384;
+
+  BufferedIndex();
+
+  /**
+   * Open the index file in read or write mode.
+   * Under 'w' mode, the index file should be created if it does not exist.
+   * @param indexname[IN] the name of the index file
+   * @param mode[IN] 'r' for read, 'w' for write
+   * @return error code. 0 if no error
+   */
+  RC open(const std::string& indexname, char mode);
+
+  /**
+   * Flush the buffered inserts and close the index file.
+   * @return error code. 0 if no error
+   */
+  RC close();
+
+  /**
+   * Insert (key, RecordId) pair to the index.
+   * @param key[IN] the key for the value inserted into the index
+   * @param rid[IN] the RecordId for the record being inserted into the index
+   * @param value[IN] the value to keep in the entry of a covering index
+   * @return error code. 0 if no error, RC_INVALID_ATTRIBUTE for key 0,
+   *         which the tree cannot hold (see BTreeIndex::insert())
+   */
+  RC insert(int key, const RecordId& rid, const std::string& value);
+
+  /**
+   * Insert all buffered entries into the tree, in the order of their keys
+   * (entries with the same key keep the order they were inserted in).
+   * @return error code. 0 if no error
+   */
+  RC flush();
+
+  /**
+   * See BTreeIndex::includeValue().
+   */
+  RC includeValue() { return tree.includeValue(); }
+
+  /**
+   * See BTreeIndex::compressLeaves().
+   */
+  RC compressLeaves() { return tree.compressLeaves(); }
+
+  /**
+   * @return the size of the index file in pages (call flush() first to
+   *         count the buffered entries)
+   */
+  int getPageCount() const { return tree.getPageCount(); }
+
+  /**
+   * See BTreeIndex::setWriteBuffer().
+   */
+  void setWriteBuffer(int pages) { tree.setWriteBuffer(pages); }
+
+  /**
+   * @return the # of node writes absorbed by the write buffer since open()
+   */
+  int getCoalescedWriteCount() const { return tree.getCoalescedWriteCount(); }
+
+ private:
+  struct Entry {
+    int         key;
+    RecordId    rid;
+    std::string value;
+  };
+
+  BTreeIndex tree;             /// the B+tree the batches are flushed to
+  std::vector<Entry> pending;  /// the inserts not flushed yet
+};
+
+#endif /* BUFFEREDINDEX_H */
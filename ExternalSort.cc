@@ -0,0 +1,157 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/19/2026
+ */
+
+#include "ExternalSort.h"
+#include <algorithm>
+#include <thread>
+
+using namespace std;
+
+ExternalSort::ExternalSort(long budget, int threads)
+{
+	this->threads = max(1, threads);
+	capacity = max(1L, budget/(long)sizeof(Entry));
+	spilled = 0;
+	merging = false;
+}
+
+ExternalSort::~ExternalSort()
+{
+	for(unsigned i=0; i<runs.size(); i++)
+		if(runs[i].file) fclose(runs[i].file);
+}
+
+RC ExternalSort::add(int key, const RecordId& rid)
+{
+	RC error;
+
+	if(merging) return RC_INVALID_FILE_MODE;
+	if(buffer.size()==capacity && (error = sortBuffer(true))!=0) return error;
+
+	Entry entry;
+	entry.key = key;
+	entry.rid = rid;
+	buffer.push_back(entry);
+	return 0;
+}
+
+// orders the entries by key, and the entries of a key by RecordId
+struct ExternalSortOrder {
+	template <class T> bool operator()(const T& a, const T& b) const
+	{
+		return a.key < b.key || (a.key==b.key && a.rid < b.rid);
+	}
+};
+
+/*
+ * Sort the slice [begin, end) of the buffer and, if file is not NULL,
+ * write it to a new temporary file. Runs on its own thread.
+ */
+template <class T>
+static void sortSlice(T* begin, T* end, FILE** file, RC* rc)
+{
+	sort(begin, end, ExternalSortOrder());
+	*rc = 0;
+	if(file==NULL) return;
+
+	if((*file = tmpfile())==NULL) *rc = RC_FILE_OPEN_FAILED;
+	else if(fwrite(begin, sizeof(T), end-begin, *file)!=(size_t)(end-begin) || fflush(*file)!=0) *rc = RC_FILE_WRITE_FAILED;
+	else rewind(*file);
+}
+
+RC ExternalSort::sortBuffer(bool spill)
+{
+	if(buffer.empty()) return 0;
+
+	// one slice per thread, the first ones one entry longer if needed
+	unsigned n = buffer.size();
+	unsigned slices = min((unsigned)threads, n);
+	unsigned first = runs.size();
+	runs.resize(first + slices);
+	vector<FILE*> files(slices, (FILE*)NULL);
+	vector<RC> rcs(slices, 0);
+	vector<thread> workers;
+	for(unsigned i=0, begin=0; i<slices; i++)
+	{
+		unsigned end = begin + n/slices + (i < n%slices ? 1 : 0);
+		Run& run = runs[first+i];
+		run.file = NULL;
+		run.data = &buffer[begin];
+		run.pos = 0;
+		run.count = end - begin;
+		workers.push_back(thread(sortSlice<Entry>, &buffer[begin], &buffer[0] + end, spill ? &files[i] : (FILE**)NULL, &rcs[i]));
+		begin = end;
+	}
+	for(unsigned i=0; i<slices; i++) workers[i].join();
+
+	RC error = 0;
+	for(unsigned i=0; i<slices; i++)
+	{
+		if(rcs[i]!=0) error = rcs[i];
+		if(!spill) continue;
+
+		// read back block by block when merging
+		Run& run = runs[first+i];
+		run.file = files[i];
+		run.data = NULL;
+		run.count = 0;
+		spilled++;
+	}
+	if(spill) buffer.clear();
+	return error;
+}
+
+bool ExternalSort::fill(Run& run)
+{
+	if(run.pos < run.count) return true;
+	if(run.file==NULL) return false;
+
+	run.block.resize(MERGE_BLOCK);
+	run.count = fread(&run.block[0], sizeof(Entry), MERGE_BLOCK, run.file);
+	run.data = &run.block[0];
+	run.pos = 0;
+	return run.count > 0;
+}
+
+// orders the runs in a heap by their next entry, the smallest one on top
+struct ExternalSort::RunOrder {
+	const vector<Run>& runs;
+	RunOrder(const vector<Run>& runs) : runs(runs) {}
+	bool operator()(int a, int b) const
+	{
+		return ExternalSortOrder()(runs[b].data[runs[b].pos], runs[a].data[runs[a].pos]);
+	}
+};
+
+RC ExternalSort::finish()
+{
+	RC error;
+
+	if(merging) return 0;
+	if((error = sortBuffer(false))!=0) return error;
+	merging = true;
+
+	for(unsigned i=0; i<runs.size(); i++)
+		if(fill(runs[i])) heap.push_back(i);
+	make_heap(heap.begin(), heap.end(), RunOrder(runs));
+	return 0;
+}
+
+RC ExternalSort::next(int& key, RecordId& rid)
+{
+	if(!merging || heap.empty()) return RC_END_OF_TREE;
+
+	pop_heap(heap.begin(), heap.end(), RunOrder(runs));
+	Run& run = runs[heap.back()];
+	key = run.data[run.pos].key;
+	rid = run.data[run.pos].rid;
+	run.pos++;
+
+	if(fill(run)) push_heap(heap.begin(), heap.end(), RunOrder(runs));
+	else heap.pop_back();
+	return 0;
+}
@@ -0,0 +1,110 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/19/2026
+ */
+
+#ifndef EXTERNALSORT_H
+#define EXTERNALSORT_H
+
+#include <cstdio>
+#include <vector>
+#include "Bruinbase.h"
+#include "RecordFile.h"
+
+/**
+ * Sorts (key, RecordId) pairs by key, then RecordId, in a bounded amount
+ * of memory. Added pairs are collected in a buffer of budget bytes; a full
+ * buffer is cut into one slice per thread, the threads sort their slices
+ * at the same time, and every sorted slice is written out as a run to a
+ * temporary file. finish() keeps the slices of the last buffer in memory,
+ * and next() then returns the pairs in order by a k-way merge of all runs.
+ *
+ * The runs are plain stdio files rather than PageFiles: the threads write
+ * them, and PageFile keeps a shared read cache and page counters.
+ */
+class ExternalSort {
+ public:
+  static const int MERGE_BLOCK = 1024; // pairs read from a run file at a time
+
+  /**
+   * @param budget[IN] the most bytes to use for the buffer
+   * @param threads[IN] the # of threads that sort a full buffer
+   */
+  ExternalSort(long budget, int threads);
+  ~ExternalSort();
+
+  /**
+   * Add a (key, rid) pair.
+   * @return error code. 0 if no error
+   */
+  RC add(int key, const RecordId& rid);
+
+  /**
+   * Sort the pairs added last and start the merge. No pair can be added
+   * afterwards.
+   * @return error code. 0 if no error
+   */
+  RC finish();
+
+  /**
+   * Get the next pair in order.
+   * @param key[OUT] the key of the pair
+   * @param rid[OUT] the RecordId of the pair
+   * @return error code. RC_END_OF_TREE if all pairs have been returned
+   */
+  RC next(int& key, RecordId& rid);
+
+  /**
+   * @return the # of sorted runs, the ones kept in memory included
+   */
+  int getRunCount() const { return runs.size(); }
+
+  /**
+   * @return the # of runs written to temporary files
+   */
+  int getSpilledRunCount() const { return spilled; }
+
+ private:
+  struct Entry {
+    int      key;
+    RecordId rid;
+  };
+
+  struct Run {
+    FILE*        file;   // NULL for a run kept in memory (in the buffer)
+    std::vector<Entry> block; // the block of the file read last
+    const Entry* data;   // the entries in memory: the run, or its block
+    unsigned     pos;    // the next entry in data
+    unsigned     count;  // the # of entries in data
+  };
+
+  struct RunOrder; // orders the runs in the merge heap, see ExternalSort.cc
+
+  ExternalSort(const ExternalSort&);            // not copied: it owns its files
+  ExternalSort& operator=(const ExternalSort&);
+
+  /**
+   * Sort the buffer in slices and turn them into runs, written to files
+   * if spill is true.
+   */
+  RC sortBuffer(bool spill);
+
+  /**
+   * Make sure run has an entry at its pos, reading the next block from
+   * its file if needed.
+   * @return false if the run is exhausted
+   */
+  bool fill(Run& run);
+
+  int  threads;
+  unsigned capacity;           /// # entries the buffer holds
+  std::vector<Entry> buffer;   /// the entries not sorted yet
+  std::vector<Run> runs;
+  std::vector<int> heap;       /// the runs with entries left, smallest entry first
+  int  spilled;                /// # runs written to files
+  bool merging;                /// whether finish() was called
+};
+
+#endif /* EXTERNALSORT_H */
@@ -0,0 +1,348 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/19/2026
+ */
+
+#include "HashIndex.h"
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+
+map<string, HashIndex::DirectoryCache> HashIndex::dirCaches;
+
+/*
+ * Bucket format: |# entries|local depth|overflow PageId|key|rid|key|rid|...
+ */
+static const int BUCKET_HEADER_SIZE = 2*sizeof(int) + sizeof(PageId);
+static const int ENTRY_SIZE = sizeof(int) + sizeof(RecordId); // 4+(4+4) = 12 bytes
+static const int BUCKET_CAPACITY = (PageFile::PAGE_SIZE - BUCKET_HEADER_SIZE)/ENTRY_SIZE;
+
+// number of bucket PageIds in one directory page
+static const int DIR_ENTRIES_PER_PAGE = PageFile::PAGE_SIZE/sizeof(PageId);
+
+// header page: |global depth|# directory pages|directory PageIds...|
+static const int MAX_DIR_PAGES = (PageFile::PAGE_SIZE - 2*sizeof(int))/sizeof(PageId);
+
+static unsigned hashKey(int key)
+{
+	// multiplicative hashing; fold the well-mixed high bits into the low bits we use
+	unsigned h = (unsigned)key * 2654435761u;
+	return h ^ (h >> 15);
+}
+
+static int getField(const char* page, int n)
+{
+	int v;
+	memcpy(&v, page + n*sizeof(int), sizeof(int));
+	return v;
+}
+
+static void setField(char* page, int n, int v)
+{
+	memcpy(page + n*sizeof(int), &v, sizeof(int));
+}
+
+// the fields of the bucket header
+enum { BUCKET_COUNT = 0, BUCKET_DEPTH = 1, BUCKET_OVERFLOW = 2 };
+
+static void readEntry(const char* page, int eid, int& key, RecordId& rid)
+{
+	const char* temp = page + BUCKET_HEADER_SIZE + eid*ENTRY_SIZE;
+	memcpy(&key, temp, sizeof(int));
+	memcpy(&rid, temp+sizeof(int), sizeof(RecordId));
+}
+
+static void appendEntry(char* page, int key, const RecordId& rid)
+{
+	int count = getField(page, BUCKET_COUNT);
+	char* temp = page + BUCKET_HEADER_SIZE + count*ENTRY_SIZE;
+	memcpy(temp, &key, sizeof(int));
+	memcpy(temp+sizeof(int), &rid, sizeof(RecordId));
+	setField(page, BUCKET_COUNT, count+1);
+}
+
+static void initBucket(char* page, int depth)
+{
+	memset(page, 0, PageFile::PAGE_SIZE);
+	setField(page, BUCKET_DEPTH, depth);
+}
+
+HashIndex::HashIndex()
+{
+	mode = 'r';
+	statValid = false;
+	globalDepth = 0;
+}
+
+RC HashIndex::open(const string& indexname, char mode)
+{
+	RC error;
+	char page[PageFile::PAGE_SIZE];
+
+	if((error = pf.open(indexname, mode))!=0) return error;
+	this->indexname = indexname;
+	this->mode = mode;
+	dirPages.clear();
+	directory.clear();
+	dirLoaded.clear();
+
+	// the cached directory is still good if the file did not change since
+	// it was read (stat first: a later change only makes us re-read)
+	DirectoryCache& cache = dirCaches[indexname];
+	statValid = (mode=='r' || mode=='R') && ::stat(indexname.c_str(), &fileStat)==0;
+	if(statValid && cache.valid && PageFile::sameFileVersion(cache.fileStat, fileStat))
+	{
+		globalDepth = cache.globalDepth;
+		dirPages = cache.dirPages;
+		directory = cache.directory;
+		dirLoaded = cache.dirLoaded;
+		return 0;
+	}
+	cache.valid = false;
+
+	if(pf.endPid()==0)
+	{
+		// new index: a single bucket of local depth 0 behind page 0
+		globalDepth = 0;
+		memset(page, 0, PageFile::PAGE_SIZE);
+		if((error = pf.write(0, page))!=0) return error;
+		initBucket(page, 0);
+		if((error = pf.write(1, page))!=0) return error;
+		directory.push_back(1);
+		return 0;
+	}
+
+	if((error = pf.read(0, page))!=0) return error;
+	globalDepth = getField(page, 0);
+	int dirPageCount = getField(page, 1);
+	for(int i=0; i<dirPageCount; i++) dirPages.push_back(getField(page, 2+i));
+
+	// the directory pages are read on demand
+	directory.assign(1 << globalDepth, -1);
+	dirLoaded.assign(dirPageCount, false);
+
+	// inserts may touch any slot; load the whole directory up front
+	if(mode=='w' || mode=='W')
+	{
+		PageId pid;
+		for(int slot=0; slot<(int)directory.size(); slot+=DIR_ENTRIES_PER_PAGE)
+			if((error = getBucket(slot, pid))!=0) return error;
+	}
+	return 0;
+}
+
+RC HashIndex::close()
+{
+	RC error;
+	char page[PageFile::PAGE_SIZE];
+
+	if(mode=='w' || mode=='W')
+	{
+		int dirPageCount = (directory.size() + DIR_ENTRIES_PER_PAGE - 1)/DIR_ENTRIES_PER_PAGE;
+
+		// write the directory pages, appending new ones if the directory grew
+		for(int i=0; i<dirPageCount; i++)
+		{
+			if(i >= (int)dirPages.size()) dirPages.push_back(pf.endPid());
+			memset(page, 0, PageFile::PAGE_SIZE);
+			for(int j=0; j<DIR_ENTRIES_PER_PAGE && i*DIR_ENTRIES_PER_PAGE+j < (int)directory.size(); j++)
+				setField(page, j, directory[i*DIR_ENTRIES_PER_PAGE+j]);
+			if((error = pf.write(dirPages[i], page))!=0) return error;
+		}
+
+		// write the header
+		memset(page, 0, PageFile::PAGE_SIZE);
+		setField(page, 0, globalDepth);
+		setField(page, 1, dirPageCount);
+		for(int i=0; i<dirPageCount; i++) setField(page, 2+i, dirPages[i]);
+		if((error = pf.write(0, page))!=0) return error;
+	}
+	else if(statValid)
+	{
+		// keep the directory pages read for the next lookups
+		DirectoryCache& cache = dirCaches[indexname];
+		cache.valid = true;
+		cache.fileStat = fileStat;
+		cache.globalDepth = globalDepth;
+		cache.dirPages = dirPages;
+		cache.directory = directory;
+		cache.dirLoaded = dirLoaded;
+	}
+
+	return pf.close();
+}
+
+int HashIndex::getPageCount() const
+{
+	int dirPageCount = (directory.size() + DIR_ENTRIES_PER_PAGE - 1)/DIR_ENTRIES_PER_PAGE;
+	return pf.endPid() + max(0, dirPageCount - (int)dirPages.size());
+}
+
+int HashIndex::getLookupCost(int key, double rows) const
+{
+	int dirPage = (hashKey(key) & (directory.size()-1)) / DIR_ENTRIES_PER_PAGE;
+	bool dirCached = dirPage >= (int)dirLoaded.size() || dirLoaded[dirPage];
+	return (dirCached ? 0 : 1) + max(1, (int)ceil(rows/BUCKET_CAPACITY));
+}
+
+RC HashIndex::getBucket(int slot, PageId& pid)
+{
+	RC error;
+	int dirPage = slot / DIR_ENTRIES_PER_PAGE;
+
+	if(dirPage < (int)dirLoaded.size() && !dirLoaded[dirPage])
+	{
+		char page[PageFile::PAGE_SIZE];
+		if((error = pf.read(dirPages[dirPage], page))!=0) return error;
+		for(int j=0; j<DIR_ENTRIES_PER_PAGE && dirPage*DIR_ENTRIES_PER_PAGE+j < (int)directory.size(); j++)
+			directory[dirPage*DIR_ENTRIES_PER_PAGE+j] = getField(page, j);
+		dirLoaded[dirPage] = true;
+	}
+
+	pid = directory[slot];
+	return 0;
+}
+
+RC HashIndex::splitBucket(PageId pid)
+{
+	RC error;
+	char page[PageFile::PAGE_SIZE];
+	vector<PageId> pids;
+	vector<int> keys;
+	vector<RecordId> rids;
+
+	// read the entries of the bucket and its overflow chain
+	for(PageId next = pid; next > 0; next = getField(page, BUCKET_OVERFLOW))
+	{
+		if((error = pf.read(next, page))!=0) return error;
+		pids.push_back(next);
+		for(int eid=0; eid<getField(page, BUCKET_COUNT); eid++)
+		{
+			int key;
+			RecordId rid;
+			readEntry(page, eid, key, rid);
+			keys.push_back(key);
+			rids.push_back(rid);
+		}
+	}
+
+	// a split that moves all the entries to one side (duplicate keys, or
+	// keys whose hashes agree on the bit) frees no room: chain a page instead
+	int localDepth = getField(page, BUCKET_DEPTH);
+	int moved = 0;
+	for(int i=0; i<(int)keys.size(); i++) moved += (hashKey(keys[i]) >> localDepth) & 1;
+	if(moved==0 || moved==(int)keys.size()) return RC_NODE_FULL;
+
+	// the bucket is referenced by a single slot: double the directory
+	if(localDepth == globalDepth)
+	{
+		if(globalDepth >= MAX_DEPTH ||
+		   (int)(2*directory.size()) > MAX_DIR_PAGES*DIR_ENTRIES_PER_PAGE) return RC_NODE_FULL;
+		int size = directory.size();
+		for(int slot=0; slot<size; slot++) directory.push_back(directory[slot]);
+		globalDepth++;
+	}
+
+	// lay the two halves out on the pages of the old chain (the first half
+	// keeps pid), appending pages when they need more
+	int extra = 0;
+	vector<PageId> halfPids[2];
+	for(int half=0; half<2; half++)
+	{
+		int count = (half ? moved : (int)keys.size() - moved);
+		int pageCount = max(1, (count + BUCKET_CAPACITY - 1)/BUCKET_CAPACITY);
+		for(int i=0; i<pageCount; i++)
+		{
+			int used = halfPids[0].size() + halfPids[1].size();
+			halfPids[half].push_back(used < (int)pids.size() ? pids[used] : pf.endPid() + extra++);
+		}
+	}
+
+	PageId newPid = halfPids[1][0];
+	for(int slot=0; slot<(int)directory.size(); slot++)
+		if(directory[slot]==pid && ((slot >> localDepth) & 1)) directory[slot] = newPid;
+
+	// redistribute the entries on hash bit localDepth
+	for(int half=0; half<2; half++)
+	{
+		int i = 0;
+		for(int p=0; p<(int)halfPids[half].size(); p++)
+		{
+			initBucket(page, localDepth+1);
+			for(; i<(int)keys.size() && getField(page, BUCKET_COUNT) < BUCKET_CAPACITY; i++)
+				if((int)((hashKey(keys[i]) >> localDepth) & 1) == half) appendEntry(page, keys[i], rids[i]);
+			if(p+1 < (int)halfPids[half].size()) setField(page, BUCKET_OVERFLOW, halfPids[half][p+1]);
+			if((error = pf.write(halfPids[half][p], page))!=0) return error;
+		}
+	}
+	return 0;
+}
+
+RC HashIndex::insert(int key, const RecordId& rid)
+{
+	RC error;
+	char page[PageFile::PAGE_SIZE];
+	unsigned h = hashKey(key);
+
+	while(true)
+	{
+		// find the last page of the bucket's overflow chain
+		PageId pid, lastPid, nextPid;
+		if((error = getBucket(h & (directory.size()-1), pid))!=0) return error;
+		for(lastPid = pid; ; lastPid = nextPid)
+		{
+			if((error = pf.read(lastPid, page))!=0) return error;
+			if((nextPid = getField(page, BUCKET_OVERFLOW)) <= 0) break;
+		}
+
+		if(getField(page, BUCKET_COUNT) < BUCKET_CAPACITY)
+		{
+			appendEntry(page, key, rid);
+			return pf.write(lastPid, page);
+		}
+
+		// split the full bucket and try again
+		if((error = splitBucket(pid))==0) continue;
+		if(error != RC_NODE_FULL) return error;
+
+		// the split would not separate the entries: chain an overflow page
+		char overflowPage[PageFile::PAGE_SIZE];
+		initBucket(overflowPage, getField(page, BUCKET_DEPTH));
+		appendEntry(overflowPage, key, rid);
+		nextPid = pf.endPid();
+		if((error = pf.write(nextPid, overflowPage))!=0) return error;
+		setField(page, BUCKET_OVERFLOW, nextPid);
+		return pf.write(lastPid, page);
+	}
+}
+
+RC HashIndex::lookup(int searchKey, vector<RecordId>& rids)
+{
+	RC error;
+	char page[PageFile::PAGE_SIZE];
+	PageId pid;
+
+	rids.clear();
+	if((error = getBucket(hashKey(searchKey) & (directory.size()-1), pid))!=0) return error;
+
+	// scan the bucket and its overflow chain
+	while(pid > 0)
+	{
+		if((error = pf.read(pid, page))!=0) return error;
+		int count = getField(page, BUCKET_COUNT);
+		for(int eid=0; eid<count; eid++)
+		{
+			int key;
+			RecordId rid;
+			readEntry(page, eid, key, rid);
+			if(key==searchKey) rids.push_back(rid);
+		}
+		pid = getField(page, BUCKET_OVERFLOW);
+	}
+
+	return rids.empty() ? RC_NO_SUCH_RECORD : 0;
+}
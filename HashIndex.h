@@ -0,0 +1,129 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/19/2026
+ */
+
+#ifndef HASHINDEX_H
+#define HASHINDEX_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include "Bruinbase.h"
+#include "PageFile.h"
+#include "RecordFile.h"
+
+/**
+ * Implements an extendible hash index over the key column.
+ * The index answers key equality lookups by reading a single bucket page
+ * (plus, when it is not cached yet, the directory page that points to it).
+ * The directory pages read are kept for the process, so later lookups on
+ * the same version of the file read the bucket page only.
+ *
+ * File layout:
+ *   page 0:          |global depth|# directory pages|directory PageIds...|
+ *   directory pages: 256 bucket PageIds each, for 2^(global depth) slots
+ *   bucket pages:    |# entries|local depth|overflow PageId|(key, rid)...|
+ * A full bucket whose split would leave all its entries on one side (as
+ * duplicate keys do), or that cannot be split any further (MAX_DEPTH),
+ * grows a chain of overflow pages instead.
+ */
+class HashIndex {
+ public:
+  // maximum global depth: 2^15 slots fit in the directory pages listed in page 0
+  static const int MAX_DEPTH = 15;
+
+  HashIndex();
+
+  /**
+   * Open the index file in read or write mode.
+   * Under 'w' mode, the index file should be created if it does not exist.
+   * @param indexname[IN] the name of the index file
+   * @param mode[IN] 'r' for read, 'w' for write
+   * @return error code. 0 if no error
+   */
+  RC open(const std::string& indexname, char mode);
+
+  /**
+   * Close the index file, writing the directory back under 'w' mode.
+   * @return error code. 0 if no error
+   */
+  RC close();
+
+  /**
+   * Insert (key, RecordId) pair to the index.
+   * @param key[IN] the key of the record
+   * @param rid[IN] the RecordId for the record being inserted into the index
+   * @return error code. 0 if no error
+   */
+  RC insert(int key, const RecordId& rid);
+
+  /**
+   * Find all records with the given key.
+   * @param searchKey[IN] the key to look up
+   * @param rids[OUT] the RecordIds of all entries with searchKey
+   * @return 0 if at least one entry was found, RC_NO_SUCH_RECORD if none,
+   *         or another error code
+   */
+  RC lookup(int searchKey, std::vector<RecordId>& rids);
+
+  /**
+   * @return the size of the index file in pages, counting the directory
+   *         pages that close() has yet to write
+   */
+  int getPageCount() const;
+
+  /**
+   * @param key[IN] the key to look up
+   * @param rows[IN] the estimated # of entries with the key
+   * @return the # of pages a lookup of key is estimated to read: its
+   *         directory page if that is not cached, and the bucket pages
+   *         that the entries fill
+   */
+  int getLookupCost(int key, double rows) const;
+
+ private:
+  /**
+   * The directory of an index file, as far as it has been read, kept for
+   * the lifetime of the process. fileStat identifies the version of the
+   * file it was read from.
+   */
+  struct DirectoryCache {
+    bool        valid;
+    struct stat fileStat;
+    int         globalDepth;
+    std::vector<PageId> dirPages;
+    std::vector<PageId> directory;
+    std::vector<bool>   dirLoaded;
+  };
+
+  static std::map<std::string, DirectoryCache> dirCaches;
+
+  /**
+   * Return the bucket PageId of directory slot, reading its directory page if needed.
+   */
+  RC getBucket(int slot, PageId& pid);
+
+  /**
+   * Split the bucket at pid and its overflow chain (doubling the directory
+   * if necessary).
+   * @return error code. RC_NODE_FULL if the split would not separate the
+   *         entries or the directory cannot grow
+   */
+  RC splitBucket(PageId pid);
+
+  PageFile pf;                     /// the PageFile used to store the index
+  std::string indexname;           /// the name of the index file
+  char     mode;                   /// 'r' or 'w'
+  bool     statValid;              /// whether fileStat was taken at open()
+  struct stat fileStat;            /// the version of the file opened for reading
+  int      globalDepth;            /// the directory has 2^globalDepth slots
+  std::vector<PageId> dirPages;    /// the PageIds of the directory pages
+  std::vector<PageId> directory;   /// the bucket PageId of every slot
+  std::vector<bool>   dirLoaded;   /// whether each directory page was read
+};
+
+#endif /* HASHINDEX_H */
@@ -0,0 +1,343 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/19/2026
+ */
+
+#include "LearnedIndex.h"
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+
+/*
+ * Data page format: |# entries|key|rid|key|rid|...
+ */
+static const int ENTRY_SIZE = sizeof(int) + sizeof(RecordId); // 4+(4+4) = 12 bytes
+static const int DATA_CAPACITY = (PageFile::PAGE_SIZE - sizeof(int))/ENTRY_SIZE;
+
+// index header: |# entries|# data pages|# models|# model pages|min key|max key|
+enum { HDR_ENTRIES = 0, HDR_DATA_PAGES, HDR_MODELS, HDR_MODEL_PAGES, HDR_MIN_KEY, HDR_MAX_KEY, HDR_FIELDS };
+
+map<string, LearnedIndex::ModelCache> LearnedIndex::modelCaches;
+
+static int getField(const char* page, int n)
+{
+	int v;
+	memcpy(&v, page + n*sizeof(int), sizeof(int));
+	return v;
+}
+
+static void setField(char* page, int n, int v)
+{
+	memcpy(page + n*sizeof(int), &v, sizeof(int));
+}
+
+static void readEntry(const char* page, int eid, int& key, RecordId& rid)
+{
+	const char* temp = page + sizeof(int) + eid*ENTRY_SIZE;
+	memcpy(&key, temp, sizeof(int));
+	memcpy(&rid, temp+sizeof(int), sizeof(RecordId));
+}
+
+/*
+ * The position a model predicts for key. Training and lookups have to
+ * round the same way for the error bounds to hold.
+ */
+static long predict(double slope, double intercept, int key)
+{
+	return (long)floor(slope*key + intercept);
+}
+
+// orders the entries by key; stable_sort keeps duplicates in insert order
+struct LearnedEntryOrder {
+	template <class T> bool operator()(const T& a, const T& b) const { return a.key < b.key; }
+};
+
+LearnedIndex::LearnedIndex()
+{
+	mode = 'r';
+	entryCount = dataPages = modelPages = 0;
+	minKey = maxKey = 0;
+	bufferPid = -1;
+}
+
+RC LearnedIndex::open(const string& indexname, char mode)
+{
+	RC error;
+	char page[PageFile::PAGE_SIZE];
+
+	if((error = pf.open(indexname, mode))!=0) return error;
+	name = indexname;
+	this->mode = mode;
+	entryCount = dataPages = modelPages = 0;
+	minKey = maxKey = 0;
+	models.clear();
+	entries.clear();
+	bufferPid = -1;
+
+	// a new index has no entries yet
+	if(pf.endPid()==0) return 0;
+
+	if((error = pf.read(0, page))!=0) return error;
+	entryCount = getField(page, HDR_ENTRIES);
+	dataPages = getField(page, HDR_DATA_PAGES);
+	int modelCount = getField(page, HDR_MODELS);
+	modelPages = getField(page, HDR_MODEL_PAGES);
+	minKey = getField(page, HDR_MIN_KEY);
+	maxKey = getField(page, HDR_MAX_KEY);
+
+	// the index is rebuilt on close: keep the old entries
+	if(mode=='w' || mode=='W')
+	{
+		for(PageId pid=1; pid<=dataPages; pid++)
+		{
+			if((error = pf.read(pid, page))!=0) return error;
+			for(int eid=0; eid<getField(page, 0); eid++)
+			{
+				Entry entry;
+				readEntry(page, eid, entry.key, entry.rid);
+				entries.push_back(entry);
+			}
+		}
+		return 0;
+	}
+
+	// the cached models are still good if the file did not change
+	ModelCache& cache = modelCaches[indexname];
+	struct stat statbuf;
+	if(::stat(indexname.c_str(), &statbuf)==0 && cache.valid && PageFile::sameFileVersion(cache.fileStat, statbuf))
+	{
+		models = cache.models;
+		return 0;
+	}
+
+	const int modelsPerPage = PageFile::PAGE_SIZE/sizeof(Model);
+	models.resize(modelCount);
+	for(int i=0; i<modelPages; i++)
+	{
+		if((error = pf.read(1+dataPages+i, page))!=0) return error;
+		int n = min(modelsPerPage, modelCount - i*modelsPerPage);
+		memcpy(&models[i*modelsPerPage], page, n*sizeof(Model));
+	}
+	cache.valid = true;
+	cache.fileStat = statbuf;
+	cache.models = models;
+	return 0;
+}
+
+RC LearnedIndex::close()
+{
+	RC error;
+
+	if((mode=='w' || mode=='W') && (error = build())!=0) return error;
+	entries.clear();
+	return pf.close();
+}
+
+RC LearnedIndex::insert(int key, const RecordId& rid)
+{
+	Entry entry;
+	entry.key = key;
+	entry.rid = rid;
+	entries.push_back(entry);
+	return 0;
+}
+
+int LearnedIndex::modelIndex(int key) const
+{
+	int count = models.size();
+	double m = ((double)key - minKey) * count / ((double)maxKey - minKey + 1);
+	if(m < 0) return 0;
+	if(m >= count) return count-1;
+	return (int)m;
+}
+
+RC LearnedIndex::build()
+{
+	RC error;
+	char page[PageFile::PAGE_SIZE];
+
+	stable_sort(entries.begin(), entries.end(), LearnedEntryOrder());
+	entryCount = entries.size();
+	minKey = entryCount ? entries.front().key : 0;
+	maxKey = entryCount ? entries.back().key : 0;
+
+	// the data pages, all but the last one full
+	dataPages = (entryCount + DATA_CAPACITY-1)/DATA_CAPACITY;
+	for(int i=0; i<dataPages; i++)
+	{
+		memset(page, 0, PageFile::PAGE_SIZE);
+		int n = min(DATA_CAPACITY, entryCount - i*DATA_CAPACITY);
+		setField(page, 0, n);
+		for(int j=0; j<n; j++)
+		{
+			const Entry& entry = entries[i*DATA_CAPACITY+j];
+			char* temp = page + sizeof(int) + j*ENTRY_SIZE;
+			memcpy(temp, &entry.key, sizeof(int));
+			memcpy(temp+sizeof(int), &entry.rid, sizeof(RecordId));
+		}
+		if((error = pf.write(1+i, page))!=0) return error;
+	}
+
+	// fit every second-stage model by least squares to the position of the
+	// first entry of each distinct key the root sends to it. The keys are
+	// sorted and the root is monotone, so each model gets a run of keys.
+	models.assign(entryCount ? max(1, entryCount/MODEL_ENTRIES) : 0, Model());
+	int pos = 0;
+	for(int m=0; m<(int)models.size(); m++)
+	{
+		Model& model = models[m];
+		int first = pos;
+		double sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+		int points = 0;
+		for(; pos<entryCount && modelIndex(entries[pos].key)==m; pos++)
+		{
+			if(pos > first && entries[pos].key==entries[pos-1].key) continue;
+			// relative to the first key, for precision
+			double x = (double)entries[pos].key - entries[first].key;
+			sumX += x;
+			sumY += pos;
+			sumXX += x*x;
+			sumXY += x*pos;
+			points++;
+		}
+
+		// no keys: everything the root sends here belongs at the next entry
+		model.slope = 0;
+		model.intercept = pos;
+		if(points > 0)
+		{
+			double meanX = sumX/points, meanY = sumY/points;
+			double varX = sumXX - points*meanX*meanX;
+			double covXY = sumXY - points*meanX*meanY;
+			if(varX > 0 && covXY > 0) model.slope = covXY/varX;
+			model.intercept = meanY - model.slope*(meanX + entries[first].key);
+		}
+
+		model.errLo = model.errHi = 0;
+		for(int i=first; i<pos; i++)
+		{
+			if(i > first && entries[i].key==entries[i-1].key) continue;
+			long err = i - predict(model.slope, model.intercept, entries[i].key);
+			if(i==first || err < model.errLo) model.errLo = err;
+			if(i==first || err > model.errHi) model.errHi = err;
+		}
+	}
+
+	const int modelsPerPage = PageFile::PAGE_SIZE/sizeof(Model);
+	modelPages = (models.size() + modelsPerPage-1)/modelsPerPage;
+	for(int i=0; i<modelPages; i++)
+	{
+		memset(page, 0, PageFile::PAGE_SIZE);
+		int n = min(modelsPerPage, (int)models.size() - i*modelsPerPage);
+		memcpy(page, &models[i*modelsPerPage], n*sizeof(Model));
+		if((error = pf.write(1+dataPages+i, page))!=0) return error;
+	}
+
+	memset(page, 0, PageFile::PAGE_SIZE);
+	setField(page, HDR_ENTRIES, entryCount);
+	setField(page, HDR_DATA_PAGES, dataPages);
+	setField(page, HDR_MODELS, models.size());
+	setField(page, HDR_MODEL_PAGES, modelPages);
+	setField(page, HDR_MIN_KEY, minKey);
+	setField(page, HDR_MAX_KEY, maxKey);
+	if((error = pf.write(0, page))!=0) return error;
+
+	modelCaches[name].valid = false;
+	bufferPid = -1;
+	return 0;
+}
+
+RC LearnedIndex::readKey(int pos, int& key)
+{
+	RC error;
+	RecordId rid;
+	PageId pid = 1 + pos/DATA_CAPACITY;
+
+	if(pid!=bufferPid)
+	{
+		if((error = pf.read(pid, buffer))!=0) return error;
+		bufferPid = pid;
+	}
+	readEntry(buffer, pos%DATA_CAPACITY, key, rid);
+	return 0;
+}
+
+RC LearnedIndex::locate(int searchKey, IndexCursor& cursor)
+{
+	RC error;
+	int key;
+
+	cursor.pid = 1;
+	cursor.eid = 0;
+	if(entryCount==0) return RC_NO_SUCH_RECORD;
+
+	// the position of the first entry >= searchKey is in [lo, hi]
+	const Model& model = models[modelIndex(searchKey)];
+	long pred = predict(model.slope, model.intercept, searchKey);
+	long lo = max(0L, min((long)entryCount, pred + model.errLo));
+	long hi = max(lo, min((long)entryCount, pred + model.errHi + 1));
+
+	// searchKey fell between the trained keys: widen the bounds until the
+	// entry before lo is below searchKey and the one at hi is not
+	for(long step = 1; lo > 0; step *= 2)
+	{
+		if((error = readKey(lo-1, key))!=0) return error;
+		if(key < searchKey) break;
+		hi = lo-1;
+		lo = max(0L, lo-step);
+	}
+	for(long step = 1; hi < entryCount; step *= 2)
+	{
+		if((error = readKey(hi, key))!=0) return error;
+		if(key >= searchKey) break;
+		lo = hi+1;
+		hi = min((long)entryCount, hi+step);
+	}
+
+	// the last mile: binary search in [lo, hi]
+	while(lo < hi)
+	{
+		long mid = (lo+hi)/2;
+		if((error = readKey(mid, key))!=0) return error;
+		if(key < searchKey) lo = mid+1;
+		else hi = mid;
+	}
+
+	cursor.pid = 1 + lo/DATA_CAPACITY;
+	cursor.eid = lo%DATA_CAPACITY;
+	if(lo==entryCount) return RC_NO_SUCH_RECORD;
+	if((error = readKey(lo, key))!=0) return error;
+	return key==searchKey ? 0 : RC_NO_SUCH_RECORD;
+}
+
+RC LearnedIndex::readForward(IndexCursor& cursor, int& key, RecordId& rid)
+{
+	RC error;
+
+	if(cursor.pid < 1 || (cursor.pid-1)*DATA_CAPACITY + cursor.eid >= entryCount) return RC_END_OF_TREE;
+	if(cursor.pid!=bufferPid)
+	{
+		if((error = pf.read(cursor.pid, buffer))!=0) return error;
+		bufferPid = cursor.pid;
+	}
+	readEntry(buffer, cursor.eid, key, rid);
+
+	if(++cursor.eid==DATA_CAPACITY)
+	{
+		cursor.pid++;
+		cursor.eid = 0;
+	}
+	return 0;
+}
+
+int LearnedIndex::getMaxError() const
+{
+	int err = 0;
+	for(unsigned i=0; i<models.size(); i++) err = max(err, max(-models[i].errLo, models[i].errHi));
+	return err;
+}
@@ -0,0 +1,165 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/19/2026
+ */
+
+#ifndef LEARNEDINDEX_H
+#define LEARNEDINDEX_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include "Bruinbase.h"
+#include "PageFile.h"
+#include "RecordFile.h"
+#include "BTreeIndex.h"
+
+/**
+ * Implements a read-only learned index over the key column: a two-stage
+ * recursive model index (RMI) over the (key, RecordId) entries sorted by
+ * key. The root model interpolates linearly between the smallest and the
+ * largest key to pick one of the second-stage models, and that model
+ * predicts the position of the first entry with the key by linear
+ * regression. Each second-stage model records the range of its errors on
+ * the keys it was trained on; a lookup binary-searches the positions
+ * within those bounds (widened exponentially if the key falls between
+ * trained keys and the prediction is further off), so it reads the one or
+ * two data pages around the position instead of treeHeight nodes.
+ *
+ * The index is rebuilt from all its entries when it is closed after
+ * inserts: LOAD into a table that has one reads the old entries back.
+ *
+ * File layout:
+ *   page 0:        |# entries|# data pages|# models|# model pages|min key|max key|
+ *   data pages:    |# entries|(key, rid)...| sorted by key, all but the
+ *                  last one full, so position p is on page 1+p/DATA_CAPACITY
+ *   model pages:   |slope|intercept|min error|max error|... the models
+ */
+class LearnedIndex {
+ public:
+  static const int MODEL_ENTRIES = 256; // entries per second-stage model, on average
+
+  LearnedIndex();
+
+  /**
+   * Open the index in read or write mode.
+   * Under 'w' mode, the index is created if it does not exist.
+   * @param indexname[IN] the name of the index file
+   * @param mode[IN] 'r' for read, 'w' for write
+   * @return error code. 0 if no error
+   */
+  RC open(const std::string& indexname, char mode);
+
+  /**
+   * Close the index. Under 'w' mode the index is rebuilt first.
+   * @return error code. 0 if no error
+   */
+  RC close();
+
+  /**
+   * Insert (key, RecordId) pair to the index. The entry becomes visible
+   * when the index is closed.
+   * @param key[IN] the key of the record
+   * @param rid[IN] the RecordId for the record being inserted into the index
+   * @return error code. 0 if no error
+   */
+  RC insert(int key, const RecordId& rid);
+
+  /**
+   * Find the first entry whose key is larger than or equal to searchKey,
+   * as BTreeIndex::locate() does: cursor.pid is its data page and
+   * cursor.eid its entry in the page.
+   * @param searchKey[IN] the key to find
+   * @param cursor[OUT] the cursor pointing to the entry
+   * @return 0 if searchKey is found. Otherwise RC_NO_SUCH_RECORD
+   */
+  RC locate(int searchKey, IndexCursor& cursor);
+
+  /**
+   * Read the (key, rid) pair at the cursor and move the cursor forward.
+   * @param cursor[IN/OUT] the cursor pointing to an entry of the index
+   * @param key[OUT] the key of the entry
+   * @param rid[OUT] the RecordId of the entry
+   * @return error code. RC_END_OF_TREE if there are no more entries
+   */
+  RC readForward(IndexCursor& cursor, int& key, RecordId& rid);
+
+  /**
+   * @return the # of pages of the index file
+   */
+  int getPageCount() const { return 1 + dataPages + modelPages; }
+
+  /**
+   * @return the # of second-stage models
+   */
+  int getModelCount() const { return models.size(); }
+
+  /**
+   * @return the bytes the models take in memory
+   */
+  int getModelSize() const { return models.size()*sizeof(Model); }
+
+  /**
+   * @return the largest distance between a trained position and its prediction
+   */
+  int getMaxError() const;
+
+ private:
+  struct Model {
+    double slope;
+    double intercept;
+    int    errLo;  // the smallest (position - prediction) of the trained keys
+    int    errHi;  // the largest (position - prediction) of the trained keys
+  };
+
+  struct Entry {
+    int      key;
+    RecordId rid;
+  };
+
+  /**
+   * The models of an index file, kept for the lifetime of the process so
+   * that a lookup only reads data pages. fileStat identifies the version
+   * of the file they were read from.
+   */
+  struct ModelCache {
+    bool        valid;
+    struct stat fileStat;
+    std::vector<Model> models;
+  };
+
+  static std::map<std::string, ModelCache> modelCaches;
+
+  /**
+   * Sort the entries, fit the models and write the index file.
+   */
+  RC build();
+
+  /**
+   * Read the key at position pos into key, through the page buffer.
+   */
+  RC readKey(int pos, int& key);
+
+  /**
+   * @return the second-stage model for key
+   */
+  int modelIndex(int key) const;
+
+  std::string name;            /// the name of the index file
+  char     mode;               /// 'r' or 'w'
+  PageFile pf;                 /// the index file
+  int      entryCount;         /// # entries in the data pages
+  int      dataPages;          /// # data pages
+  int      modelPages;         /// # model pages
+  int      minKey;             /// the smallest key
+  int      maxKey;             /// the largest key
+  std::vector<Model> models;   /// the second-stage models
+  std::vector<Entry> entries;  /// under 'w' mode, all the entries to write
+  PageId   bufferPid;          /// the data page in buffer (-1 if none)
+  char     buffer[PageFile::PAGE_SIZE];
+};
+
+#endif /* LEARNEDINDEX_H */
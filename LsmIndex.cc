@@ -0,0 +1,429 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/19/2026
+ */
+
+#include "LsmIndex.h"
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <unistd.h>
+
+using namespace std;
+
+/*
+ * Data page format: |# entries|key|rid|key|rid|...
+ */
+static const int ENTRY_SIZE = sizeof(int) + sizeof(RecordId); // 4+(4+4) = 12 bytes
+static const int DATA_CAPACITY = (PageFile::PAGE_SIZE - sizeof(int))/ENTRY_SIZE;
+
+// number of keys in one fence page
+static const int FENCES_PER_PAGE = PageFile::PAGE_SIZE/sizeof(int);
+
+// run header: |# entries|# data pages|# fence pages|# bloom pages|min key|max key|fence page keys...|
+enum { RUN_ENTRIES = 0, RUN_DATA_PAGES, RUN_FENCE_PAGES, RUN_BLOOM_PAGES, RUN_MIN_KEY, RUN_MAX_KEY, RUN_HEADER_FIELDS };
+static const int MAX_FENCE_PAGES = PageFile::PAGE_SIZE/sizeof(int) - RUN_HEADER_FIELDS;
+
+// index file: |# runs|next run id|(run id, level)...|
+static const int MAX_RUNS = (PageFile::PAGE_SIZE/sizeof(int) - 2)/2;
+
+static const int BLOOM_PAGE_BITS = PageFile::PAGE_SIZE*8;
+
+static int getField(const char* page, int n)
+{
+	int v;
+	memcpy(&v, page + n*sizeof(int), sizeof(int));
+	return v;
+}
+
+static void setField(char* page, int n, int v)
+{
+	memcpy(page + n*sizeof(int), &v, sizeof(int));
+}
+
+static void readEntry(const char* page, int eid, int& key, RecordId& rid)
+{
+	const char* temp = page + sizeof(int) + eid*ENTRY_SIZE;
+	memcpy(&key, temp, sizeof(int));
+	memcpy(&rid, temp+sizeof(int), sizeof(RecordId));
+}
+
+/*
+ * The bloom filter page of key and its BLOOM_HASHES bits in the page,
+ * by double hashing of two multiplicative hashes.
+ */
+static int bloomPage(int key, int bloomPages)
+{
+	unsigned h = (unsigned)key * 2654435761u;
+	return (h ^ (h >> 15)) % bloomPages;
+}
+
+static int bloomBit(int key, int i)
+{
+	unsigned h1 = (unsigned)key * 2246822519u;
+	unsigned h2 = (unsigned)key * 3266489917u;
+	h1 ^= h1 >> 13;
+	h2 = (h2 ^ (h2 >> 16)) | 1;
+	return (h1 + i*h2) % BLOOM_PAGE_BITS;
+}
+
+// orders the memtable by key; stable_sort keeps duplicates in insert order
+struct LsmEntryOrder {
+	template <class T> bool operator()(const T& a, const T& b) const { return a.key < b.key; }
+};
+
+LsmIndex::LsmIndex()
+{
+	mode = 'r';
+	nextRunId = 0;
+	probed = 0;
+	entryWrites = 0;
+}
+
+string LsmIndex::runName(int id) const
+{
+	char suffix[16];
+	sprintf(suffix, ".%d", id);
+	return name + suffix;
+}
+
+RC LsmIndex::open(const string& indexname, char mode)
+{
+	RC error;
+	char page[PageFile::PAGE_SIZE];
+
+	if((error = pf.open(indexname, mode))!=0) return error;
+	name = indexname;
+	this->mode = mode;
+	runs.clear();
+	memtable.clear();
+	nextRunId = 0;
+	probed = 0;
+	entryWrites = 0;
+
+	// a new index has no runs yet
+	if(pf.endPid()==0) return (mode=='w' || mode=='W') ? writeManifest() : 0;
+
+	if((error = pf.read(0, page))!=0) return error;
+	int runCount = getField(page, 0);
+	nextRunId = getField(page, 1);
+	runs.resize(runCount);
+	for(int i=0; i<runCount; i++)
+		if((error = openRun(getField(page, 2+2*i), getField(page, 3+2*i), runs[i]))!=0) return error;
+	return 0;
+}
+
+RC LsmIndex::close()
+{
+	RC error;
+
+	if((mode=='w' || mode=='W') && (error = flush())!=0) return error;
+
+	for(unsigned i=0; i<runs.size(); i++) runs[i].pf.close();
+	runs.clear();
+	return pf.close();
+}
+
+RC LsmIndex::insert(int key, const RecordId& rid)
+{
+	Entry entry;
+	entry.key = key;
+	entry.rid = rid;
+	memtable.push_back(entry);
+
+	if((int)memtable.size() >= MEMTABLE_ENTRIES) return flush();
+	return 0;
+}
+
+RC LsmIndex::openRun(int id, int level, Run& run)
+{
+	RC error;
+	char page[PageFile::PAGE_SIZE];
+
+	run.id = id;
+	run.level = level;
+	if((error = run.pf.open(runName(id), 'r'))!=0) return error;
+	if((error = run.pf.read(0, page))!=0) return error;
+
+	run.entries = getField(page, RUN_ENTRIES);
+	run.dataPages = getField(page, RUN_DATA_PAGES);
+	run.fencePages = getField(page, RUN_FENCE_PAGES);
+	run.bloomPages = getField(page, RUN_BLOOM_PAGES);
+	run.minKey = getField(page, RUN_MIN_KEY);
+	run.maxKey = getField(page, RUN_MAX_KEY);
+	run.fenceKeys.clear();
+	for(int i=0; i<run.fencePages; i++) run.fenceKeys.push_back(getField(page, RUN_HEADER_FIELDS+i));
+	return 0;
+}
+
+RC LsmIndex::writeManifest()
+{
+	char page[PageFile::PAGE_SIZE];
+
+	if((int)runs.size() > MAX_RUNS) return RC_NODE_FULL;
+	memset(page, 0, PageFile::PAGE_SIZE);
+	setField(page, 0, runs.size());
+	setField(page, 1, nextRunId);
+	for(unsigned i=0; i<runs.size(); i++)
+	{
+		setField(page, 2+2*i, runs[i].id);
+		setField(page, 3+2*i, runs[i].level);
+	}
+	return pf.write(0, page);
+}
+
+RC LsmIndex::writeRun(int level, int entries, LsmCursor* cursor, Run& run)
+{
+	RC error;
+	PageFile out;
+	char page[PageFile::PAGE_SIZE];
+	int id = nextRunId++;
+
+	// a run is written once, from an empty file
+	::unlink(runName(id).c_str());
+	if((error = out.open(runName(id), 'w'))!=0) return error;
+
+	int bloomPages = max(1, (entries*BLOOM_BITS_PER_KEY + BLOOM_PAGE_BITS-1)/BLOOM_PAGE_BITS);
+	vector<char> bloom(bloomPages*PageFile::PAGE_SIZE, 0);
+	vector<int> fences;
+	int count = 0, minKey = 0, maxKey = 0;
+
+	// the data pages, sorted by key
+	memset(page, 0, PageFile::PAGE_SIZE);
+	for(int n=0; ; n++)
+	{
+		int key;
+		RecordId rid;
+		if(cursor==NULL)
+		{
+			if(n >= (int)memtable.size()) break;
+			key = memtable[n].key;
+			rid = memtable[n].rid;
+		}
+		else if(readForward(*cursor, key, rid)!=0) break;
+
+		if(count==0) minKey = key;
+		maxKey = key;
+		count++;
+
+		int eid = getField(page, 0);
+		if(eid==0) fences.push_back(key);
+		char* temp = page + sizeof(int) + eid*ENTRY_SIZE;
+		memcpy(temp, &key, sizeof(int));
+		memcpy(temp+sizeof(int), &rid, sizeof(RecordId));
+		setField(page, 0, eid+1);
+
+		char* bits = &bloom[bloomPage(key, bloomPages)*PageFile::PAGE_SIZE];
+		for(int i=0; i<BLOOM_HASHES; i++)
+		{
+			int bit = bloomBit(key, i);
+			bits[bit/8] |= 1 << (bit%8);
+		}
+
+		if(eid+1==DATA_CAPACITY)
+		{
+			if((error = out.write(fences.size(), page))!=0) return error;
+			memset(page, 0, PageFile::PAGE_SIZE);
+		}
+	}
+	if(getField(page, 0) > 0 && (error = out.write(fences.size(), page))!=0) return error;
+
+	int dataPages = fences.size();
+	int fencePages = (dataPages + FENCES_PER_PAGE-1)/FENCES_PER_PAGE;
+	if(fencePages > MAX_FENCE_PAGES) return RC_NODE_FULL;
+
+	// the sparse index: the first key of every data page
+	for(int i=0; i<fencePages; i++)
+	{
+		memset(page, 0, PageFile::PAGE_SIZE);
+		for(int j=0; j<FENCES_PER_PAGE && i*FENCES_PER_PAGE+j<dataPages; j++) setField(page, j, fences[i*FENCES_PER_PAGE+j]);
+		if((error = out.write(1+dataPages+i, page))!=0) return error;
+	}
+
+	for(int i=0; i<bloomPages; i++)
+		if((error = out.write(1+dataPages+fencePages+i, &bloom[i*PageFile::PAGE_SIZE]))!=0) return error;
+
+	// the header, with the first key of every fence page
+	memset(page, 0, PageFile::PAGE_SIZE);
+	setField(page, RUN_ENTRIES, count);
+	setField(page, RUN_DATA_PAGES, dataPages);
+	setField(page, RUN_FENCE_PAGES, fencePages);
+	setField(page, RUN_BLOOM_PAGES, bloomPages);
+	setField(page, RUN_MIN_KEY, minKey);
+	setField(page, RUN_MAX_KEY, maxKey);
+	for(int i=0; i<fencePages; i++) setField(page, RUN_HEADER_FIELDS+i, fences[i*FENCES_PER_PAGE]);
+	if((error = out.write(0, page))!=0) return error;
+	if((error = out.close())!=0) return error;
+
+	entryWrites += count;
+	return openRun(id, level, run);
+}
+
+RC LsmIndex::flush()
+{
+	RC error;
+	Run run;
+
+	if(memtable.empty()) return 0;
+	stable_sort(memtable.begin(), memtable.end(), LsmEntryOrder());
+	if((error = writeRun(0, memtable.size(), NULL, run))!=0) return error;
+	memtable.clear();
+
+	// the newest run goes last
+	runs.push_back(run);
+	if((error = compact())!=0) return error;
+	return writeManifest();
+}
+
+RC LsmIndex::compact()
+{
+	RC error;
+	long capacity = (long)L0_RUNS*MEMTABLE_ENTRIES;
+
+	for(int level=0; ; level++, capacity *= LEVEL_RATIO)
+	{
+		// the runs of level and level+1 are next to each other in runs,
+		// those of level+1 (older) first
+		int first = runs.size(), last = 0, count = 0;
+		long entries = 0, total = 0;
+		for(int i=0; i<(int)runs.size(); i++)
+		{
+			if(runs[i].level!=level && runs[i].level!=level+1) continue;
+			first = min(first, i);
+			last = i+1;
+			total += runs[i].entries;
+			if(runs[i].level==level) { count++; entries += runs[i].entries; }
+		}
+		if(count==0) break;
+		if(level==0 ? count<=L0_RUNS : entries<=capacity) break;
+
+		// merge the two levels into a new run on level+1
+		LsmCursor cursor(last-first);
+		for(int i=first; i<last; i++)
+		{
+			LsmRunCursor& c = cursor[i-first];
+			c.run = i;
+			c.pid = 1;
+			c.eid = c.count = 0;
+			if(runs[i].dataPages>0)
+			{
+				if((error = runs[i].pf.read(1, c.page))!=0) return error;
+				c.count = getField(c.page, 0);
+			}
+		}
+		Run run;
+		if((error = writeRun(level+1, total, &cursor, run))!=0) return error;
+
+		// the merged runs are no longer needed
+		for(int i=first; i<last; i++)
+		{
+			runs[i].pf.close();
+			::unlink(runName(runs[i].id).c_str());
+		}
+		runs.erase(runs.begin()+first, runs.begin()+last);
+		runs.insert(runs.begin()+first, run);
+	}
+	return 0;
+}
+
+RC LsmIndex::locate(int lo, int hi, LsmCursor& cursor)
+{
+	RC error;
+	char page[PageFile::PAGE_SIZE];
+
+	cursor.clear();
+	probed = 0;
+	for(int i=0; i<(int)runs.size(); i++)
+	{
+		Run& run = runs[i];
+		if(run.entries==0 || run.maxKey < lo || run.minKey > hi) continue;
+
+		// a single key: skip the run if its bloom filter rules the key out
+		if(lo==hi)
+		{
+			if((error = run.pf.read(1+run.dataPages+run.fencePages+bloomPage(lo, run.bloomPages), page))!=0) return error;
+			bool found = true;
+			for(int j=0; j<BLOOM_HASHES && found; j++)
+			{
+				int bit = bloomBit(lo, j);
+				found = (page[bit/8] >> (bit%8)) & 1;
+			}
+			if(!found) continue;
+		}
+		probed++;
+
+		// the last data page whose first key is below lo (the entries
+		// equal to lo may start at its end)
+		int dataPage = 0;
+		int fencePage = lower_bound(run.fenceKeys.begin(), run.fenceKeys.end(), lo) - run.fenceKeys.begin() - 1;
+		if(fencePage >= 0)
+		{
+			if((error = run.pf.read(1+run.dataPages+fencePage, page))!=0) return error;
+			int n = min(FENCES_PER_PAGE, run.dataPages - fencePage*FENCES_PER_PAGE);
+			int j = 0;
+			while(j < n && getField(page, j) < lo) j++;
+			dataPage = fencePage*FENCES_PER_PAGE + j - 1;
+		}
+
+		LsmRunCursor c;
+		c.run = i;
+		c.pid = 1+dataPage;
+		c.eid = 0;
+		if((error = run.pf.read(c.pid, c.page))!=0) return error;
+		c.count = getField(c.page, 0);
+
+		// skip the entries below lo
+		while(c.pid <= run.dataPages)
+		{
+			int key;
+			RecordId rid;
+			readEntry(c.page, c.eid, key, rid);
+			if(key >= lo) break;
+			if(++c.eid < c.count) continue;
+			c.eid = 0;
+			c.count = 0;
+			if(++c.pid <= run.dataPages)
+			{
+				if((error = run.pf.read(c.pid, c.page))!=0) return error;
+				c.count = getField(c.page, 0);
+			}
+		}
+		cursor.push_back(c);
+	}
+	return 0;
+}
+
+RC LsmIndex::readForward(LsmCursor& cursor, int& key, RecordId& rid)
+{
+	RC error;
+
+	// the smallest key; on a tie the run that comes first (the older one)
+	int best = -1;
+	for(int i=0; i<(int)cursor.size(); i++)
+	{
+		if(cursor[i].pid > runs[cursor[i].run].dataPages) continue;
+		int k;
+		RecordId r;
+		readEntry(cursor[i].page, cursor[i].eid, k, r);
+		if(best==-1 || k < key)
+		{
+			best = i;
+			key = k;
+			rid = r;
+		}
+	}
+	if(best==-1) return RC_END_OF_TREE;
+
+	LsmRunCursor& c = cursor[best];
+	if(++c.eid < c.count) return 0;
+	c.eid = 0;
+	c.count = 0;
+	if(++c.pid <= runs[c.run].dataPages)
+	{
+		if((error = runs[c.run].pf.read(c.pid, c.page))!=0) return error;
+		c.count = getField(c.page, 0);
+	}
+	return 0;
+}
@@ -0,0 +1,183 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/19/2026
+ */
+
+#ifndef LSMINDEX_H
+#define LSMINDEX_H
+
+#include <string>
+#include <vector>
+#include "Bruinbase.h"
+#include "PageFile.h"
+#include "RecordFile.h"
+
+/**
+ * The position of a merged scan over the runs of an LsmIndex: one cursor
+ * per run, each holding the data page it is in.
+ */
+struct LsmRunCursor {
+  int    run;                      // the run, as an index into the runs of the LsmIndex
+  PageId pid;                      // the current data page (past the last one if exhausted)
+  int    eid;                      // the next entry in the page
+  int    count;                    // the # of entries in the page
+  char   page[PageFile::PAGE_SIZE];
+};
+
+typedef std::vector<LsmRunCursor> LsmCursor;
+
+/**
+ * Implements a log-structured merge (LSM) index over the key column.
+ * Inserts go to an in-memory memtable. A full memtable is written out as
+ * an immutable run sorted by key, and runs are merged by leveled
+ * compaction: level 0 holds up to L0_RUNS runs, every deeper level a
+ * single run of at most LEVEL_RATIO times the size of the level above.
+ * A load into a big table then costs a few sequential writes per key
+ * instead of a random B+tree leaf read and write.
+ *
+ * Files: <name> lists the runs as |# runs|next run id|(run id, level)...|,
+ * and run n is stored in <name>.n as
+ *   page 0:        |# entries|# data pages|# fence pages|# bloom pages|
+ *                  |min key|max key|first key of each fence page...|
+ *   data pages:    |# entries|(key, rid)...| sorted by key
+ *   fence pages:   the first key of every data page (the sparse index)
+ *   bloom pages:   a blocked bloom filter: a key sets BLOOM_HASHES bits of
+ *                  one page, so an equality probe reads a single page
+ * A lookup reads the header, one fence page and the data pages of each
+ * run that can hold the key (for equality, the bloom filter rules out the
+ * other runs).
+ */
+class LsmIndex {
+ public:
+  static const int MEMTABLE_ENTRIES = 16384; // keys kept in memory before a flush
+  static const int L0_RUNS = 4;              // runs on level 0 before a compaction
+  static const int LEVEL_RATIO = 10;         // size ratio of consecutive levels
+  static const int BLOOM_BITS_PER_KEY = 10;
+  static const int BLOOM_HASHES = 7;
+
+  LsmIndex();
+
+  /**
+   * Open the index in read or write mode.
+   * Under 'w' mode, the index is created if it does not exist.
+   * @param indexname[IN] the name of the index file
+   * @param mode[IN] 'r' for read, 'w' for write
+   * @return error code. 0 if no error
+   */
+  RC open(const std::string& indexname, char mode);
+
+  /**
+   * Close the index. Under 'w' mode the memtable is flushed first.
+   * @return error code. 0 if no error
+   */
+  RC close();
+
+  /**
+   * Insert (key, RecordId) pair to the index.
+   * @param key[IN] the key of the record
+   * @param rid[IN] the RecordId for the record being inserted into the index
+   * @return error code. 0 if no error
+   */
+  RC insert(int key, const RecordId& rid);
+
+  /**
+   * Write the memtable as a new run on level 0 and compact the levels.
+   * @return error code. 0 if no error
+   */
+  RC flush();
+
+  /**
+   * Position the cursor on the first entry with a key >= lo, over all the
+   * runs that can hold a key in [lo, hi].
+   * @param lo[IN] the smallest key to return
+   * @param hi[IN] the largest key the caller is interested in
+   * @param cursor[OUT] the merged cursor
+   * @return error code. 0 if no error
+   */
+  RC locate(int lo, int hi, LsmCursor& cursor);
+
+  /**
+   * Read the entry with the smallest key among all runs and move the cursor
+   * past it. Entries with the same key come out in the order they were
+   * inserted.
+   * @param cursor[IN/OUT] the merged cursor
+   * @param key[OUT] the key of the entry
+   * @param rid[OUT] the RecordId of the entry
+   * @return error code. RC_END_OF_TREE if there are no more entries
+   */
+  RC readForward(LsmCursor& cursor, int& key, RecordId& rid);
+
+  /**
+   * @return the # of runs of the index
+   */
+  int getRunCount() const { return runs.size(); }
+
+  /**
+   * @return the # of runs the last locate() has to read
+   */
+  int getProbedRunCount() const { return probed; }
+
+  /**
+   * @return the # of entries written to runs since open(), by flushes
+   *         and compactions (divided by the inserts: write amplification)
+   */
+  int getEntryWriteCount() const { return entryWrites; }
+
+ private:
+  struct Run {
+    int      id;
+    int      level;
+    int      entries;
+    int      dataPages;
+    int      fencePages;
+    int      bloomPages;
+    int      minKey;
+    int      maxKey;
+    std::vector<int> fenceKeys; // the first key of every fence page
+    PageFile pf;
+  };
+
+  struct Entry {
+    int      key;
+    RecordId rid;
+  };
+
+  /**
+   * Merge every level that is over its size into the next one.
+   */
+  RC compact();
+
+  /**
+   * Write the sorted entries of cursor (or of memtable if cursor is NULL)
+   * into a new run on level.
+   */
+  RC writeRun(int level, int entries, LsmCursor* cursor, Run& run);
+
+  /**
+   * Open run file id and read its header.
+   */
+  RC openRun(int id, int level, Run& run);
+
+  /**
+   * Write the list of runs to the index file.
+   */
+  RC writeManifest();
+
+  /**
+   * @return the name of the file of run id
+   */
+  std::string runName(int id) const;
+
+  std::string name;          /// the name of the index file
+  char     mode;             /// 'r' or 'w'
+  PageFile pf;               /// the index file: the list of runs
+  std::vector<Run> runs;     /// the runs, oldest first (deeper levels are older)
+  int      nextRunId;        /// the id of the next run to write
+  std::vector<Entry> memtable; /// the inserts not written to a run yet
+  int      probed;           /// # runs read by the last locate()
+  int      entryWrites;      /// # entries written to runs since open()
+};
+
+#endif /* LSMINDEX_H */
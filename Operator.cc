@@ -0,0 +1,562 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/19/2026
+ */
+
+#include "Operator.h"
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+
+void RowBatch::select(const int* sel, int n)
+{
+	for (int j = 0; j < n; j++) {
+		int i = sel[j];
+		if (i == j) continue;
+		keys[j] = keys[i];
+		rids[j] = rids[i];
+		complete[j] = complete[i];
+		values[j].swap(values[i]);
+	}
+	count = n;
+}
+
+RC Operator::count(int& n)
+{
+	RC rc;
+	RowBatch* batch = new RowBatch;
+
+	n = 0;
+	while ((rc = next(*batch)) == 0) n += batch->count;
+	delete batch;
+	return rc == RC_END_OF_TREE ? 0 : rc;
+}
+
+TableScan::TableScan(const RecordFile& rf, bool needValue)
+  : rf(rf), needValue(needValue), pid(0)
+{
+}
+
+RC TableScan::next(RowBatch& batch)
+{
+	RC rc;
+	int n;
+
+	PageId endPid = rf.endRid().pid + (rf.endRid().sid > 0 ? 1 : 0);
+	batch.count = 0;
+	batch.hasKeys = true;
+
+	// whole pages, as many as fit in the batch
+	for (; pid < endPid && batch.count + RecordFile::RECORDS_PER_PAGE <= RowBatch::CAPACITY; pid++) {
+		int* keys = batch.keys + batch.count;
+		if (needValue) rc = rf.readRecords(pid, keys, batch.values + batch.count, n);
+		else rc = rf.readKeys(pid, keys, n);
+		if (rc != 0) return rc;
+
+		for (int i = 0; i < n; i++) {
+			batch.rids[batch.count + i].pid = pid;
+			batch.rids[batch.count + i].sid = i;
+			batch.complete[batch.count + i] = needValue;
+		}
+		batch.count += n;
+	}
+	return batch.count > 0 ? 0 : RC_END_OF_TREE;
+}
+
+IndexScan::IndexScan(BTreeIndex& tree, const KeyRanges& ranges)
+  : tree(tree), ranges(ranges), current(0), started(false), done(false)
+{
+}
+
+RC IndexScan::next(RowBatch& batch)
+{
+	int key;
+
+	batch.count = 0;
+	batch.hasKeys = true;
+	if (!started) {
+		started = true;
+		done = ranges.isEmpty();
+		if (!done) tree.locate(ranges[0].lo, cursor);
+	}
+
+	// a read error is the end of the leaf chain, as the other scans do
+	while (!done && batch.count < RowBatch::CAPACITY) {
+		int i = batch.count;
+		if (tree.readForward(cursor, key, batch.rids[i], batch.values[i], batch.complete[i]) != 0) {
+			done = true;
+			break;
+		}
+
+		// past the range: on to the first range that can hold the key,
+		// locating the cursor again if the key is before it
+		if (key > ranges[current].hi) {
+			while (current < ranges.size() && key > ranges[current].hi) current++;
+			if (current == ranges.size()) {
+				done = true;
+				break;
+			}
+			if (key < ranges[current].lo) {
+				tree.locate(ranges[current].lo, cursor);
+				continue;
+			}
+		}
+		batch.keys[i] = key;
+		batch.count++;
+	}
+	return batch.count > 0 ? 0 : RC_END_OF_TREE;
+}
+
+RC IndexScan::count(int& n)
+{
+	int rangeCount;
+
+	n = 0;
+	if (started) return Operator::count(n);
+	started = done = true;
+
+	for (int i = 0; i < ranges.size(); i++) {
+		tree.countRange(ranges[i].lo, ranges[i].hi, rangeCount);
+		n += rangeCount;
+	}
+	return 0;
+}
+
+BackwardIndexScan::BackwardIndexScan(BTreeIndex& tree, const KeyRanges& ranges)
+  : tree(tree), ranges(ranges), current(ranges.size()-1), batchSize(1), started(false), done(false)
+{
+}
+
+RC BackwardIndexScan::next(RowBatch& batch)
+{
+	int key;
+
+	batch.count = 0;
+	batch.hasKeys = true;
+	if (!started) {
+		started = true;
+		done = ranges.isEmpty();
+		if (!done) tree.locateBackward(ranges[current].hi, cursor);
+	}
+
+	int size = batchSize;
+	batchSize = min(2*batchSize, (int) RowBatch::CAPACITY);
+	while (!done && batch.count < size) {
+		int i = batch.count;
+		if (tree.readBackward(cursor, key, batch.rids[i]) != 0) {
+			done = true;
+			break;
+		}
+
+		// before the range: back to the first range that can hold the key,
+		// locating the cursor again if the key is past it
+		if (key < ranges[current].lo) {
+			while (current >= 0 && key < ranges[current].lo) current--;
+			if (current < 0) {
+				done = true;
+				break;
+			}
+			if (key > ranges[current].hi) {
+				tree.locateBackward(ranges[current].hi, cursor);
+				continue;
+			}
+		}
+		batch.keys[i] = key;
+		batch.complete[i] = false;
+		batch.count++;
+	}
+	return batch.count > 0 ? 0 : RC_END_OF_TREE;
+}
+
+InListScan::InListScan(BTreeIndex& tree, const vector<int>& keys)
+  : tree(tree), keys(keys), current(-1)
+{
+}
+
+RC InListScan::next(RowBatch& batch)
+{
+	int key;
+
+	batch.count = 0;
+	batch.hasKeys = true;
+	if (current < 0) {
+		current = 0;
+		cursors.resize(keys.size());
+		if (keys.empty() || tree.locateMany(&keys[0], keys.size(), &cursors[0]) != 0) current = keys.size();
+	}
+
+	// the entries of keys[current] start at its cursor
+	while (current < (int) keys.size() && batch.count < RowBatch::CAPACITY) {
+		int i = batch.count;
+		if (tree.readForward(cursors[current], key, batch.rids[i], batch.values[i], batch.complete[i]) != 0 ||
+		    key != keys[current]) {
+			current++;
+			continue;
+		}
+		batch.keys[i] = key;
+		batch.count++;
+	}
+	return batch.count > 0 ? 0 : RC_END_OF_TREE;
+}
+
+HashLookup::HashLookup(HashIndex& htree, int key)
+  : htree(htree), key(key), pos(-1)
+{
+}
+
+RC HashLookup::next(RowBatch& batch)
+{
+	batch.count = 0;
+	batch.hasKeys = true;
+	if (pos < 0) {
+		pos = 0;
+		htree.lookup(key, rids);
+	}
+
+	// all entries found have the key looked up
+	for (; pos < (int) rids.size() && batch.count < RowBatch::CAPACITY; pos++, batch.count++) {
+		batch.keys[batch.count] = key;
+		batch.rids[batch.count] = rids[pos];
+		batch.complete[batch.count] = false;
+	}
+	return batch.count > 0 ? 0 : RC_END_OF_TREE;
+}
+
+ValueIndexScan::ValueIndexScan(ValueIndex& vtree, const string& lo, const char* hi, bool hiIncl, const string& prefix)
+  : vtree(vtree), lo(lo), hi(hi), hiIncl(hiIncl), prefix(prefix), started(false), done(false)
+{
+}
+
+RC ValueIndexScan::next(RowBatch& batch)
+{
+	int diff;
+
+	batch.count = 0;
+	batch.hasKeys = false;
+	if (!started) {
+		started = true;
+		vtree.locate(lo, cursor);
+	}
+
+	while (!done && batch.count < RowBatch::CAPACITY) {
+		int i = batch.count;
+		if (vtree.readForward(cursor, batch.values[i], batch.rids[i]) != 0) {
+			done = true;
+			break;
+		}
+
+		// values are sorted: stop at the first value past the range
+		const string& value = batch.values[i];
+		if (hi != NULL) {
+			diff = strcmp(value.c_str(), hi);
+			if (diff > 0 || (diff == 0 && !hiIncl)) {
+				done = true;
+				break;
+			}
+		}
+		if (value.compare(0, prefix.size(), prefix) > 0) {
+			done = true;
+			break;
+		}
+		batch.complete[i] = true;
+		batch.count++;
+	}
+	return batch.count > 0 ? 0 : RC_END_OF_TREE;
+}
+
+/*
+ * Position cursor at the first entry of an index that can have a key
+ * >= lo (and, for the LSM index, <= hi).
+ * @return false if the index has no such entry
+ */
+static bool locateRange(LsmIndex& index, int lo, int hi, LsmCursor& cursor)
+{
+	return index.locate(lo, hi, cursor) == 0;
+}
+
+static bool locateRange(LearnedIndex& index, int lo, int, IndexCursor& cursor)
+{
+	RC rc = index.locate(lo, cursor);
+	return rc == 0 || rc == RC_NO_SUCH_RECORD;
+}
+
+static bool locateRange(ArtIndex& index, int lo, int, int& cursor)
+{
+	index.locate(lo, cursor);
+	return true;
+}
+
+/*
+ * Count the entries with lo <= key <= hi of an index that can.
+ * @return false if the index cannot count them
+ */
+template <class Index>
+static bool countRange(Index&, int, int, int&)
+{
+	return false;
+}
+
+static bool countRange(ArtIndex& index, int lo, int hi, int& n)
+{
+	n = index.countRange(lo, hi);
+	return true;
+}
+
+template <class Index, class Cursor>
+KeyRangeScan<Index, Cursor>::KeyRangeScan(Index& index, const KeyRanges& ranges)
+  : index(index), ranges(ranges), current(-1), done(false)
+{
+}
+
+template <class Index, class Cursor>
+RC KeyRangeScan<Index, Cursor>::next(RowBatch& batch)
+{
+	batch.count = 0;
+	batch.hasKeys = true;
+
+	while (!done && batch.count < RowBatch::CAPACITY) {
+		int i = batch.count;
+
+		// the first range, or the next one after an entry past the range
+		if (current < 0 || index.readForward(cursor, batch.keys[i], batch.rids[i]) != 0 ||
+		    batch.keys[i] > ranges[current].hi) {
+			do current++;
+			while (current < ranges.size() && !locateRange(index, ranges[current].lo, ranges[current].hi, cursor));
+			done = (current >= ranges.size());
+			continue;
+		}
+		batch.complete[i] = false;
+		batch.count++;
+	}
+	return batch.count > 0 ? 0 : RC_END_OF_TREE;
+}
+
+template <class Index, class Cursor>
+RC KeyRangeScan<Index, Cursor>::count(int& n)
+{
+	int rangeCount;
+
+	n = 0;
+	if (current >= 0 || ranges.isEmpty() || !countRange(index, ranges[0].lo, ranges[0].hi, n)) return Operator::count(n);
+	current = ranges.size();
+	done = true;
+
+	for (int i = 1; i < ranges.size(); i++) {
+		countRange(index, ranges[i].lo, ranges[i].hi, rangeCount);
+		n += rangeCount;
+	}
+	return 0;
+}
+
+template class KeyRangeScan<LsmIndex, LsmCursor>;
+template class KeyRangeScan<LearnedIndex, IndexCursor>;
+template class KeyRangeScan<ArtIndex, int>;
+
+Fetch::Fetch(Operator* input, const RecordFile& rf, bool needKey, bool needValue, bool sorted)
+  : input(input), rf(rf), needKey(needKey), needValue(needValue), sorted(sorted), fetched(false), pos(0)
+{
+}
+
+Fetch::~Fetch()
+{
+	delete input;
+}
+
+// orders the positions of entries by RecordId (by page, then slot)
+struct Fetch::ByRecordId {
+	const vector<Entry>& entries;
+	ByRecordId(const vector<Entry>& entries) : entries(entries) {}
+	bool operator()(int a, int b) const { return entries[a].rid < entries[b].rid; }
+};
+
+RC Fetch::fetchAll()
+{
+	RC rc;
+	RowBatch* batch = new RowBatch;
+
+	fetched = true;
+	while ((rc = input->next(*batch)) == 0) {
+		for (int i = 0; i < batch->count; i++) {
+			Entry entry;
+			entry.key = batch->keys[i];
+			entry.rid = batch->rids[i];
+			entry.value.swap(batch->values[i]);
+			entry.complete = batch->complete[i] || !needValue;
+			if (needKey && !batch->hasKeys) entry.complete = false;
+			entries.push_back(entry);
+		}
+	}
+	delete batch;
+	if (rc != RC_END_OF_TREE) return rc;
+
+	vector<int> order; // the entries whose record has to be read
+	for (unsigned i = 0; i < entries.size(); i++)
+		if (!entries[i].complete) order.push_back(i);
+	sort(order.begin(), order.end(), ByRecordId(entries));
+
+	for (unsigned i = 0; i < order.size(); i++) {
+		Entry& entry = entries[order[i]];
+		if ((rc = rf.read(entry.rid, entry.key, entry.value)) < 0) return rc;
+		entry.complete = true;
+	}
+	return 0;
+}
+
+RC Fetch::next(RowBatch& batch)
+{
+	RC rc;
+
+	if (sorted) {
+		if (!fetched && (rc = fetchAll()) != 0) return rc;
+		batch.count = 0;
+		batch.hasKeys = true;
+		for (; pos < entries.size() && batch.count < RowBatch::CAPACITY; pos++, batch.count++) {
+			batch.keys[batch.count] = entries[pos].key;
+			batch.rids[batch.count] = entries[pos].rid;
+			batch.values[batch.count].swap(entries[pos].value);
+			batch.complete[batch.count] = true;
+		}
+		return batch.count > 0 ? 0 : RC_END_OF_TREE;
+	}
+
+	if ((rc = input->next(batch)) != 0) return rc;
+	bool readAll = (needKey && !batch.hasKeys);
+	for (int i = 0; i < batch.count; i++) {
+		if (!readAll && (batch.complete[i] || !needValue)) continue;
+		if ((rc = rf.read(batch.rids[i], batch.keys[i], batch.values[i])) < 0) return rc;
+		batch.complete[i] = true;
+	}
+	if (readAll) batch.hasKeys = true;
+	return 0;
+}
+
+Filter::Filter(Operator* input, const vector<SelCond>& cond, const TableStats* stats)
+  : input(input), predicate(cond, stats)
+{
+}
+
+Filter::~Filter()
+{
+	delete input;
+}
+
+RC Filter::next(RowBatch& batch)
+{
+	RC rc;
+
+	if (predicate.isEmpty()) return RC_END_OF_TREE;
+	while ((rc = input->next(batch)) == 0) {
+		if (predicate.getTestCount() == 0) return 0;
+		for (int i = 0; i < batch.count; i++) sel[i] = i;
+		batch.select(sel, predicate.apply(batch, sel, batch.count));
+		if (batch.count > 0) return 0;
+	}
+	return rc;
+}
+
+Limit::Limit(Operator* input, int limit)
+  : input(input), left(limit)
+{
+}
+
+Limit::~Limit()
+{
+	delete input;
+}
+
+RC Limit::next(RowBatch& batch)
+{
+	RC rc;
+
+	if (left <= 0) return RC_END_OF_TREE;
+	if ((rc = input->next(batch)) != 0) return rc;
+	batch.count = min(batch.count, left);
+	left -= batch.count;
+	return 0;
+}
+
+Project::Project(Operator* input, int attr)
+  : input(input), attr(attr)
+{
+}
+
+Project::~Project()
+{
+	delete input;
+}
+
+RC Project::next(RowBatch& batch)
+{
+	RC rc;
+
+	if ((rc = input->next(batch)) != 0) return rc;
+	for (int i = 0; i < batch.count; i++) {
+		switch (attr) {
+			case 1:  // SELECT key
+				fprintf(stdout, "%d\n", batch.keys[i]);
+				break;
+			case 2:  // SELECT value
+				fprintf(stdout, "%s\n", batch.values[i].c_str());
+				break;
+			case 3:  // SELECT *
+				fprintf(stdout, "%d '%s'\n", batch.keys[i], batch.values[i].c_str());
+				break;
+		}
+	}
+	return 0;
+}
+
+Count::Count(Operator* input)
+  : input(input), total(0)
+{
+}
+
+Count::~Count()
+{
+	delete input;
+}
+
+RC Count::next(RowBatch& batch)
+{
+	RC rc;
+
+	if ((rc = input->next(batch)) != 0) return rc;
+	total += batch.count;
+	return 0;
+}
+
+RC Count::count(int& n)
+{
+	RC rc;
+
+	if ((rc = input->count(n)) != 0) return rc;
+	total += n;
+	return 0;
+}
+
+MaxKey::MaxKey(Operator* input, bool descending)
+  : input(input), descending(descending), found(false), max(0)
+{
+}
+
+MaxKey::~MaxKey()
+{
+	delete input;
+}
+
+RC MaxKey::next(RowBatch& batch)
+{
+	RC rc;
+
+	if (found && descending) return RC_END_OF_TREE;
+	if ((rc = input->next(batch)) != 0) return rc;
+	for (int i = 0; i < batch.count; i++) {
+		if (!found || batch.keys[i] > max) max = batch.keys[i];
+		found = true;
+	}
+	return 0;
+}
@@ -0,0 +1,335 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/19/2026
+ */
+
+#ifndef OPERATOR_H
+#define OPERATOR_H
+
+#include <string>
+#include <vector>
+#include "Bruinbase.h"
+#include "RecordFile.h"
+#include "SqlEngine.h"
+#include "BTreeIndex.h"
+#include "ValueIndex.h"
+#include "HashIndex.h"
+#include "LsmIndex.h"
+#include "LearnedIndex.h"
+#include "ArtIndex.h"
+#include "Predicate.h"
+
+/**
+ * A batch of up to CAPACITY rows, passed from operator to operator. Every
+ * column is an array, so an operator works through a column in one tight
+ * loop. A row read from an index may lack its value (complete[i] false),
+ * and the rows of a value index lack their keys (hasKeys false) until a
+ * Fetch reads their records.
+ */
+struct RowBatch {
+  static const int CAPACITY = 1024;
+
+  int  count;                   // # rows in the batch
+  bool hasKeys;                 // whether keys[] holds the keys of the rows
+  int  keys[CAPACITY];
+  RecordId rids[CAPACITY];
+  bool complete[CAPACITY];      // whether values[i] holds the value of row i
+  std::string values[CAPACITY];
+
+  /**
+   * Keep only the n rows at the positions in sel (in increasing order).
+   */
+  void select(const int* sel, int n);
+};
+
+/**
+ * An operator of a query plan: it produces its rows a batch at a time,
+ * pulling batches from the operator below it, if any. An operator owns
+ * (and deletes) the operator below it.
+ */
+class Operator {
+ public:
+  virtual ~Operator() {}
+
+  /**
+   * Produce the next batch of rows.
+   * @param batch[OUT] the rows, at least one
+   * @return error code. RC_END_OF_TREE after the last batch
+   */
+  virtual RC next(RowBatch& batch) = 0;
+
+  /**
+   * Count the rows left without producing them. Operators that can count
+   * faster than they produce (from an index) override it.
+   * @param n[OUT] the # of rows
+   * @return error code. 0 if no error
+   */
+  virtual RC count(int& n);
+};
+
+/**
+ * Reads every record of a table in RecordId order, a page at a time. The
+ * values are read only if needed.
+ */
+class TableScan : public Operator {
+ public:
+  TableScan(const RecordFile& rf, bool needValue);
+  RC next(RowBatch& batch);
+
+ private:
+  const RecordFile& rf;
+  bool   needValue;
+  PageId pid;       /// the next page to read
+};
+
+/**
+ * Reads the entries of a B+tree index with keys in the ranges, in key
+ * order, with their values if the index includes them. The cursor goes on
+ * from one range to the next as long as the entries it reads are in it,
+ * and is located again at a range that starts past them. count() is taken
+ * from the subtree counts of the index.
+ */
+class IndexScan : public Operator {
+ public:
+  IndexScan(BTreeIndex& tree, const KeyRanges& ranges);
+  RC next(RowBatch& batch);
+  RC count(int& n);
+
+ private:
+  BTreeIndex& tree;
+  KeyRanges ranges;
+  int  current;     /// the range being read
+  IndexCursor cursor;
+  bool started;     /// whether the cursor was located
+  bool done;        /// whether the last entry of the ranges was read
+};
+
+/**
+ * Reads the entries of a B+tree index with keys in the ranges, in
+ * descending key order, from the end of the last range back along the
+ * previous-leaf links. The rows lack their values. The batches start at
+ * a single row and double, so that a query that stops at its first row
+ * that meets the conditions, as max(key) does, reads only the last leaves
+ * (and records) before it.
+ */
+class BackwardIndexScan : public Operator {
+ public:
+  BackwardIndexScan(BTreeIndex& tree, const KeyRanges& ranges);
+  RC next(RowBatch& batch);
+
+ private:
+  BTreeIndex& tree;
+  KeyRanges ranges;
+  int  current;     /// the range being read
+  IndexCursor cursor;
+  int  batchSize;   /// the most rows of the next batch
+  bool started;     /// whether the cursor was located
+  bool done;        /// whether the first entry of the ranges was read
+};
+
+/**
+ * Reads the entries of a B+tree index with one of the given keys (sorted
+ * and distinct), located with one batched descent of the tree.
+ */
+class InListScan : public Operator {
+ public:
+  InListScan(BTreeIndex& tree, const std::vector<int>& keys);
+  RC next(RowBatch& batch);
+
+ private:
+  BTreeIndex& tree;
+  std::vector<int> keys;
+  std::vector<IndexCursor> cursors;  /// the cursor of every key
+  int  current;     /// the key being read; -1 before the lookup
+};
+
+/**
+ * Reads the entries of a hash index with the given key.
+ */
+class HashLookup : public Operator {
+ public:
+  HashLookup(HashIndex& htree, int key);
+  RC next(RowBatch& batch);
+
+ private:
+  HashIndex& htree;
+  int  key;
+  std::vector<RecordId> rids;
+  int  pos;         /// the next entry of rids; -1 before the lookup
+};
+
+/**
+ * Reads the entries of a value index in value order, from the first value
+ * >= lo up to hi (included if hiIncl, unbounded if NULL), as long as the
+ * values start with prefix. The rows have their values but no keys.
+ */
+class ValueIndexScan : public Operator {
+ public:
+  ValueIndexScan(ValueIndex& vtree, const std::string& lo, const char* hi, bool hiIncl, const std::string& prefix);
+  RC next(RowBatch& batch);
+
+ private:
+  ValueIndex& vtree;
+  std::string lo;
+  const char* hi;
+  bool hiIncl;
+  std::string prefix;
+  IndexCursor cursor;
+  bool started;
+  bool done;
+};
+
+/**
+ * Reads the (key, RecordId) entries with keys in the ranges, in key order,
+ * of an index that is read with locate() and readForward(): the LSM index
+ * (Index = LsmIndex), the learned index (LearnedIndex) and the in-memory
+ * index (ArtIndex). The cursor is located at the start of every range, as
+ * the LSM index only merges the runs that overlap the range it is located
+ * for. count() is taken from the index if it can count ranges.
+ */
+template <class Index, class Cursor>
+class KeyRangeScan : public Operator {
+ public:
+  KeyRangeScan(Index& index, const KeyRanges& ranges);
+  RC next(RowBatch& batch);
+  RC count(int& n);
+
+ private:
+  Index& index;
+  KeyRanges ranges;
+  int  current;     /// the range being read; -1 before the first one
+  Cursor cursor;
+  bool done;
+};
+
+/**
+ * Completes the rows of its input: reads the records of the rows that
+ * lack the value (if needValue) or the key (if needKey). With sorted,
+ * it reads all rows of its input first, and their records in RecordId
+ * order, so that every table page is read once; the rows still come out
+ * in the order of the input.
+ */
+class Fetch : public Operator {
+ public:
+  Fetch(Operator* input, const RecordFile& rf, bool needKey, bool needValue, bool sorted);
+  ~Fetch();
+  RC next(RowBatch& batch);
+
+ private:
+  // a row of the input, with its value once its record is read
+  struct Entry {
+    int key;
+    RecordId rid;
+    std::string value;
+    bool complete;
+  };
+  struct ByRecordId; // orders entries by RecordId, see Operator.cc
+
+  /**
+   * Read all rows of the input into entries, and their records in
+   * RecordId order.
+   */
+  RC fetchAll();
+
+  Operator* input;
+  const RecordFile& rf;
+  bool needKey, needValue;
+  bool sorted;
+  bool fetched;                 /// whether fetchAll() was run
+  std::vector<Entry> entries;   /// sorted: the rows, in input order
+  unsigned pos;                 /// sorted: the next entry to produce
+};
+
+/**
+ * Keeps the rows that meet all conditions, compiled once into a Predicate
+ * whose tests each run on the whole batch, on the rows still kept.
+ */
+class Filter : public Operator {
+ public:
+  Filter(Operator* input, const std::vector<SelCond>& cond, const TableStats* stats);
+  ~Filter();
+  RC next(RowBatch& batch);
+
+ private:
+  Operator* input;
+  Predicate predicate;
+  int sel[RowBatch::CAPACITY];  /// the positions of the rows kept
+};
+
+/**
+ * Produces the first limit rows of its input and stops reading it.
+ */
+class Limit : public Operator {
+ public:
+  Limit(Operator* input, int limit);
+  ~Limit();
+  RC next(RowBatch& batch);
+
+ private:
+  Operator* input;
+  int left;         /// # rows still to produce
+};
+
+/**
+ * Prints the rows of its input on screen: the key (attr 1), the value
+ * (attr 2) or both (attr 3), as SELECT does, and passes them on.
+ */
+class Project : public Operator {
+ public:
+  Project(Operator* input, int attr);
+  ~Project();
+  RC next(RowBatch& batch);
+
+ private:
+  Operator* input;
+  int attr;
+};
+
+/**
+ * Counts the rows of its input as they pass, or with count() all of them
+ * at once, from the index if the input can.
+ */
+class Count : public Operator {
+ public:
+  Count(Operator* input);
+  ~Count();
+  RC next(RowBatch& batch);
+  RC count(int& n);
+
+  /**
+   * @return the # of rows counted so far
+   */
+  int getCount() const { return total; }
+
+ private:
+  Operator* input;
+  int total;
+};
+
+/**
+ * Keeps the largest key of the rows of its input as they pass. If the
+ * input is in descending key order, that is the key of its first row,
+ * and the input is not read any further.
+ */
+class MaxKey : public Operator {
+ public:
+  MaxKey(Operator* input, bool descending);
+  ~MaxKey();
+  RC next(RowBatch& batch);
+
+  /**
+   * @param key[OUT] the largest key so far
+   * @return whether any row has passed
+   */
+  bool getMax(int& key) const { key = max; return found; }
+
+ private:
+  Operator* input;
+  bool descending;
+  bool found;
+  int  max;
+};
+
+#endif /* OPERATOR_H */
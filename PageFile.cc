@@ -12,6 +12,7 @@
 #include <cstring>
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/file.h>
 #include <unistd.h>
 
 using std::string;
@@ -25,12 +26,16 @@ PageFile::PageFile()
 { 
   fd = -1; 
   epid = 0; 
+  writeBufferSize = 0;
+  coalescedCount = 0;
 }
 
 PageFile::PageFile(const string& filename, char mode)
 {
   fd = -1;
   epid = 0;
+  writeBufferSize = 0;
+  coalescedCount = 0;
   open(filename.c_str(), mode);
 }
 
@@ -60,18 +65,28 @@ RC PageFile::open(const string& filename, char mode)
   fd = ::open(filename.c_str(), oflag, 0644);
   if (fd < 0) { fd = -1; return RC_FILE_OPEN_FAILED; }
 
+  // only one writer at a time; readers never take the lock
+  if (oflag != O_RDONLY && ::flock(fd, LOCK_EX) < 0) {
+    ::close(fd); fd = -1; return RC_FILE_OPEN_FAILED;
+  }
+
   // get the size of the file to set the end pid
   rc = ::fstat(fd, &statbuf);
   if (rc < 0) { ::close(fd); fd = -1; return RC_FILE_OPEN_FAILED; }
   epid = statbuf.st_size / PAGE_SIZE;
+  coalescedCount = 0;
 
   return 0;
 }
 
 RC PageFile::close()
 {
+  RC rc;
   if (fd <= 0) return RC_FILE_CLOSE_FAILED;
 
+  // write the pages still in the write buffer
+  if ((rc = flush()) < 0) return rc;
+
   // close the file
   if (::close(fd) < 0) return RC_FILE_CLOSE_FAILED;
 
@@ -90,6 +105,12 @@ RC PageFile::close()
   return 0;
 }
 
+bool PageFile::sameFileVersion(const struct stat& a, const struct stat& b)
+{
+  return a.st_dev == b.st_dev && a.st_ino == b.st_ino && a.st_size == b.st_size &&
+         a.st_mtim.tv_sec == b.st_mtim.tv_sec && a.st_mtim.tv_nsec == b.st_mtim.tv_nsec;
+}
+
 PageId PageFile::endPid() const 
 {
   return epid;
@@ -100,11 +121,75 @@ RC PageFile::seek(PageId pid) const
   return (::lseek(fd, pid * PAGE_SIZE, SEEK_SET) < 0) ? RC_FILE_SEEK_FAILED : 0;
 }
 
-RC PageFile::write(PageId pid, const void* buffer)
+void PageFile::setWriteBuffer(int pages)
+{
+  writeBufferSize = (pages > 0) ? pages : 0;
+}
+
+RC PageFile::flush()
 {
   RC rc;
+
+  // in the order of page ids, to keep the disk access sequential
+  std::map<PageId, dirtyPage>::iterator it;
+  for (it = dirtyPages.begin(); it != dirtyPages.end(); ++it) {
+    if ((rc = writePage(it->first, it->second.buffer)) < 0) return rc;
+  }
+  dirtyPages.clear();
+  lruOrder.clear();
+
+  return 0;
+}
+
+RC PageFile::write(PageId pid, const void* buffer)
+{
   if (pid < 0) return RC_INVALID_PID; 
 
+  // a new page goes to the disk right away (see setWriteBuffer())
+  std::map<PageId, dirtyPage>::iterator it = dirtyPages.find(pid);
+  if (writeBufferSize == 0 || pid >= epid) {
+    if (it != dirtyPages.end()) {
+      lruOrder.erase(it->second.lru);
+      dirtyPages.erase(it);
+    }
+    return writePage(pid, buffer);
+  }
+
+  if (it != dirtyPages.end()) {
+    coalescedCount++;
+    lruOrder.erase(it->second.lru);
+  } else {
+    // make room by writing the least recently written page
+    if ((int) dirtyPages.size() >= writeBufferSize) {
+      std::map<PageId, dirtyPage>::iterator toEvict = dirtyPages.find(lruOrder.front());
+      RC rc = writePage(toEvict->first, toEvict->second.buffer);
+      if (rc < 0) return rc;
+      dirtyPages.erase(toEvict);
+      lruOrder.pop_front();
+    }
+    it = dirtyPages.insert(std::make_pair(pid, dirtyPage())).first;
+  }
+  memcpy(it->second.buffer, buffer, PAGE_SIZE);
+  it->second.lru = lruOrder.insert(lruOrder.end(), pid);
+
+  // the disk copy is stale now: if the page is in read cache, invalidate it
+  for (int i = 0; i < CACHE_COUNT; i++) {
+    if (readCache[i].fd == fd && readCache[i].pid == pid &&
+        readCache[i].lastAccessed != 0) {
+       readCache[i].fd = 0;
+       readCache[i].pid = 0;
+       readCache[i].lastAccessed = 0;
+       break;
+    }
+  }
+
+  return 0;
+}
+
+RC PageFile::writePage(PageId pid, const void* buffer)
+{
+  RC rc;
+
   // seek to the location of the page
   if ((rc = seek(pid)) < 0) return rc;
 
@@ -135,7 +220,23 @@ RC PageFile::read(PageId pid, void* buffer) const
 {
   RC rc;
 
-  if (pid < 0 || pid >= epid) return RC_INVALID_PID; 
+  if (pid < 0) return RC_INVALID_PID;
+
+  // a page in the write buffer is newer than its copy on the disk
+  std::map<PageId, dirtyPage>::const_iterator dirty = dirtyPages.find(pid);
+  if (dirty != dirtyPages.end()) {
+    memcpy(buffer, dirty->second.buffer, PAGE_SIZE);
+    return 0;
+  }
+
+  // the file may have grown since it was opened if another process
+  // is writing to it: check its current size before giving up
+  if (pid >= epid) {
+    struct stat statbuf;
+    if (::fstat(fd, &statbuf) < 0) return RC_INVALID_PID;
+    epid = statbuf.st_size / PAGE_SIZE;
+    if (pid >= epid) return RC_INVALID_PID;
+  }
 
   //
   // if the page is in cache, read it from there
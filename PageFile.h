@@ -11,6 +11,9 @@
 #define PAGEFILE_H
 
 #include <string>
+#include <map>
+#include <list>
+#include <sys/stat.h>
 #include "Bruinbase.h"
 
 typedef int PageId;
@@ -58,6 +61,27 @@ class PageFile {
    * @return error code. 0 if no error
    */
   RC write(PageId pid, const void *buffer);
+
+  /**
+   * keep up to pages rewritten pages in memory, and write each of them
+   * to the disk once, when it is evicted (LRU) or the file is flushed or
+   * closed. pages that are new to the file are still written right away,
+   * so a page id stored on the disk always refers to an existing page.
+   * @param pages[IN] the max # of dirty pages to keep (0: write through)
+   */
+  void setWriteBuffer(int pages);
+
+  /**
+   * write all dirty pages to the disk.
+   * @return error code. 0 if no error
+   */
+  RC flush();
+
+  /**
+   * @return the # of writes to this file that replaced a dirty page in
+   *         the write buffer, and so never reached the disk
+   */
+  int getCoalescedWriteCount() const { return coalescedCount; }
     
   /**
    * note the +1 part. The last page id in the file is actually endPid()-1.
@@ -76,6 +100,16 @@ class PageFile {
    */
   static int getPageWriteCount() { return writeCount; }
 
+  /**
+   * whether two stat() results describe the same version of a file: the
+   * same file, not rewritten or extended in between. used by the caches
+   * that keep what they decoded from a file for as long as it is unchanged.
+   * @param a[IN] the stat() result of the file when it was read
+   * @param b[IN] the stat() result of the file now
+   * @return true if the file is unchanged
+   */
+  static bool sameFileVersion(const struct stat& a, const struct stat& b);
+
  protected:
   /**
    * move the file cursor to the beginning of a page.
@@ -85,9 +119,30 @@ class PageFile {
    */
   RC seek(PageId pid) const;
 
+  /**
+   * write a page to the disk, bypassing the write buffer.
+   * @param pid[IN] page to write to
+   * @param buffer[IN] the content to write
+   * @return error code. 0 if no error
+   */
+  RC writePage(PageId pid, const void *buffer);
+
  private:
   int     fd;     // file descriptor of the associated unix file
-  PageId  epid;   // (last page id + 1) of the file
+  mutable PageId epid; // (last page id + 1) of the file (a writer in another
+                       // process may extend the file, see read())
+
+  //
+  // the write buffer (see setWriteBuffer())
+  //
+  struct dirtyPage {
+    std::list<PageId>::iterator lru; // the position of the page in lruOrder
+    char buffer[PAGE_SIZE]; // the content not yet written to the disk
+  };
+  std::map<PageId, dirtyPage> dirtyPages;
+  std::list<PageId> lruOrder; // dirty page ids, least recently written first
+  int writeBufferSize;      // max # of dirty pages, 0 if writes go through
+  int coalescedCount;       // # of writes that replaced a dirty page
 
   //
   // the following set of members implement LRU caching 
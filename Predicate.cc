@@ -0,0 +1,368 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/19/2026
+ */
+
+#include "Predicate.h"
+#include "Operator.h"
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+#include <cmath>
+#include <algorithm>
+#include <iterator>
+
+using namespace std;
+
+/*
+ * SQL LIKE matching: '%' matches any sequence of characters, '_' any single character.
+ */
+static bool likeMatch(const char* s, const char* pattern)
+{
+	for (; *pattern; s++, pattern++) {
+		if (*pattern == '%') {
+			// try every possible length for the '%' wildcard
+			for (; ; s++) {
+				if (likeMatch(s, pattern+1)) return true;
+				if (*s == 0) return false;
+			}
+		}
+		if (*s == 0 || (*pattern != '_' && *pattern != *s)) return false;
+	}
+	return *s == 0;
+}
+
+// the comparisons of the value tests, for filterValues()
+struct ValueEq {
+	bool operator()(const string& v, const string& c) const
+	{
+		return v.size() == c.size() && memcmp(v.data(), c.data(), v.size()) == 0;
+	}
+};
+struct ValueNe {
+	bool operator()(const string& v, const string& c) const { return !ValueEq()(v, c); }
+};
+struct ValueLt {
+	bool operator()(const string& v, const string& c) const { return v.compare(c) < 0; }
+};
+struct ValueGt {
+	bool operator()(const string& v, const string& c) const { return v.compare(c) > 0; }
+};
+struct ValueLe {
+	bool operator()(const string& v, const string& c) const { return v.compare(c) <= 0; }
+};
+struct ValueGe {
+	bool operator()(const string& v, const string& c) const { return v.compare(c) >= 0; }
+};
+struct ValuePrefix {
+	bool operator()(const string& v, const string& c) const { return v.compare(0, c.size(), c) == 0; }
+};
+struct ValueLike {
+	bool operator()(const string& v, const string& c) const { return likeMatch(v.c_str(), c.c_str()); }
+};
+
+/*
+ * Keep the rows in sel whose value meets compare(value, c).
+ * @return the # of rows kept
+ */
+template <class Compare>
+static int filterValues(const RowBatch& batch, int* sel, int n, const string& c, Compare compare)
+{
+	int m = 0;
+	for (int j = 0; j < n; j++)
+		if (compare(batch.values[sel[j]], c)) sel[m++] = sel[j];
+	return m;
+}
+
+/*
+ * Keep the rows in sel with lo <= key <= hi, checking only the bounds
+ * that are set.
+ * @return the # of rows kept
+ */
+template <bool CheckLo, bool CheckHi>
+static int filterKeyRange(const int* keys, int* sel, int n, int lo, int hi)
+{
+	int m = 0;
+	for (int j = 0; j < n; j++) {
+		int key = keys[sel[j]];
+		if ((!CheckLo || key >= lo) && (!CheckHi || key <= hi)) sel[m++] = sel[j];
+	}
+	return m;
+}
+
+/*
+ * Keep the rows in sel whose key is (if In) or is not (if !In) one of
+ * the sorted keys.
+ * @return the # of rows kept
+ */
+template <bool In>
+static int filterKeyList(const int* keys, int* sel, int n, const vector<int>& list)
+{
+	int m = 0;
+	int size = list.size();
+	const int* first = &list[0];
+
+	// a single key (the usual NE) needs no search at all, a short list is
+	// searched in order and a long one by halves
+	if (size == 1) {
+		for (int j = 0; j < n; j++)
+			if ((keys[sel[j]] == first[0]) == In) sel[m++] = sel[j];
+	}
+	else if (size <= 8) {
+		for (int j = 0; j < n; j++) {
+			int key = keys[sel[j]], k = 0;
+			while (k < size && first[k] != key) k++;
+			if ((k < size) == In) sel[m++] = sel[j];
+		}
+	}
+	else {
+		for (int j = 0; j < n; j++)
+			if (binary_search(first, first + size, keys[sel[j]]) == In) sel[m++] = sel[j];
+	}
+	return m;
+}
+
+// orders tests by cost over the fraction of rows they remove, so that a
+// cheap test that removes many rows runs first
+struct Predicate::ByRank {
+	static double rank(const Test& t)
+	{
+		return t.selectivity >= 1 ? HUGE_VAL : t.cost/(1 - t.selectivity);
+	}
+	bool operator()(const Test& a, const Test& b) const { return rank(a) < rank(b); }
+};
+
+Predicate::Predicate(const vector<SelCond>& cond, const TableStats* stats)
+{
+	long long lo = INT_MIN, hi = INT_MAX;
+	bool ranged = false;
+	vector<int> excluded;
+	double rows = (stats != NULL && stats->getRowCount() > 0) ? stats->getRowCount() : 0;
+
+	empty = false;
+	for (unsigned i = 0; i < cond.size(); i++) {
+		const SelCond& c = cond[i];
+		Test t;
+		t.lo = t.hi = 0;
+
+		if (c.comp == SelCond::IN) {
+			t.kind = (c.attr == 1) ? KEY_IN : VALUE_IN;
+			for (unsigned j = 0; j < c.values.size(); j++) {
+				if (c.attr == 1) t.keys.push_back(atoi(c.values[j]));
+				else t.values.push_back(c.values[j]);
+			}
+			sort(t.keys.begin(), t.keys.end());
+			t.keys.erase(unique(t.keys.begin(), t.keys.end()), t.keys.end());
+			sort(t.values.begin(), t.values.end());
+			t.values.erase(unique(t.values.begin(), t.values.end()), t.values.end());
+			int n = max(t.keys.size(), t.values.size());
+			t.cost = (c.attr == 1 ? 1 : 3) + log2(n + 1.0);
+			t.selectivity = rows ? stats->selectivity(c) : min(1.0, 0.05*n);
+			tests.push_back(t);
+			continue;
+		}
+
+		if (c.attr == 1) {
+			long long v = atoi(c.value);
+			switch (c.comp) {
+				case SelCond::EQ: lo = max(lo, v); hi = min(hi, v); ranged = true; break;
+				case SelCond::GT: lo = max(lo, v+1); ranged = true; break;
+				case SelCond::GE: lo = max(lo, v); ranged = true; break;
+				case SelCond::LT: hi = min(hi, v-1); ranged = true; break;
+				case SelCond::LE: hi = min(hi, v); ranged = true; break;
+				case SelCond::NE: excluded.push_back(v); break;
+				default:
+					// LIKE: on the key printed as a string
+					t.kind = KEY_LIKE;
+					t.value = c.value;
+					t.cost = 20;
+					t.selectivity = rows ? stats->selectivity(c) : 0.1;
+					tests.push_back(t);
+					break;
+			}
+			continue;
+		}
+
+		t.value = c.value;
+		switch (c.comp) {
+			case SelCond::EQ: t.kind = VALUE_EQ; t.cost = 2; break;
+			case SelCond::NE: t.kind = VALUE_NE; t.cost = 2; break;
+			case SelCond::LT: t.kind = VALUE_LT; t.cost = 3; break;
+			case SelCond::GT: t.kind = VALUE_GT; t.cost = 3; break;
+			case SelCond::LE: t.kind = VALUE_LE; t.cost = 3; break;
+			case SelCond::GE: t.kind = VALUE_GE; t.cost = 3; break;
+			default:
+			{
+				// LIKE without wildcards is an equality, and with only a
+				// trailing '%' a prefix test
+				size_t plain = strcspn(c.value, "%_");
+				if (c.value[plain] == 0) { t.kind = VALUE_EQ; t.cost = 2; }
+				else if (c.value[plain] == '%' && c.value[plain+1] == 0) {
+					t.kind = VALUE_PREFIX;
+					t.value.resize(plain);
+					t.cost = 3;
+				}
+				else { t.kind = VALUE_LIKE; t.cost = 10; }
+			}
+			break;
+		}
+		if (rows) t.selectivity = stats->selectivity(c);
+		else if (t.kind == VALUE_EQ) t.selectivity = 0.05;
+		else if (t.kind == VALUE_NE) t.selectivity = 0.95;
+		else if (t.kind == VALUE_PREFIX || t.kind == VALUE_LIKE) t.selectivity = 0.1;
+		else t.selectivity = 1.0/3;
+		tests.push_back(t);
+	}
+
+	// the key comparisons, merged
+	if (lo > hi) empty = true;
+	else if (ranged && (lo > INT_MIN || hi < INT_MAX)) {
+		Test t;
+		t.kind = KEY_RANGE;
+		t.lo = lo;
+		t.hi = hi;
+		t.cost = 1;
+		if (rows) t.selectivity = stats->estimateRows(lo, hi)/rows;
+		else t.selectivity = (lo == hi) ? 0.05 : (lo > INT_MIN && hi < INT_MAX) ? 0.25 : 1.0/3;
+		tests.push_back(t);
+	}
+
+	// the NE keys that are in the range
+	sort(excluded.begin(), excluded.end());
+	excluded.erase(unique(excluded.begin(), excluded.end()), excluded.end());
+	Test t;
+	t.kind = KEY_EXCLUDED;
+	t.lo = t.hi = 0;
+	t.selectivity = 1;
+	for (unsigned i = 0; i < excluded.size(); i++) {
+		if (excluded[i] < lo || excluded[i] > hi) continue;
+		t.keys.push_back(excluded[i]);
+		t.selectivity -= rows ? stats->estimateRows(excluded[i], excluded[i])/rows : 0.05;
+	}
+	if (!t.keys.empty()) {
+		t.cost = 1 + log2(t.keys.size() + 1.0);
+		t.selectivity = max(0.0, t.selectivity);
+		tests.push_back(t);
+	}
+
+	stable_sort(tests.begin(), tests.end(), ByRank());
+}
+
+int Predicate::apply(const RowBatch& batch, int* sel, int n) const
+{
+	char keyString[16]; // key as a string, for LIKE conditions on key
+
+	if (empty) return 0;
+	for (unsigned i = 0; i < tests.size() && n > 0; i++) {
+		const Test& t = tests[i];
+		switch (t.kind) {
+			case KEY_RANGE:
+				if (t.lo == INT_MIN) n = filterKeyRange<false, true>(batch.keys, sel, n, t.lo, t.hi);
+				else if (t.hi == INT_MAX) n = filterKeyRange<true, false>(batch.keys, sel, n, t.lo, t.hi);
+				else n = filterKeyRange<true, true>(batch.keys, sel, n, t.lo, t.hi);
+				break;
+			case KEY_EXCLUDED: n = filterKeyList<false>(batch.keys, sel, n, t.keys); break;
+			case KEY_IN: n = filterKeyList<true>(batch.keys, sel, n, t.keys); break;
+			case KEY_LIKE:
+			{
+				int m = 0;
+				for (int j = 0; j < n; j++) {
+					sprintf(keyString, "%d", batch.keys[sel[j]]);
+					if (likeMatch(keyString, t.value.c_str())) sel[m++] = sel[j];
+				}
+				n = m;
+			}
+			break;
+			case VALUE_EQ: n = filterValues(batch, sel, n, t.value, ValueEq()); break;
+			case VALUE_NE: n = filterValues(batch, sel, n, t.value, ValueNe()); break;
+			case VALUE_LT: n = filterValues(batch, sel, n, t.value, ValueLt()); break;
+			case VALUE_GT: n = filterValues(batch, sel, n, t.value, ValueGt()); break;
+			case VALUE_LE: n = filterValues(batch, sel, n, t.value, ValueLe()); break;
+			case VALUE_GE: n = filterValues(batch, sel, n, t.value, ValueGe()); break;
+			case VALUE_PREFIX: n = filterValues(batch, sel, n, t.value, ValuePrefix()); break;
+			case VALUE_LIKE: n = filterValues(batch, sel, n, t.value, ValueLike()); break;
+			case VALUE_IN:
+			{
+				int m = 0;
+				for (int j = 0; j < n; j++)
+					if (binary_search(t.values.begin(), t.values.end(), batch.values[sel[j]])) sel[m++] = sel[j];
+				n = m;
+			}
+			break;
+		}
+	}
+	return n;
+}
+
+KeyRanges::KeyRanges(const vector<SelCond>& cond)
+{
+	long long lo = INT_MIN, hi = INT_MAX;
+	vector<int> excluded, listed;
+	bool inList = false;
+
+	for (unsigned i = 0; i < cond.size(); i++) {
+		const SelCond& c = cond[i];
+		if (c.attr != 1 || c.comp == SelCond::LIKE) continue;
+
+		if (c.comp == SelCond::IN) {
+			vector<int> keys;
+			for (unsigned j = 0; j < c.values.size(); j++) keys.push_back(atoi(c.values[j]));
+			sort(keys.begin(), keys.end());
+			keys.erase(unique(keys.begin(), keys.end()), keys.end());
+
+			// a key has to be in every IN list
+			if (inList) {
+				vector<int> both;
+				set_intersection(listed.begin(), listed.end(), keys.begin(), keys.end(), back_inserter(both));
+				keys.swap(both);
+			}
+			listed.swap(keys);
+			inList = true;
+			continue;
+		}
+
+		long long v = atoi(c.value);
+		switch (c.comp) {
+			case SelCond::EQ: lo = max(lo, v); hi = min(hi, v); break;
+			case SelCond::GT: lo = max(lo, v+1); break;
+			case SelCond::GE: lo = max(lo, v); break;
+			case SelCond::LT: hi = min(hi, v-1); break;
+			case SelCond::LE: hi = min(hi, v); break;
+			case SelCond::NE: excluded.push_back(v); break;
+			default: break;
+		}
+	}
+	if (lo > hi) return;
+	sort(excluded.begin(), excluded.end());
+
+	Range range;
+	if (inList) {
+		// the listed keys in [lo, hi] that are not excluded, one range each
+		for (unsigned i = 0; i < listed.size(); i++) {
+			if (listed[i] < lo || listed[i] > hi) continue;
+			if (binary_search(excluded.begin(), excluded.end(), listed[i])) continue;
+			range.lo = range.hi = listed[i];
+			ranges.push_back(range);
+		}
+		return;
+	}
+
+	// every excluded key in [lo, hi] ends a range before it
+	for (unsigned i = 0; i < excluded.size(); i++) {
+		if (excluded[i] < lo || excluded[i] > hi) continue;
+		if (excluded[i] > lo) {
+			range.lo = lo;
+			range.hi = excluded[i] - 1;
+			ranges.push_back(range);
+		}
+		lo = (long long) excluded[i] + 1;
+	}
+	if (lo <= hi) {
+		range.lo = lo;
+		range.hi = hi;
+		ranges.push_back(range);
+	}
+}
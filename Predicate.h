@@ -0,0 +1,136 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/19/2026
+ */
+
+#ifndef PREDICATE_H
+#define PREDICATE_H
+
+#include <string>
+#include <vector>
+#include "Bruinbase.h"
+#include "SqlEngine.h"
+#include "TableStats.h"
+
+struct RowBatch;
+
+/**
+ * The conditions of a WHERE clause, compiled once per query into a list of
+ * typed tests that are run over whole batches of rows:
+ *   - the key comparisons are merged into one key range test, and the
+ *     keys of NE conditions into one sorted exclusion list
+ *   - the constants are parsed once: integers for key conditions, sorted
+ *     lists for IN, and a LIKE pattern without wildcards or with only a
+ *     trailing '%' becomes an equality or a prefix test
+ *   - the tests run cheapest and most selective first (by cost per row
+ *     over the fraction of rows they remove), so the key tests run before
+ *     the string compares, and every test only looks at the rows that
+ *     passed the ones before it
+ * The loop of every test is a template instance for its comparison, so
+ * there is no switch per row.
+ */
+class Predicate {
+ public:
+  /**
+   * Compile the conditions.
+   * @param cond[IN] the conditions, ANDed together
+   * @param stats[IN] the statistics of the table to estimate the
+   *                  selectivity of the tests with, or NULL
+   */
+  Predicate(const std::vector<SelCond>& cond, const TableStats* stats);
+
+  /**
+   * Check the rows of batch listed in sel.
+   * @param batch[IN] the rows
+   * @param sel[IN/OUT] the positions of the rows to check, in order; on
+   *                    return, the positions of those that meet all tests
+   * @param n[IN] the # of positions in sel
+   * @return the # of rows that meet all tests
+   */
+  int apply(const RowBatch& batch, int* sel, int n) const;
+
+  /**
+   * @return whether no row can meet the conditions (empty key range)
+   */
+  bool isEmpty() const { return empty; }
+
+  /**
+   * @return the # of tests, 0 if every row meets the conditions
+   */
+  int getTestCount() const { return tests.size(); }
+
+ private:
+  enum Kind {
+    KEY_RANGE,      // lo <= key <= hi
+    KEY_EXCLUDED,   // key not in keys (NE)
+    KEY_IN,         // key in keys
+    KEY_LIKE,       // key as a string LIKE value
+    VALUE_EQ, VALUE_NE, VALUE_LT, VALUE_GT, VALUE_LE, VALUE_GE,
+    VALUE_IN,       // value in values
+    VALUE_PREFIX,   // value starts with value
+    VALUE_LIKE      // value LIKE value, with wildcards
+  };
+
+  struct Test {
+    Kind kind;
+    long long lo, hi;                 // KEY_RANGE
+    std::vector<int> keys;            // KEY_EXCLUDED, KEY_IN: sorted, distinct
+    std::string value;                // the constant of a value test, or the pattern
+    std::vector<std::string> values;  // VALUE_IN: sorted, distinct
+    double cost;                      // the relative cost per row
+    double selectivity;               // the fraction of rows that pass
+  };
+  struct ByRank; // orders tests by cost over the fraction they remove
+
+  std::vector<Test> tests;
+  bool empty;
+};
+
+/**
+ * The keys that the key conditions of a WHERE clause let through, as a
+ * sorted list of disjoint ranges [lo, hi]. The comparisons narrow a single
+ * range, every NE key in it splits it in two, and with an IN list (or
+ * several, intersected) each listed key left in the range is a range of its
+ * own. No ranges at all proves that the conditions contradict. LIKE
+ * conditions on key are left out: they are checked on the rows.
+ */
+class KeyRanges {
+ public:
+  struct Range {
+    int lo, hi;   // lo <= key <= hi
+  };
+
+  /**
+   * Intersect the key conditions.
+   * @param cond[IN] the conditions, ANDed together
+   */
+  KeyRanges(const std::vector<SelCond>& cond);
+
+  /**
+   * @return whether no key meets the conditions
+   */
+  bool isEmpty() const { return ranges.empty(); }
+
+  /**
+   * @return the # of ranges
+   */
+  int size() const { return ranges.size(); }
+
+  /**
+   * @return range i, in key order
+   */
+  const Range& operator[](int i) const { return ranges[i]; }
+
+  /**
+   * @return the smallest and the largest key of the ranges (not empty)
+   */
+  int getLo() const { return ranges.front().lo; }
+  int getHi() const { return ranges.back().hi; }
+
+ private:
+  std::vector<Range> ranges;
+};
+
+#endif /* PREDICATE_H */
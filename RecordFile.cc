@@ -184,6 +184,40 @@ RC RecordFile::read(const RecordId& rid, int& key, string& value) const
   return 0;
 }
 
+RC RecordFile::readKeys(PageId pid, int keys[], int& count) const
+{
+  RC   rc;
+  char page[PageFile::PAGE_SIZE];
+
+  if (pid < 0 || pid >= pf.endPid()) return RC_INVALID_PID;
+  if ((rc = pf.read(pid, page)) < 0) return rc;
+
+  count = getRecordCount(page);
+  if (count > RECORDS_PER_PAGE) count = RECORDS_PER_PAGE;
+  for (int i = 0; i < count; i++) {
+    memcpy(&keys[i], slotPtr(page, i), sizeof(int));
+  }
+
+  return 0;
+}
+
+RC RecordFile::readRecords(PageId pid, int keys[], string values[], int& count) const
+{
+  RC   rc;
+  char page[PageFile::PAGE_SIZE];
+
+  if (pid < 0 || pid >= pf.endPid()) return RC_INVALID_PID;
+  if ((rc = pf.read(pid, page)) < 0) return rc;
+
+  count = getRecordCount(page);
+  if (count > RECORDS_PER_PAGE) count = RECORDS_PER_PAGE;
+  for (int i = 0; i < count; i++) {
+    readSlot(page, i, keys[i], values[i]);
+  }
+
+  return 0;
+}
+
 RC RecordFile::append(int key, const std::string& value, RecordId& rid)
 {
   RC   rc;
@@ -79,6 +79,25 @@ class RecordFile {
    */
   RC read(const RecordId& rid, int& key, std::string& value) const;
 
+  /**
+   * read the keys of all records in a page, reading the page only once.
+   * @param pid[IN] the page to read
+   * @param keys[OUT] the record keys in slot order (room for RECORDS_PER_PAGE)
+   * @param count[OUT] the number of records in the page
+   * @return error code. 0 if no error
+   */
+  RC readKeys(PageId pid, int keys[], int& count) const;
+
+  /**
+   * read all records in a page, reading the page only once.
+   * @param pid[IN] the page to read
+   * @param keys[OUT] the record keys in slot order (room for RECORDS_PER_PAGE)
+   * @param values[OUT] the record values in slot order (room for RECORDS_PER_PAGE)
+   * @param count[OUT] the number of records in the page
+   * @return error code. 0 if no error
+   */
+  RC readRecords(PageId pid, int keys[], std::string values[], int& count) const;
+
   /**
    * append a new record at the end of the file.
    * note that RecordFile does not have write() function.
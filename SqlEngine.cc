@@ -8,13 +8,30 @@
  */
 
 #include <cstdio>
+#include <cstdarg>
 #include <cstring>
 #include <cstdlib>
 #include <iostream>
 #include <fstream>
+#include <climits>
+#include <cmath>
+#include <algorithm>
+#include <thread>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/times.h>
 #include "Bruinbase.h"
 #include "SqlEngine.h"
 #include "BTreeIndex.h"
+#include "BufferedIndex.h"
+#include "ValueIndex.h"
+#include "HashIndex.h"
+#include "LsmIndex.h"
+#include "LearnedIndex.h"
+#include "ArtIndex.h"
+#include "ExternalSort.h"
+#include "TableStats.h"
+#include "Operator.h"
 
 using namespace std;
 
@@ -35,362 +52,609 @@ RC SqlEngine::run(FILE* commandline)
   return 0;
 }
 
-RC SqlEngine::select(int attr, const string& table, const vector<SelCond>& cond)
+// whether select() only prints its plan (EXPLAIN SELECT)
+static bool explaining = false;
+
+/*
+ * Print the plan of a SELECT: on screen for EXPLAIN, along the timing
+ * of the command otherwise. rows is the estimated # of result rows, left
+ * out if negative (no statistics).
+ */
+static void printPlan(double rows, const char* format, ...)
 {
-  RecordFile rf;   // RecordFile containing the table
-  RecordId   rid;  // record cursor for table scanning
-  	
-  RC     rc;
-  int    key;     
-  string value;
-  int    count;
-  int    diff;
+  FILE* out = explaining ? stdout : stderr;
+  va_list args;
+
+  va_start(args, format);
+  fprintf(out, "  -- plan: ");
+  vfprintf(out, format, args);
+  va_end(args);
+  if (rows >= 0) fprintf(out, ", ~%.0f rows", rows);
+  fprintf(out, "\n");
+}
+
+/*
+ * Estimate the # of rows with keys in the ranges from the table statistics.
+ */
+static double estimateRanges(const TableStats* stats, const KeyRanges& ranges)
+{
+  double rows = 0;
+  for (int i = 0; i < ranges.size(); i++) rows += stats->estimateRows(ranges[i].lo, ranges[i].hi);
+  return rows;
+}
+
+/*
+ * Count the entries with keys in the ranges of an index that can count a
+ * range.
+ */
+template <class Index>
+static int countRanges(Index& index, const KeyRanges& ranges)
+{
+  int n = 0;
+  for (int i = 0; i < ranges.size(); i++) n += index.countRange(ranges[i].lo, ranges[i].hi);
+  return n;
+}
+
+/*
+ * Estimate the # of rows that meet all conditions, assuming the conditions
+ * are independent, given the ranges that the key conditions leave.
+ * @return the estimate, or -1 if there are no statistics
+ */
+static double estimateResult(const TableStats* stats, const vector<SelCond>& cond, const KeyRanges& ranges)
+{
+  if (stats == NULL) return -1;
+
+  double rows = estimateRanges(stats, ranges);
+  for (unsigned i = 0; i < cond.size(); i++) {
+    if (cond[i].attr == 1 && cond[i].comp != SelCond::LIKE) continue;
+    rows *= stats->selectivity(cond[i]);
+  }
+  return rows;
+}
+
+/*
+ * The ways a key range of a table with a B+tree index can be read.
+ */
+enum ScanPlan {
+  TABLE_SCAN,      // every page of the table, in order
+  INDEX_COUNT,     // count(*) from the subtree counts of the index
+  INDEX_ONLY_SCAN, // the leaves of the range, without reading records
+  INDEX_SCAN,      // the leaves of the range, and every record in key order
+  SORTED_FETCH,    // the leaves of the range, then the records in RecordId order
+  BACKWARD_SCAN    // the leaves of the ranges from the end, up to the first match
+};
+
+static const char* planNames[] = {
+  "table scan", "index count", "index-only scan", "index scan", "index scan with sorted RecordId fetch",
+  "index backward scan"
+};
+
+/*
+ * Pick the plan that reads the fewest pages for the keys in the ranges of a
+ * table with an open B+tree index, and print it with the estimated # of
+ * result rows. The rows in the range are estimated from the table
+ * statistics (see TableStats), or counted in the index if the table has
+ * none. A record read in key order costs a page unless the table was
+ * loaded in key order; records read in RecordId order cost the distinct
+ * pages they are on (Cardenas' formula).
+ */
+static ScanPlan choosePlan(const TableStats* stats, const RecordFile& rf, BTreeIndex& tree,
+                           int attr, bool valueCondFlag, const KeyRanges& ranges, double resultRows)
+{
+  bool needValue = (attr == 2 || attr == 3 || valueCondFlag);
+  int tablePages = rf.endRid().pid + (rf.endRid().sid > 0 ? 1 : 0);
+  int tableRows = rf.endRid().pid*RecordFile::RECORDS_PER_PAGE + rf.endRid().sid;
+  double rows, keyOrder = 0;
+
+  if (stats != NULL) {
+    rows = estimateRanges(stats, ranges);
+    keyOrder = stats->getKeyOrder();
+  } else {
+    int count;
+    rows = 0;
+    for (int i = 0; i < ranges.size(); i++) {
+      count = 0;
+      tree.countRange(ranges[i].lo, ranges[i].hi, count);
+      rows += count;
+    }
+  }
+
+  // the leaves are nearly all of the index pages
+  int height = tree.getTreeHeight();
+  double leafPages = tableRows > 0 ? ceil((double) tree.getPageCount()*rows/tableRows) : 0;
+  double indexCost = height + leafPages;
+
+  ScanPlan plan;
+  double cost[SORTED_FETCH+1];
+  cost[TABLE_SCAN] = tablePages;
+  cost[INDEX_COUNT] = 2*height;
+  cost[INDEX_ONLY_SCAN] = indexCost;
+  cost[INDEX_SCAN] = indexCost + rows*(1 - keyOrder) + rows*keyOrder/RecordFile::RECORDS_PER_PAGE;
+  cost[SORTED_FETCH] = indexCost + (tablePages > 0 ? tablePages*(1 - pow(1 - 1.0/tablePages, rows)) : 0);
+
+  if (!valueCondFlag && attr == 4) plan = INDEX_COUNT;
+  else if (!needValue || tree.includesValue()) plan = INDEX_ONLY_SCAN;
+  else plan = cost[SORTED_FETCH] < cost[INDEX_SCAN] ? SORTED_FETCH : INDEX_SCAN;
+  if (cost[TABLE_SCAN] < cost[plan]) plan = TABLE_SCAN;
+
+  printPlan(resultRows >= 0 ? resultRows : rows, "%s, ~%.0f pages (table scan %d pages)",
+            planNames[plan], cost[plan], tablePages);
+  return plan;
+}
+
+/*
+ * Whether the value index reads fewer pages than a table scan for the
+ * rows estimated to be in its value range, and print the plan if so. The
+ * records of the range are read in value order, a page each, if the key is
+ * needed. Without statistics the value index is always used. vtree is
+ * closed if it is not used.
+ */
+static bool chooseValueIndex(const TableStats* stats, const RecordFile& rf, ValueIndex& vtree,
+                             bool needKey, double rangeRows, double resultRows)
+{
+  int tablePages = rf.endRid().pid + (rf.endRid().sid > 0 ? 1 : 0);
+
+  if (stats != NULL && stats->getRowCount() > 0) {
+    double cost = ceil(vtree.getPageCount()*rangeRows/stats->getRowCount()) + (needKey ? rangeRows : 0);
+    if (cost > tablePages) {
+      vtree.close();
+      return false;
+    }
+    printPlan(resultRows, "value index scan, ~%.0f pages (table scan %d pages)", cost, tablePages);
+  }
+  else printPlan(resultRows, "value index scan");
+  return true;
+}
+
+/*
+ * Whether reading the B+tree backwards for max(key) is estimated to read
+ * fewer pages than a table scan, and print the plan if so. The scan stops
+ * at the first entry that meets the conditions: if resultRows of the
+ * rangeRows entries of the ranges do, about rangeRows/resultRows entries
+ * are read, and their records if the value is checked. Without statistics
+ * the backward scan is always used. tree is closed if it is not used.
+ */
+static bool chooseBackwardScan(const TableStats* stats, const RecordFile& rf, BTreeIndex& tree,
+                               bool needValue, const KeyRanges& ranges, double resultRows)
+{
+  int tablePages = rf.endRid().pid + (rf.endRid().sid > 0 ? 1 : 0);
+
+  if (stats != NULL && stats->getRowCount() > 0) {
+    double rangeRows = estimateRanges(stats, ranges);
+    double rows = (resultRows >= 1 ? rangeRows/resultRows : rangeRows);
+    double cost = tree.getTreeHeight() + ceil(tree.getPageCount()*rows/stats->getRowCount()) + (needValue ? rows : 0);
+    if (cost > tablePages) {
+      tree.close();
+      return false;
+    }
+    printPlan(resultRows, "%s, ~%.0f pages (table scan %d pages)", planNames[BACKWARD_SCAN], cost, tablePages);
+  }
+  else printPlan(resultRows, "%s", planNames[BACKWARD_SCAN]);
+  return true;
+}
+
+/*
+ * Whether the hash index reads fewer pages than the B+tree for a key
+ * equality estimated to match rows entries, and print the plan if so. The
+ * B+tree is costed as in choosePlan(): its height and the leaves of the
+ * entries. If it includes the values, the records the hash index fetches
+ * count too. Without a B+tree the hash index is always used. htree is
+ * closed if it is not used.
+ */
+static bool chooseHashIndex(const string& table, const RecordFile& rf, HashIndex& htree,
+                            int key, bool needValue, double rows, double resultRows)
+{
+  BTreeIndex tree;
+  int hashCost = htree.getLookupCost(key, rows);
+
+  if (tree.open(table + ".idx", 'r') == 0) {
+    int tableRows = rf.endRid().pid*RecordFile::RECORDS_PER_PAGE + rf.endRid().sid;
+    double treeCost = tree.getTreeHeight() + (tableRows > 0 ? ceil((double) tree.getPageCount()*rows/tableRows) : 0);
+    double cost = hashCost + (needValue && tree.includesValue() ? rows : 0);
+    tree.close();
+    if (treeCost < cost) {
+      htree.close();
+      return false;
+    }
+    printPlan(resultRows, "hash index lookup, ~%.0f pages (B+tree ~%.0f pages)", cost, treeCost);
+  }
+  else printPlan(resultRows, "hash index lookup, ~%d pages", hashCost);
+  return true;
+}
+
+/*
+ * What select() draws from the conditions of a query, and from the
+ * statistics of its table, to pick the operators that read its rows.
+ */
+struct SelectQuery {
+  int attr;                     // attribute in the SELECT clause, as for select()
+  const vector<SelCond>& cond;  // the conditions in the WHERE clause
+  KeyRanges ranges;             // the key conditions, as disjoint ranges of keys
+
+  bool condFlag;                // whether a key condition bounds the keys (NE and LIKE do not)
+  bool valueCondFlag;           // whether there is any value condition
+  bool inFlag;                  // whether there is an IN condition on key
+  vector<int> inKeys;           // the keys of the IN lists that the other key conditions let through
+  bool rangeCount;              // count(*) with only key conditions that the ranges meet exactly
+  bool needKey;                 // whether the key of a row is printed or checked
+  bool needValue;               // whether the value of a row is printed or checked
+
+  // the range of the value conditions, usable with the value index
+  bool valueRangeFlag;          // whether any value condition bounds the scan
+  string valueLo;               // smallest value to scan ("" scans from the beginning)
+  const char* valueHi;          // largest value to scan (NULL if unbounded)
+  bool valueHiIncl;             // whether valueHi itself matches
+  string likePrefix;            // prefix that all values must start with
+
+  // the estimates of the planner (see readStats())
+  TableStats stats;             // the statistics of the table, if it has any
+  const TableStats* tableStats; // &stats if they are up to date
+  double estimate;              // the estimated # of result rows (-1: unknown)
+  double valueRows;             // the estimated # of rows in the range of the value index
+
+  SelectQuery(int attr, const vector<SelCond>& cond);
+
+  /**
+   * Read the statistics of the table, if they describe all its rows, and
+   * estimate the rows of the query with them.
+   */
+  void readStats(const string& table, const RecordFile& rf);
+
+  /**
+   * @return whether no row can meet the conditions: no key is left in the
+   *         ranges, or every value at or above valueLo is past valueHi
+   */
+  bool contradicts() const;
+};
+
+SelectQuery::SelectQuery(int attr, const vector<SelCond>& cond)
+  : attr(attr), cond(cond), ranges(cond), condFlag(false), valueCondFlag(false), inFlag(false),
+    valueRangeFlag(false), valueHi(NULL), valueHiIncl(true), tableStats(NULL), estimate(-1), valueRows(0)
+{
+  for (unsigned i = 0; i < cond.size(); i++) {
+    // IN conditions are checked on every tuple; on key they bound the keys to look up
+    if (cond[i].comp == SelCond::IN) {
+      if (cond[i].attr == 2) valueCondFlag = true;
+      else inFlag = condFlag = true;
+      continue;
+    }
+
+    // the key comparisons are in ranges; an NE alone does not make an index worth using
+    if (cond[i].attr == 1) {
+      if (cond[i].comp != SelCond::NE && cond[i].comp != SelCond::LIKE) condFlag = true;
+      continue;
+    }
+
+    // narrow down the range of values to scan in the value index
+    valueCondFlag = true;
+    switch (cond[i].comp) {
+    case SelCond::EQ:
+    case SelCond::GE:
+    case SelCond::GT:
+      if (!valueRangeFlag || valueLo < cond[i].value) valueLo = cond[i].value;
+      valueRangeFlag = true;
+      if (cond[i].comp != SelCond::EQ) break;
+      // EQ also bounds the range from above
+      // fall through
+    case SelCond::LE:
+    case SelCond::LT: {
+      int c = (valueHi == NULL) ? -1 : strcmp(cond[i].value, valueHi);
+      if (c < 0 || (c == 0 && cond[i].comp == SelCond::LT)) {
+        valueHi = cond[i].value;
+        valueHiIncl = (cond[i].comp != SelCond::LT);
+      }
+      valueRangeFlag = true;
+      break;
+    }
+    case SelCond::LIKE: {
+      // 'prefix%' patterns scan the values starting with prefix
+      string prefix(cond[i].value, strcspn(cond[i].value, "%_"));
+      if (prefix.size() > likePrefix.size()) likePrefix = prefix;
+      if (valueLo < likePrefix) valueLo = likePrefix;
+      if (!prefix.empty()) valueRangeFlag = true;
+      break;
+    }
+    default:
+      break;
+    }
+  }
+
+  /* The ranges hold exactly the keys that the key conditions other than
+     LIKE let through. If they are all the conditions, count(*) is counted
+     from the index that reads the ranges, without producing the rows. With
+     IN lists every range is one of their keys. */
+
+  rangeCount = (attr == 4);
+  for (unsigned i = 0; i < cond.size(); i++)
+    if (cond[i].attr != 1 || cond[i].comp == SelCond::LIKE) rangeCount = false;
+  if (inFlag)
+    for (int i = 0; i < ranges.size(); i++) inKeys.push_back(ranges[i].lo);
+
+  needKey = (attr == 1 || attr == 3 || attr == 5);
+  for (unsigned i = 0; i < cond.size(); i++)
+    if (cond[i].attr == 1) needKey = true;
+  needValue = (attr == 2 || attr == 3 || valueCondFlag);
+}
+
+void SelectQuery::readStats(const string& table, const RecordFile& rf)
+{
+  if (stats.read(table) != 0 || stats.getRowCount() != rf.endRid().pid*RecordFile::RECORDS_PER_PAGE + rf.endRid().sid)
+    return;
+
+  tableStats = &stats;
+  estimate = estimateResult(tableStats, cond, ranges);
+  valueRows = stats.getRowCount();
+  for (unsigned i = 0; i < cond.size(); i++)
+    if (cond[i].attr == 2 && cond[i].comp != SelCond::NE && cond[i].comp != SelCond::IN)
+      valueRows *= stats.selectivity(cond[i]);
+}
+
+bool SelectQuery::contradicts() const
+{
+  if (ranges.isEmpty()) return true;
+  return valueHi != NULL && (valueLo.compare(valueHi) > 0 || (valueLo == valueHi && !valueHiIncl));
+}
+
+/*
+ * The indexes of a table that select() may read the rows from. The ones
+ * that chooseSource() opens are closed when the query is done.
+ */
+struct TableIndexes {
+  BTreeIndex tree;      // the B+tree index on key (.idx)
+  ValueIndex vtree;     // the index on the value column (.vdx)
+  HashIndex htree;      // the hash index on key (.hdx)
+  LsmIndex ltree;       // the log-structured merge index on key (.lsm)
+  LearnedIndex mtree;   // the learned index on key (.ldx)
+  ArtIndex* atree;      // the in-memory index on key, if it fits in memory
+  RC artRc;             // RC_NO_SUCH_RECORD if the in-memory index is not worth building yet
+
+  // which of the index files are open
+  bool treeOpen, valueOpen, hashOpen, lsmOpen, learnedOpen;
+
+  TableIndexes()
+    : atree(NULL), artRc(0), treeOpen(false), valueOpen(false), hashOpen(false), lsmOpen(false), learnedOpen(false) {}
+
+  ~TableIndexes()
+  {
+    if (treeOpen) tree.close();
+    if (valueOpen) vtree.close();
+    if (hashOpen) htree.close();
+    if (lsmOpen) ltree.close();
+    if (learnedOpen) mtree.close();
+  }
+};
+
+/*
+ * Pick the way the rows of a query are read, open the index that reads
+ * them, and print the plan.
+ * @param plan[OUT] how the B+tree reads the key ranges, if it is used
+ * @param exact[OUT] whether the rows read have exactly the keys that the
+ *                   key comparisons let through
+ * @return the operator that reads the rows
+ */
+static Operator* chooseSource(const string& table, const RecordFile& rf, const SelectQuery& q,
+                              TableIndexes& ix, ScanPlan& plan, bool& exact)
+{
+  plan = TABLE_SCAN;
+  exact = true;
+
+  /* A key equality without any key range is served by the hash index:
+     one bucket page instead of a root-to-leaf descent, unless duplicates
+     of the key fill more bucket pages than the B+tree would read. All
+     entries found have the key, so the record is read only if value is
+     needed. */
+
+  if (q.ranges.size() == 1 && q.ranges.getLo() == q.ranges.getHi() &&
+      ix.htree.open(table + ".hdx", 'r') == 0) {
+    double rows = (q.tableStats != NULL ? estimateRanges(q.tableStats, q.ranges) : 1);
+    if ((ix.hashOpen = chooseHashIndex(table, rf, ix.htree, q.ranges.getLo(), q.needValue, rows, q.estimate)))
+      return new HashLookup(ix.htree, q.ranges.getLo());
+  }
+
+  /* A key IN list is answered with one batched descent of the B+tree:
+     the keys are probed in sorted order and every leaf is read once. */
+
+  if (q.inFlag && (ix.treeOpen = (ix.tree.open(table + ".idx", 'r') == 0))) {
+    printPlan(q.estimate, "batched index lookup of %d keys", (int) q.inKeys.size());
+    return new InListScan(ix.tree, q.inKeys);
+  }
+
+  exact = false;
+
+  /* Without a usable key condition, a bounded condition on value is served
+     by the value index, unless a table scan is estimated to read fewer
+     pages. The record is read only if key is needed. */
+
+  if (!q.condFlag && q.valueRangeFlag && ix.vtree.open(table + ".vdx", 'r') == 0) {
+    if ((ix.valueOpen = chooseValueIndex(q.tableStats, rf, ix.vtree, q.needKey, q.valueRows, q.estimate)))
+      return new ValueIndexScan(ix.vtree, q.valueLo, q.valueHi, q.valueHiIncl, q.likePrefix);
+  }
+
+  /* Key conditions on a table loaded WITH LSM INDEX: the runs that can
+     hold keys of a range are merged in key order, a range at a time. An
+     equality reads only the runs whose bloom filter may contain the key. */
+
+  if (q.condFlag && (ix.lsmOpen = (ix.ltree.open(table + ".lsm", 'r') == 0))) {
+    printPlan(q.estimate, "lsm index range scan");
+    return new KeyRangeScan<LsmIndex, LsmCursor>(ix.ltree, q.ranges);
+  }
+
+  /* Key conditions on a table loaded WITH LEARNED INDEX: the models
+     predict where every range starts in the sorted entries, and the
+     entries up to its end are read from there. */
+
+  if (q.condFlag && (ix.learnedOpen = (ix.mtree.open(table + ".ldx", 'r') == 0))) {
+    printPlan(q.estimate, "learned index range scan");
+    return new KeyRangeScan<LearnedIndex, IndexCursor>(ix.mtree, q.ranges);
+  }
+
+  /* max(key) reads the B+tree backwards from the end of the last range
+     and stops at the first entry that meets the other conditions: without
+     value conditions, a descent and the last leaf. */
+
+  if (q.attr == 5 && ix.tree.open(table + ".idx", 'r') == 0) {
+    if ((ix.treeOpen = chooseBackwardScan(q.tableStats, rf, ix.tree, q.needValue, q.ranges, q.estimate))) {
+      plan = BACKWARD_SCAN;
+      return new BackwardIndexScan(ix.tree, q.ranges);
+    }
+  }
 
-  count = 0; // count number of matching tuples
+  /* Key conditions on a table whose keys fit in MEMORY_INDEX_BUDGET are
+     served by an in-memory radix tree, built from the .idx leaves (or the
+     .tbl) and kept for the process. It is built once the queries it could
+     have served read as many pages as building it does: until then they
+     run as below and charge their pages to it. Its lookups read no pages.
+     If the value is needed, only short ranges use it: longer ones go to the
+     B+tree, which reads their records in RecordId order or has the values
+     in a covering index. Queries estimated to read a longer range are not
+     charged, as it would not serve them once built either. */
 
-  IndexCursor cur;	// New variable: Navigating the tree
-  BTreeIndex tree; // Creating an index if index file available
+  bool shortRanges = (q.tableStats == NULL || estimateRanges(q.tableStats, q.ranges) < SqlEngine::SORTED_FETCH_MIN);
+  if (q.condFlag && (!q.needValue || shortRanges) &&
+      (ix.artRc = ArtIndex::open(table, rf, SqlEngine::MEMORY_INDEX_BUDGET, ix.atree)) == 0 &&
+      (!q.needValue || (!ix.atree->coversValue() && countRanges(*ix.atree, q.ranges) < SqlEngine::SORTED_FETCH_MIN))) {
+    printPlan(q.estimate, q.rangeCount ? "in-memory index count" : "in-memory index range scan");
+    exact = true;
+    return new KeyRangeScan<ArtIndex, int>(*ix.atree, q.ranges);
+  }
+
+  /* With a B+tree index, the key range is read the way that is estimated
+     to read the fewest pages: a range that matches most of the table is
+     cheaper to read with a table scan than a record at a time. Without a
+     key condition, the index is only used to count(*) the whole table. */
+
+  if (!(ix.treeOpen = (ix.tree.open(table + ".idx", 'r') == 0)) || (!q.condFlag && q.attr != 4)) {
+    printPlan(q.estimate, "table scan");
+    return new TableScan(rf, q.needValue);
+  }
+  if ((plan = choosePlan(q.tableStats, rf, ix.tree, q.attr, q.valueCondFlag, q.ranges, q.estimate)) == TABLE_SCAN)
+    return new TableScan(rf, q.needValue);
+
+  /* The B+tree index reads the entries of the ranges in key order, with
+     their values if it includes them. count(*) is answered from the
+     subtree counts of the index (INDEX_COUNT): O(tree height) page reads no
+     matter how wide the range is. Records fetched in key order hit the
+     table pages in random order: when the plan estimates that to read more
+     pages (SORTED_FETCH), the entries of the range are collected first and
+     their records read in RecordId order, so every table page is read once. */
+
+  exact = true;
+  return new IndexScan(ix.tree, q.ranges);
+}
+
+/*
+ * Run a query on the rows that source reads: they are completed, checked,
+ * cut and printed on their way to the count.
+ * @param source[IN] the operator that reads the rows (deleted here)
+ * @param plan[IN] and exact[IN] as chooseSource() set them
+ * @param count[OUT] the # of rows printed, or counted for count(*) and max(key)
+ * @param maxKey[OUT] the largest key of the rows, for max(key)
+ * @return error code. 0 if no error
+ */
+static RC runPipeline(Operator* source, const RecordFile& rf, const SelectQuery& q, const TableIndexes& ix,
+                      ScanPlan plan, bool exact, int limit, int& count, int& maxKey)
+{
+  Operator* op = source;
+  MaxKey* maxOp = NULL;
+  RC rc;
+
+  if (q.needValue || (q.needKey && ix.valueOpen)) op = new Fetch(op, rf, q.needKey, q.needValue, plan == SORTED_FETCH);
+  if (!(q.rangeCount && exact)) op = new Filter(op, q.cond, q.tableStats);
+  if (limit >= 0 && q.attr <= 3) op = new Limit(op, limit);
+  if (q.attr <= 3) op = new Project(op, q.attr);
+  if (q.attr == 5) op = maxOp = new MaxKey(op, plan == BACKWARD_SCAN);
+  Count counter(op);
+
+  if (q.attr == 4) rc = counter.count(count);
+  else {
+    RowBatch* batch = new RowBatch;
+    while ((rc = counter.next(*batch)) == 0);
+    delete batch;
+  }
+  count = counter.getCount();
+  if (maxOp != NULL) maxOp->getMax(maxKey);
+  return rc == RC_END_OF_TREE ? 0 : rc;
+}
+
+RC SqlEngine::select(int attr, const string& table, const vector<SelCond>& cond, int limit)
+{
+  RecordFile rf;   // RecordFile containing the table
+  TableIndexes indexes; // the indexes the rows may be read from
+  ScanPlan plan;
+  bool exact;
+  RC rc;
+  int count = 0; // count number of matching tuples
+  int maxKey = 0; // the largest key of the matching tuples, for max(key)
+  int readCount = PageFile::getPageReadCount(); // the pages to charge the in-memory index
 
   // open the table file
   if ((rc = rf.open(table + ".tbl", 'r')) < 0) {
-	fprintf(stderr, "Error: table %s does not exist\n", table.c_str());
-	return rc;
-  }
-  
-	/* START: Dummy flag variables for evaluating select condition expressions */
-
-	bool indexFlag = false; // to check if index file needs to be closed
-	bool condFlag = false; // to check if there is any valid condition
-	bool valueCondFlag = false; // to check if there is any value condition (for speed up)
-	bool valueMismatch = false; // to check if two conditions conflict
-
-	/* Flags for comparators */
-
-	int equalVal = -1; // initialize to any negative number. Doesn't really matter
-	int Eflag = 0; // 0 indicates no equality condition, set to 1 otherwise
-	int GEflag = 0; 
-	int LEflag = 0; 
-	int minVal = -1;
-	int maxVal = -1;
-	bool withoutIndex = false;
-		 
-	int conditionNumber = -1; // track valid conditions
-	
-	/* END: Dummy variables for evaluating select condition expressions */
-	
-	// check all select conditions to draw conclusions for further processing
-	for(int i=0; i<cond.size(); i++)
-	{
-		/* Note: Each condition has 3 params: (a) attr (1: key, 2: value) (b) comp (EQ, GT, etc)
-		and (c) comparison value (char*) */
-
-		int keyValue = atoi(cond[i].value); // get integer equivalent of the comparison value.
-		 
-		// As mentioned, if condition is <> (NE), Index will not be used.
-
-		if(cond[i].attr==1 && cond[i].comp!=SelCond::NE) // for keys not involving NE
-		{
-			condFlag = true; // atleast one valid condition found.
-			
-			// Next, we figure out what exactly is the comparator one by one.
-			switch(cond[i].comp)
-			{
-				case SelCond::EQ: // EQ decides the entire condition => break now.
-				conditionNumber = i; // store the condition number to work on
-				equalVal = keyValue; // now equalVal != -1
-				Eflag = 1; // not 0 anymore
-				break; // we are done if attr = 1
-			
-				case SelCond::GE: // keep updating the minVal value constraint on keys
-				if(minVal==-1 || keyValue > minVal) 
-				{
-					GEflag = 1;
-					minVal = keyValue;
-				}
-				break;
-
-				case SelCond::GT: // keep updating the minVal value constraint on keys
-				if(minVal==-1 || keyValue >= minVal)
-				{
-					GEflag = 0;
-					minVal = keyValue;
-				}
-				break;
-
-				case SelCond::LE: // keep updating the maxVal value constraint on keys
-				if(maxVal==-1 || keyValue < maxVal) 
-				{
-					LEflag = 1;
-					maxVal = keyValue;
-				}
-				break;
-				
-				case SelCond::LT: // keep updating the maxVal value constraint on keys
-				if(maxVal==-1 || keyValue <= maxVal) 
-				{
-					LEflag = 0;
-					maxVal = keyValue;
-				}
-				break;
-			}
-
-		}
-		else if(cond[i].attr==2) // attr = 2 for value
-		{
-			valueCondFlag = true; // value condition found
-			
-			if(cond[i].comp==SelCond::EQ) //check on value equality
-			{
-				string valEq = ""; // dummy used as ""
-				if(strcmp(value.c_str(), cond[i].value)==0) valEq=keyValue;
-				// if value is same as specified earlier => OK
-				else if(valEq=="") valEq = keyValue;
-				// if there is no value specified => OK!
-				else valueMismatch = true;
-				// mismatch in values => Not OK! => won't return any values
-			}
-		}
-	}
-	
-	// check if select conditions make sense. if they conflict, we return 0 tuples.
-
-	bool cond1 = (maxVal!=-1 && minVal!=-1 && !GEflag && !LEflag && maxVal==minVal);
-	bool cond2 = (valueMismatch==true);
-	bool cond3 = (maxVal!=-1 && minVal!=-1 && maxVal<minVal);
-	
-	if(cond1 || cond2 || cond3)
-		goto condition_unmet;
-
-  /* When NOT to use IndexTree ?
-
-  1. Index File not available.
-  2. NE Condition on key
-  3. No other select condition and expression is not 'select count(*) from tablename'*/
-
-  withoutIndex = (!condFlag && attr!=4); // covers condition 2 and 3 above.
-
-  if(tree.open(table + ".idx", 'r')!=0 || withoutIndex)
-  {
-  	// cout<<"Index File Not Found OR Condition not specified"<<endl;
-  	// same code as provided earlier
-	// scan the table file from the beginning
-	  rid.pid = rid.sid = 0;
-	  count = 0;
-	  while (rid < rf.endRid()) {
-		// read the tuple
-		if ((rc = rf.read(rid, key, value)) < 0) {
-		  fprintf(stderr, "Error: while reading a tuple from table %s\n", table.c_str());
-		  goto exit_select;
-		}
-
-		// check the conditions on the tuple
-		for (unsigned i = 0; i < cond.size(); i++) 
-		{
-		  // compute the difference between the tuple value and the condition value
-		  switch (cond[i].attr) 
-		  {
-		  case 1:
-			diff = key - atoi(cond[i].value);
-			break;
-		  case 2:
-			diff = strcmp(value.c_str(), cond[i].value);
-			break;
-		  }
-
-		  // skip the tuple if any condition is not met
-		  switch (cond[i].comp) 
-		  {
-			  case SelCond::EQ:
-				if (diff != 0) goto next_tuple;
-				break;
-			  case SelCond::NE:
-				if (diff == 0) goto next_tuple;
-				break;
-			  case SelCond::GT:
-				if (diff <= 0) goto next_tuple;
-				break;
-			  case SelCond::LT:
-				if (diff >= 0) goto next_tuple;
-				break;
-			  case SelCond::GE:
-				if (diff < 0) goto next_tuple;
-				break;
-			  case SelCond::LE:
-				if (diff > 0) goto next_tuple;
-				break;
-		  }
-		}
-
-		// the condition is met for the tuple. 
-		// increase matching tuple counter
-		count++;
-		//cout<<count<<endl;
-
-		// print the tuple 
-		switch (attr) 
-		{
-			case 1:  // SELECT key
-			  fprintf(stdout, "%d\n", key);
-			  break;
-			case 2:  // SELECT value
-			  fprintf(stdout, "%s\n", value.c_str());
-			  break;
-			case 3:  // SELECT *
-			  fprintf(stdout, "%d '%s'\n", key, value.c_str());
-			  break;
-		}
-
-		// move to the next tuple
-		next_tuple:
-		++rid;
-	  }
-  }
-
-  // If the above "if" wasn't executed, we need to run the indexTree.
-
-  else
-  {
-  	// cout<<"Need to traverse indexTree"<<endl;
-	rid.pid = rid.sid = 0;
-	indexFlag = true; // flag that indexfile is open and needs to be closed
-	
-	// get cursor initial position using equal to and minVal constraints
-	if(Eflag) tree.locate(equalVal, cur); // Eflag = 1 implies equality condition on key
-	else if(minVal!=-1 && !GEflag) tree.locate(minVal+1, cur); // key > minVal constraint
-	else if(minVal!=-1 && GEflag) tree.locate(minVal, cur); // key >= minVal constraint
-	else tree.locate(0, cur);
-	//cout<<"Cursor PID = "<<cur.pid<<endl;
-	//cout<<tree.readForward(cur, key, rid)<<endl;
-
-	/* For normal select, entire table is scanned. However, using index, we start from the
-	   found cursor position and evaluate all conditions for each tuple encountered.*/
-
-	while(tree.readForward(cur, key, rid)==0)
-	{
-		//cout<<"Inside while"<<endl;
-		//cout<<attr<<endl;
-		if(!valueCondFlag && attr==4) // only for speed up of count(*)
-		{
-			if(Eflag && key!=equalVal) // if equalVal doesn't match, end
-				goto condition_unmet;
-			
-			if(maxVal!=-1) // if a condition on LT or LE fails, end
-			{
-				if(LEflag && key>maxVal) goto condition_unmet;
-				else if(!LEflag && key>=maxVal) goto condition_unmet;
-			}
-			
-			if(minVal!=-1) // if a condition of GT or GE fails, end
-			{
-				if(GEflag && key<minVal) goto condition_unmet;
-				else if(!GEflag && key<=minVal) goto condition_unmet;
-			}
-			
-			count++;
-			//cout<<count<<endl;
-			continue;
-		}
-	
-		// read the tuple
-		if ((rc = rf.read(rid, key, value)) < 0) {
-		  fprintf(stderr, "Error: while reading a tuple from table %s\n", table.c_str());
-		  goto exit_select;
-		}
-
-		// check the conditions on the read tuple
-		for (unsigned i = 0; i < cond.size(); i++)
-		{
-			// compute the difference between the tuple value and the condition value
-			switch (cond[i].attr)
-			{
-				//if condition on key
-				case 1:
-					diff = key - atoi(cond[i].value);
-					break;
-				//if condition on value
-				case 2:
-					diff = strcmp(value.c_str(), cond[i].value);
-					break;
-			}
-
-			switch (cond[i].comp)
-			{
-				case SelCond::EQ:
-					if (diff != 0)
-					{
-						if(cond[i].attr==1) goto condition_unmet; // for key, skip all tuples
-						else goto next_cursor; // for value, skip this tuple
-					}
-					break;
-
-				case SelCond::NE:
-					if (diff == 0) goto next_cursor; // skip this tuple
-					break;
-
-				case SelCond::GT:
-					if (diff <= 0) goto next_cursor; // skip this tuple
-					break;
-
-				case SelCond::LT:
-					if (diff >= 0)
-					{
-						if(cond[i].attr==1) goto condition_unmet; // for key, skip all tuples
-						else goto next_cursor; // for value, skip this tuple
-					}
-					break;
-
-				case SelCond::GE:
-					if (diff < 0) goto next_cursor; // skip this tuple
-					break;
-
-				case SelCond::LE:
-					if (diff > 0)
-					{
-						if(cond[i].attr==1) goto condition_unmet; // for key, skip all tuples
-						else goto next_cursor; // for value, skip this tuple
-					}
-					break;
-			}
-		}
-
-		// the condition is met for the tuple. 
-		// increase matching tuple counter
-		count++;
-		// print the tuple 
-		switch (attr)
-		{
-			case 1:  // SELECT key
-			  fprintf(stdout, "%d\n", key);
-			  break;
-			case 2:  // SELECT value
-			  fprintf(stdout, "%s\n", value.c_str());
-			  break;
-			case 3:  // SELECT *
-			  fprintf(stdout, "%d '%s'\n", key, value.c_str());
-			  break;
-		}
-		
-		next_cursor:
-		cout << ""; //do nothing; we use this to jump to the next while cycle
-	}
-  }
-  
-  condition_unmet: // exit early if a condition on a tuple is unmet
-  
+    fprintf(stderr, "Error: table %s does not exist\n", table.c_str());
+    return rc;
+  }
+
+  SelectQuery query(attr, cond);
+  if (query.contradicts()) printPlan(0, "none, the conditions contradict");
+  else {
+    query.readStats(table, rf);
+    Operator* source = chooseSource(table, rf, query, indexes, plan, exact);
+    if (explaining) delete source;
+    else if ((rc = runPipeline(source, rf, query, indexes, plan, exact, limit, count, maxKey)) != 0)
+      fprintf(stderr, "Error: while reading a tuple from table %s\n", table.c_str());
+    else if (indexes.lsmOpen)
+      fprintf(stderr, "  -- lsm %s.lsm: %d of %d runs read\n", table.c_str(), indexes.ltree.getProbedRunCount(), indexes.ltree.getRunCount());
+  }
+
   // print matching tuple count if "select count(*)"
-  if (attr == 4) {
+  if (rc == 0 && attr == 4 && !explaining) {
     fprintf(stdout, "%d\n", count);
   }
-  rc = 0;
 
-  exit_select:
-  if(indexFlag) tree.close(); // indexFlag indicates file was used
-	
+  // print the largest key if "select max(key)", NULL if no tuple matches
+  if (rc == 0 && attr == 5 && !explaining) {
+    if (count > 0) fprintf(stdout, "%d\n", maxKey);
+    else fprintf(stdout, "NULL\n");
+  }
+
+  // the in-memory index would not have served a query that needs the
+  // value either if the B+tree has the values (see chooseSource())
+  if (indexes.artRc == RC_NO_SUCH_RECORD && !(query.needValue && indexes.treeOpen && indexes.tree.includesValue()))
+    ArtIndex::charge(table, PageFile::getPageReadCount() - readCount);
   rf.close();
   return rc;
 }
 
-RC SqlEngine::load(const string& table, const string& loadfile, bool index)
+RC SqlEngine::explain(int attr, const string& table, const vector<SelCond>& cond, int limit)
+{
+  explaining = true;
+  RC rc = select(attr, table, cond, limit);
+  explaining = false;
+  return rc;
+}
+
+/*
+ * The index options of the index files table already has. A LOAD keeps
+ * all of them up to date, not only the ones it names, since select()
+ * uses any index file it finds.
+ */
+static int existingIndexes(const string& table)
+{
+  static const struct { const char* suffix; int option; } files[] = {
+    { ".idx", SqlEngine::KEY_INDEX },
+    { ".vdx", SqlEngine::VALUE_INDEX },
+    { ".hdx", SqlEngine::HASH_INDEX },
+    { ".lsm", SqlEngine::LSM_INDEX },
+    { ".ldx", SqlEngine::LEARNED_INDEX },
+  };
+  struct stat statbuf;
+  int index = 0;
+
+  for (unsigned i = 0; i < sizeof(files)/sizeof(files[0]); i++)
+    if (::stat((table + files[i].suffix).c_str(), &statbuf) == 0) index |= files[i].option;
+  return index;
+}
+
+RC SqlEngine::load(const string& table, const string& loadfile, int index)
 {
 RecordFile rf;
 RecordId rid;
@@ -400,47 +664,139 @@ int key; // key - integer type
 string value; // value - string type
 string tuple; // for storing each line of input
 
-BTreeIndex btree;
+BufferedIndex btree; // unsorted input goes to the tree in sorted batches
+ValueIndex vtree;
+HashIndex htree;
+LsmIndex ltree;
+LearnedIndex mtree;
+TableStats stats; // the statistics for the planner, collected after the load
+
+// compressed leaves only hold (key, RecordId) entries: refuse the pair
+// before any file is created
+if((index & COVERING_INDEX) && (index & COMPRESSED_INDEX))
+{
+   fprintf(stderr, "Error: an index with INCLUDE value cannot be COMPRESSED\n");
+   return RC_INVALID_ATTRIBUTE;
+}
 
 ifstream myfile; // open file in read mode
 myfile.open(loadfile.c_str()); // convert to c_str due to ifstream arguments
 if(myfile.is_open()) // check if the given file could be successfully opened
 {
    rc = rf.open(table + ".tbl", 'w'); // if already present append, else create new
+   index |= existingIndexes(table); // the appended rows go to every index of the table
 
    // insert the index condition here
-   // If index is true, append entry and insert (key, RecordId) it into btree
+   // If index is requested, append entry and insert (key, RecordId) it into btree
    // else simply append the entry.
 int cnt = 0;
-   if(index==true)
+int keyCount = 0, indexWrites = 0, writeCount;
+   if(index & KEY_INDEX)
    {
    		btree.open(table + ".idx", 'w');
+   		btree.setWriteBuffer(INDEX_WRITE_BUFFER);
    		//cout<<index<<endl; all good
-   		while( getline(myfile, tuple) ) // read till the end of file 
- 	  	{
-    	  parseLoadLine(tuple, key, value); // extract key and value from tuple
-      	  
-      	  rc = rf.append(key, value, rid); // append to rf
-
-      	  //cout<<rc<<endl; all good
-
-      	  btree.insert(key, rid); // insert into btree
-      	  //cnt++;
-      	  //cout<<cnt<<endl;
-      	  //cout<<"ERROR CODE: "<<rc<<endl;
+
+   		// a covering index keeps the value next to (key, RecordId) in the leaves
+   		if((index & COVERING_INDEX) && (rc = btree.includeValue()) < 0)
+   		{
+   			fprintf(stderr, "Error: index %s.idx already exists without INCLUDE value\n", table.c_str());
+   			btree.close();
+   			rf.close();
+   			myfile.close();
+   			return rc;
    		}
 
-   		btree.close();
+   		// compressed leaves hold more (key, RecordId) entries per page
+   		if((index & COMPRESSED_INDEX) && (rc = btree.compressLeaves()) < 0)
+   		{
+   			fprintf(stderr, "Error: index %s.idx already exists with uncompressed leaves\n", table.c_str());
+   			btree.close();
+   			rf.close();
+   			myfile.close();
+   			return rc;
+   		}
    }
 
-   else
+   if(index & VALUE_INDEX) vtree.open(table + ".vdx", 'w');
+   if(index & HASH_INDEX) htree.open(table + ".hdx", 'w');
+   if(index & LSM_INDEX) ltree.open(table + ".lsm", 'w');
+   if(index & LEARNED_INDEX) mtree.open(table + ".ldx", 'w');
+
+   while( getline(myfile, tuple) ) // read till the end of file 
    {
-   		while( getline(myfile, tuple) ) // read till the end of file 
- 	  	{
-    	  parseLoadLine(tuple, key, value); // extract key and value from tuple
-      	  rc = rf.append(key, value, rid); // append to rf
-   		}
+   	  parseLoadLine(tuple, key, value); // extract key and value from tuple
+
+   	  // the btree gets the row first, at the rid rf.append() will give it:
+   	  // a key it cannot hold stops the load before the row is in the table
+   	  if(index & KEY_INDEX) // insert into btree
+   	  {
+   	  	  writeCount = PageFile::getPageWriteCount();
+   	  	  rc = btree.insert(key, rf.endRid(), value);
+   	  	  indexWrites += PageFile::getPageWriteCount() - writeCount;
+   	  	  if(rc == RC_INVALID_ATTRIBUTE)
+   	  	  {
+   	  	  	  fprintf(stderr, "Error: line %d: key %d cannot be stored in index %s.idx\n", keyCount+1, key, table.c_str());
+   	  	  	  break;
+   	  	  }
+   	  	  if(rc < 0) break;
+   	  }
+
+   	  rc = rf.append(key, value, rid); // append to rf
+   	  keyCount++;
+
+   	  //cout<<rc<<endl; all good
+
+   	  if(index & VALUE_INDEX) vtree.insert(value, rid); // insert into the value index
+   	  if(index & HASH_INDEX) htree.insert(key, rid); // insert into the hash index
+   	  if(index & LSM_INDEX) ltree.insert(key, rid); // insert into the LSM index
+   	  if(index & LEARNED_INDEX) mtree.insert(key, rid); // insert into the learned index
+   	  //cnt++;
+   	  //cout<<cnt<<endl;
+   	  //cout<<"ERROR CODE: "<<rc<<endl;
+   }
+
+   if(index & KEY_INDEX)
+   {
+   		// write amplification: node writes per inserted key, with the
+   		// write buffer and (counting the writes it absorbed) without
+   		writeCount = PageFile::getPageWriteCount();
+   		btree.flush();
+   		int pageCount = btree.getPageCount();
+   		int coalesced = btree.getCoalescedWriteCount();
+   		btree.close();
+   		indexWrites += PageFile::getPageWriteCount() - writeCount;
+   		fprintf(stderr, "  -- index %s.idx: %d pages, %.2f node writes per key (%.2f unbuffered)\n",
+   		        table.c_str(), pageCount, keyCount ? (double) indexWrites/keyCount : 0.0,
+   		        keyCount ? (double) (indexWrites+coalesced)/keyCount : 0.0);
+   }
+   if(index & VALUE_INDEX)
+   {
+   		fprintf(stderr, "  -- index %s.vdx: %d pages\n", table.c_str(), vtree.getPageCount());
+   		vtree.close();
+   }
+   if(index & HASH_INDEX)
+   {
+   		fprintf(stderr, "  -- index %s.hdx: %d pages\n", table.c_str(), htree.getPageCount());
+   		htree.close();
+   }
+   if(index & LSM_INDEX)
+   {
+   		// write amplification: how many times each loaded key was written
+   		// to a run, counting the compactions the load caused
+   		ltree.flush();
+   		fprintf(stderr, "  -- index %s.lsm: %d runs, %.2f entry writes per key\n", table.c_str(),
+   		        ltree.getRunCount(), keyCount ? (double) ltree.getEntryWriteCount()/keyCount : 0.0);
+   		ltree.close();
+   }
+   if(index & LEARNED_INDEX)
+   {
+   		// the models are fitted when the index is closed
+   		mtree.close();
+   		fprintf(stderr, "  -- index %s.ldx: %d pages, %d models (%d bytes), max error %d\n", table.c_str(),
+   		        mtree.getPageCount(), mtree.getModelCount(), mtree.getModelSize(), mtree.getMaxError());
    }
+   if(stats.collect(rf)==0) stats.write(table); // as ANALYZE does
    rf.close(); // close rf
    myfile.close(); // close myfile
 }
@@ -448,6 +804,213 @@ int cnt = 0;
   return rc; // return result of opening the RecordFile rf
 }
 
+/*
+ * Print the shape of the B+tree in indexname: its height, how full its
+ * leaves are, how often the leaf chain jumps backwards in the file, and
+ * how many pages a scan of all its entries reads.
+ */
+static RC printIndexStats(const string& indexname, const char* label)
+{
+  BTreeIndex tree;
+  IndexCursor cursor;
+  RecordId rid;
+  int key;
+  RC rc;
+
+  if ((rc = tree.open(indexname, 'r')) != 0) return rc;
+
+  int leaves, keys, capacity, backJumps;
+  if ((rc = tree.getLeafStats(leaves, keys, capacity, backJumps)) != 0) {
+    tree.close();
+    return rc;
+  }
+
+  int readCount = PageFile::getPageReadCount();
+  if (tree.getTreeHeight() > 0) {
+    tree.locate(INT_MIN, cursor);
+    while (tree.readForward(cursor, key, rid) == 0);
+  }
+  readCount = PageFile::getPageReadCount() - readCount;
+
+  fprintf(stderr, "  -- %s: height %d, %d pages, %d leaves %.1f%% full, %d backward leaf jumps, %d pages read by a full scan\n",
+          label, tree.getTreeHeight(), tree.getPageCount(), leaves,
+          capacity ? 100.0*keys/capacity : 0.0, backJumps, readCount);
+  return tree.close();
+}
+
+/*
+ * Take the writer lock of a table: open its .tbl for writing, which a
+ * LOAD does before it opens any index of the table, so that no LOAD
+ * appends to the table or inserts into its indexes until rf is closed.
+ * The lock is on the table and not on the index, since an index replaced
+ * by rename() would leave a LOAD waiting for its lock with the old file.
+ * @param table[IN] the table to lock
+ * @param rf[OUT] the table file, open for writing while the lock is held
+ * @return error code. 0 if no error, RC_FILE_OPEN_FAILED if the table
+ *         does not exist
+ */
+static RC lockTable(const string& table, RecordFile& rf)
+{
+  struct stat statbuf;
+
+  if (::stat((table + ".tbl").c_str(), &statbuf) != 0) return RC_FILE_OPEN_FAILED;
+  return rf.open(table + ".tbl", 'w');
+}
+
+RC SqlEngine::rebuildIndex(const string& table, int fillFactor)
+{
+  RecordFile lock; // held from the scan of the old index through the rename
+  BTreeIndex oldTree, newTree;
+  IndexCursor cursor;
+  RecordId rid;
+  string value;
+  bool complete;
+  int key;
+  RC rc;
+
+  string indexname = table + ".idx";
+  string newname = indexname + ".new";
+
+  if (fillFactor < 50 || fillFactor > 100) {
+    fprintf(stderr, "Error: FILLFACTOR %d is out of range (50 to 100)\n", fillFactor);
+    return RC_INVALID_ATTRIBUTE;
+  }
+
+  // a LOAD that inserted into the old index after it was read would lose
+  // its entries in the rename: wait for any LOAD to finish, and keep new
+  // ones out until the new index is in place
+  if ((rc = lockTable(table, lock)) != 0) {
+    fprintf(stderr, "Error: table %s does not exist\n", table.c_str());
+    return rc;
+  }
+  if ((rc = oldTree.open(indexname, 'r')) != 0) {
+    fprintf(stderr, "Error: table %s has no index\n", table.c_str());
+    lock.close();
+    return rc;
+  }
+  printIndexStats(indexname, "before");
+
+  // build the new index next to the old one, which stays in use until
+  // the new one replaces it in a single rename()
+  ::unlink(newname.c_str());
+  newTree.open(newname, 'w');
+  if (oldTree.includesValue()) newTree.includeValue();
+  if (oldTree.leavesCompressed()) newTree.compressLeaves();
+
+  if ((rc = newTree.bulkStart(fillFactor)) == 0 && oldTree.getTreeHeight() > 0) {
+    // the value is only read (and kept) for a covering index
+    oldTree.locate(INT_MIN, cursor);
+    while (rc == 0 && oldTree.readForward(cursor, key, rid, value, complete) == 0)
+      rc = newTree.bulkInsert(key, rid, value);
+  }
+  if (rc == 0) rc = newTree.bulkFinish();
+  newTree.close();
+  oldTree.close();
+
+  if (rc != 0 || ::rename(newname.c_str(), indexname.c_str()) != 0) {
+    fprintf(stderr, "Error: cannot rebuild index %s\n", indexname.c_str());
+    ::unlink(newname.c_str());
+    lock.close();
+    return rc ? rc : RC_FILE_WRITE_FAILED;
+  }
+  lock.close();
+  printIndexStats(indexname, "after");
+  return 0;
+}
+
+RC SqlEngine::createIndex(const string& table, long budget)
+{
+  RecordFile rf;
+  BTreeIndex tree;
+  RecordId rid;
+  struct stat statbuf;
+  struct tms tmsbuf;
+  int keys[RecordFile::RECORDS_PER_PAGE];
+  int key, count, rows = 0;
+  RC rc;
+
+  string indexname = table + ".idx";
+  string newname = indexname + ".new";
+
+  // the table is read under its writer lock, held until the index is in
+  // place: a LOAD ... WITH INDEX that ran in between would have its index
+  // replaced by one without its rows (see rebuildIndex())
+  if ((rc = lockTable(table, rf)) != 0) {
+    fprintf(stderr, "Error: table %s does not exist\n", table.c_str());
+    return rc;
+  }
+  if (::stat(indexname.c_str(), &statbuf) == 0) {
+    fprintf(stderr, "Error: index %s already exists\n", indexname.c_str());
+    rf.close();
+    return RC_INVALID_FILE_FORMAT;
+  }
+
+  clock_t btime = times(&tmsbuf);
+  int threads = max(1, (int) thread::hardware_concurrency());
+  ExternalSort sorter(budget, threads);
+
+  // read the table a page at a time: the records of a page are its slots
+  PageId endPid = rf.endRid().pid + (rf.endRid().sid > 0 ? 1 : 0);
+  for (rid.pid = 0; rc == 0 && rid.pid < endPid; rid.pid++) {
+    if ((rc = rf.readKeys(rid.pid, keys, count)) != 0) break;
+    for (rid.sid = 0; rc == 0 && rid.sid < count; rid.sid++, rows++)
+      rc = sorter.add(keys[rid.sid], rid);
+  }
+  if (rc == 0) rc = sorter.finish();
+
+  // build the index next to where it goes, so that a failed build leaves
+  // no half-written index behind
+  ::unlink(newname.c_str());
+  tree.open(newname, 'w');
+  if (rc == 0) rc = tree.bulkStart(INDEX_FILL_FACTOR);
+  while (rc == 0 && sorter.next(key, rid) == 0) rc = tree.bulkInsert(key, rid, "");
+  if (rc == 0) rc = tree.bulkFinish();
+  int pageCount = tree.getPageCount();
+  tree.close();
+
+  if (rc != 0 || ::rename(newname.c_str(), indexname.c_str()) != 0) {
+    if (rc == RC_INVALID_ATTRIBUTE)
+      fprintf(stderr, "Error: key %d cannot be stored in index %s\n", key, indexname.c_str());
+    else
+      fprintf(stderr, "Error: cannot create index %s\n", indexname.c_str());
+    ::unlink(newname.c_str());
+    rf.close();
+    return rc ? rc : RC_FILE_WRITE_FAILED;
+  }
+  rf.close();
+
+  double seconds = ((double) (times(&tmsbuf) - btime))/sysconf(_SC_CLK_TCK);
+  fprintf(stderr, "  -- index %s: %d pages, %d rows sorted in %d runs (%d on disk) by %d threads, %.3f seconds (%.3f per million rows)\n",
+          indexname.c_str(), pageCount, rows, sorter.getRunCount(), sorter.getSpilledRunCount(), threads,
+          seconds, rows ? seconds*1000000/rows : 0.0);
+  return 0;
+}
+
+RC SqlEngine::analyze(const string& table)
+{
+  RecordFile rf;
+  TableStats stats;
+  RC rc;
+
+  if ((rc = rf.open(table + ".tbl", 'r')) != 0) {
+    fprintf(stderr, "Error: table %s does not exist\n", table.c_str());
+    return rc;
+  }
+  rc = stats.collect(rf);
+  rf.close();
+  if (rc == 0) rc = stats.write(table);
+  if (rc != 0) {
+    fprintf(stderr, "Error: cannot write the statistics of table %s\n", table.c_str());
+    return rc;
+  }
+
+  fprintf(stderr, "  -- statistics of %s: %d rows in %d pages, %d rows sampled; ~%.0f distinct keys in %d histogram buckets, key order %.2f; ~%.0f distinct values, %d common values\n",
+          table.c_str(), stats.getRowCount(), stats.getPageCount(), stats.getSampleRowCount(),
+          stats.getKeyDistinct(), stats.getBucketCount(), stats.getKeyOrder(),
+          stats.getValueDistinct(), stats.getCommonValueCount());
+  return 0;
+}
+
 RC SqlEngine::parseLoadLine(const string& line, int& key, string& value)
 {
     const char *s;
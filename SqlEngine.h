@@ -19,8 +19,9 @@
  */
 struct SelCond {
   int attr;     // attribute: 1 - key column,  2 - value column
-  enum Comparator { EQ, NE, LT, GT, LE, GE } comp;
-  char* value;  // the value to compare
+  enum Comparator { EQ, NE, LT, GT, LE, GE, LIKE, IN } comp;  // LIKE: '%' and '_' wildcards
+  char* value;  // the value to compare (NULL for IN)
+  std::vector<char*> values; // IN: the list of values to compare
 };
 
 /**
@@ -28,6 +29,36 @@ struct SelCond {
  */
 class SqlEngine {
  public:
+  // index options for load(), ORed together in its index argument
+  static const int KEY_INDEX      = 1;  // "WITH INDEX": B+tree index on key
+  static const int COVERING_INDEX = 2;  // "INCLUDE value": the index also stores value
+  static const int VALUE_INDEX    = 4;  // "WITH VALUE INDEX": B+tree index on value
+  static const int HASH_INDEX     = 8;  // "WITH HASH INDEX": hash index on key
+  static const int LSM_INDEX      = 16; // "WITH LSM INDEX": log-structured merge index on key
+  static const int COMPRESSED_INDEX = 32; // "WITH INDEX COMPRESSED": the B+tree leaves are compressed
+  static const int LEARNED_INDEX  = 64; // "WITH LEARNED INDEX": learned (model) index on key
+
+  // index range scans estimated to match at least this many entries read
+  // their records in RecordId order (each table page once) instead of key order
+  static const int SORTED_FETCH_MIN = 64;
+
+  // key conditions on a table whose in-memory index (see ArtIndex) fits in
+  // this many bytes are answered from that index instead of the B+tree
+  static const long MEMORY_INDEX_BUDGET = 16L << 20;
+
+  // LOAD keeps up to this many modified B+tree nodes in memory, and writes
+  // each of them once instead of after every insert into it
+  static const int INDEX_WRITE_BUFFER = 256;
+
+  // REBUILD INDEX and CREATE INDEX fill the leaves and nonleaf nodes of
+  // the new index to this percentage, unless the command gives its own
+  // (WITH FILLFACTOR, 50 to 100). The room left in every leaf takes the
+  // first inserts after a rebuild without splitting it.
+  static const int INDEX_FILL_FACTOR = 90;
+
+  // CREATE INDEX sorts the keys of the table in runs of at most this
+  // many bytes, unless the command gives its own limit
+  static const long SORT_MEMORY_BUDGET = 4L << 20;
     
   /**
    * takes the user commands from commandline and executes them.
@@ -43,21 +74,65 @@ class SqlEngine {
    * all conditions in conds must be ANDed together.
    * the result of the SELECT is printed on screen.
    * @param attr[IN] attribute in the SELECT clause
-   * (1: key, 2: value, 3: *, 4: count(*))
+   * (1: key, 2: value, 3: *, 4: count(*), 5: max(key))
+   * @param table[IN] the table name in the FROM clause
+   * @param conds[IN] list of conditions in the WHERE clause
+   * @param limit[IN] the most rows to print (LIMIT), -1 for all
+   * @return error code. 0 if no error
+   */
+  static RC select(int attr, const std::string& table, const std::vector<SelCond>& conds, int limit);
+
+  /**
+   * explains a SELECT statement: prints how select() would run it, and
+   * how many rows it is estimated to return, without running it.
+   * @param attr[IN] attribute in the SELECT clause, as for select()
    * @param table[IN] the table name in the FROM clause
    * @param conds[IN] list of conditions in the WHERE clause
+   * @param limit[IN] the most rows to print (LIMIT), -1 for all
    * @return error code. 0 if no error
    */
-  static RC select(int attr, const std::string& table, const std::vector<SelCond>& conds);
+  static RC explain(int attr, const std::string& table, const std::vector<SelCond>& conds, int limit);
 
   /**
    * load a table from a load file.
    * @param table[IN] the table name in the LOAD command
    * @param loadfile[IN] the file name of the load file
-   * @param index[IN] true if "WITH INDEX" option was specified
+   * @param index[IN] the index options (KEY_INDEX, COVERING_INDEX, COMPRESSED_INDEX,
+   *                 VALUE_INDEX, HASH_INDEX, LSM_INDEX, LEARNED_INDEX), 0 for none.
+   *                 the indexes the table already has are maintained as well.
+   * @return error code. 0 if no error
+   */
+  static RC load(const std::string& table, const std::string& loadfile, int index);
+
+  /**
+   * rebuild the B+tree index of a table: write a compact copy of it with
+   * the leaves stored in key order and filled to fillFactor percent, and
+   * replace the old index with it. the shape of the index before and
+   * after is printed on screen.
+   * @param table[IN] the table name in the REBUILD INDEX command
+   * @param fillFactor[IN] the percentage of each node to fill (50 to 100)
+   * @return error code. 0 if no error, RC_INVALID_ATTRIBUTE if fillFactor
+   *         is out of range
+   */
+  static RC rebuildIndex(const std::string& table, int fillFactor);
+
+  /**
+   * create the B+tree index of a table loaded without one: the keys of the
+   * table are sorted (see ExternalSort) and the index is built bottom-up.
+   * @param table[IN] the table name in the CREATE INDEX command
+   * @param budget[IN] the bytes of memory the sort may use
+   * @return error code. 0 if no error
+   */
+  static RC createIndex(const std::string& table, long budget);
+
+  /**
+   * collect the statistics of a table (see TableStats) that the planner
+   * estimates the rows of a query with, and print a summary of them.
+   * LOAD collects them too, after every load.
+   * @param table[IN] the table name in the ANALYZE command
    * @return error code. 0 if no error
    */
-  static RC load(const std::string& table, const std::string& loadfile, bool index);
+  static RC analyze(const std::string& table);
 
   /**
    * parse a line from the load file into the (key, value) pair.
@@ -1,8 +1,9 @@
-/* A Bison parser, made by GNU Bison 3.0.2.  */
+/* A Bison parser, made by GNU Bison 3.8.2.  */
 
 /* Bison implementation for Yacc-like parsers in C
 
-   Copyright (C) 1984, 1989-1990, 2000-2013 Free Software Foundation, Inc.
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
+   Inc.
 
    This program is free software: you can redistribute it and/or modify
    it under the terms of the GNU General Public License as published by
@@ -15,7 +16,7 @@
    GNU General Public License for more details.
 
    You should have received a copy of the GNU General Public License
-   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
 
 /* As a special exception, you may create a larger work that contains
    part or all of the Bison parser skeleton and distribute that work
@@ -33,6 +34,10 @@
 /* C LALR(1) parser skeleton written by Richard Stallman, by
    simplifying the original so-called "semantic" parser.  */
 
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
 /* All symbols defined below should begin with yy or YY, to avoid
    infringing on user name space.  This should be done even for local
    variables, as they might otherwise be expanded by user macros.
@@ -40,11 +45,11 @@
    define necessary library symbols; they are noted "INFRINGES ON
    USER NAME SPACE" below.  */
 
-/* Identify Bison output.  */
-#define YYBISON 1
+/* Identify Bison output, and Bison version.  */
+#define YYBISON 30802
 
-/* Bison version.  */
-#define YYBISON_VERSION "3.0.2"
+/* Bison version string.  */
+#define YYBISON_VERSION "3.8.2"
 
 /* Skeleton name.  */
 #define YYSKELETON_NAME "yacc.c"
@@ -65,15 +70,15 @@
 #define yyerror         sqlerror
 #define yydebug         sqldebug
 #define yynerrs         sqlnerrs
-
 #define yylval          sqllval
 #define yychar          sqlchar
 
-/* Copy the first part of user declarations.  */
-#line 1 "SqlParser.y" /* yacc.c:339  */
+/* First part of user prologue.  */
+#line 1 "SqlParser.y"
 
 #include <cstdio>
 #include <cstring>
+#include <cstdlib>
 #include <sys/times.h>
 #include <unistd.h>
 #include <climits>
@@ -86,7 +91,7 @@ int  sqllex(void);
 void sqlerror(const char *str) { fprintf(stderr, "Error: %s\n", str); }
 extern "C" { int  sqlwrap() { return 1; } }
 
-static void runSelect(int attr, const char* table, const std::vector<SelCond>& conds)
+static void runSelect(int attr, const char* table, const std::vector<SelCond>& conds, int limit, bool explain)
 {
   struct tms tmsbuf;
   clock_t btime, etime;
@@ -94,7 +99,8 @@ static void runSelect(int attr, const char* table, const std::vector<SelCond>& c
 
   btime = times(&tmsbuf);
   bpagecnt = PageFile::getPageReadCount();
-  SqlEngine::select(attr, table, conds);
+  if (explain) SqlEngine::explain(attr, table, conds, limit);
+  else SqlEngine::select(attr, table, conds, limit);
   etime = times(&tmsbuf);
   epagecnt = PageFile::getPageReadCount();
 
@@ -102,121 +108,172 @@ static void runSelect(int attr, const char* table, const std::vector<SelCond>& c
 }
 
 
-#line 106 "SqlParser.tab.c" /* yacc.c:339  */
+#line 112 "SqlParser.tab.c"
 
+# ifndef YY_CAST
+#  ifdef __cplusplus
+#   define YY_CAST(Type, Val) static_cast<Type> (Val)
+#   define YY_REINTERPRET_CAST(Type, Val) reinterpret_cast<Type> (Val)
+#  else
+#   define YY_CAST(Type, Val) ((Type) (Val))
+#   define YY_REINTERPRET_CAST(Type, Val) ((Type) (Val))
+#  endif
+# endif
 # ifndef YY_NULLPTR
-#  if defined __cplusplus && 201103L <= __cplusplus
-#   define YY_NULLPTR nullptr
+#  if defined __cplusplus
+#   if 201103L <= __cplusplus
+#    define YY_NULLPTR nullptr
+#   else
+#    define YY_NULLPTR 0
+#   endif
 #  else
-#   define YY_NULLPTR 0
+#   define YY_NULLPTR ((void*)0)
 #  endif
 # endif
 
-/* Enabling verbose error messages.  */
-#ifdef YYERROR_VERBOSE
-# undef YYERROR_VERBOSE
-# define YYERROR_VERBOSE 1
-#else
-# define YYERROR_VERBOSE 0
-#endif
-
-/* In a future release of Bison, this section will be replaced
-   by #include "SqlParser.tab.h".  */
-#ifndef YY_SQL_SQLPARSER_TAB_H_INCLUDED
-# define YY_SQL_SQLPARSER_TAB_H_INCLUDED
-/* Debug traces.  */
-#ifndef YYDEBUG
-# define YYDEBUG 0
-#endif
-#if YYDEBUG
-extern int sqldebug;
-#endif
-
-/* Token type.  */
-#ifndef YYTOKENTYPE
-# define YYTOKENTYPE
-  enum yytokentype
-  {
-    SELECT = 258,
-    FROM = 259,
-    WHERE = 260,
-    LOAD = 261,
-    WITH = 262,
-    INDEX = 263,
-    QUIT = 264,
-    COUNT = 265,
-    AND = 266,
-    OR = 267,
-    COMMA = 268,
-    STAR = 269,
-    LF = 270,
-    INTEGER = 271,
-    STRING = 272,
-    ID = 273,
-    EQUAL = 274,
-    NEQUAL = 275,
-    LESS = 276,
-    LESSEQUAL = 277,
-    GREATER = 278,
-    GREATEREQUAL = 279
-  };
-#endif
-
-/* Value type.  */
-#if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
-typedef union YYSTYPE YYSTYPE;
-union YYSTYPE
+#include "SqlParser.tab.h"
+/* Symbol kind.  */
+enum yysymbol_kind_t
 {
-#line 33 "SqlParser.y" /* yacc.c:355  */
-
-  int integer;
-  char* string;
-  SelCond* cond;
-  std::vector<SelCond>* conds;
-
-#line 178 "SqlParser.tab.c" /* yacc.c:355  */
+  YYSYMBOL_YYEMPTY = -2,
+  YYSYMBOL_YYEOF = 0,                      /* "end of file"  */
+  YYSYMBOL_YYerror = 1,                    /* error  */
+  YYSYMBOL_YYUNDEF = 2,                    /* "invalid token"  */
+  YYSYMBOL_SELECT = 3,                     /* SELECT  */
+  YYSYMBOL_FROM = 4,                       /* FROM  */
+  YYSYMBOL_WHERE = 5,                      /* WHERE  */
+  YYSYMBOL_LOAD = 6,                       /* LOAD  */
+  YYSYMBOL_WITH = 7,                       /* WITH  */
+  YYSYMBOL_INDEX = 8,                      /* INDEX  */
+  YYSYMBOL_QUIT = 9,                       /* QUIT  */
+  YYSYMBOL_COUNT = 10,                     /* COUNT  */
+  YYSYMBOL_AND = 11,                       /* AND  */
+  YYSYMBOL_OR = 12,                        /* OR  */
+  YYSYMBOL_COMMA = 13,                     /* COMMA  */
+  YYSYMBOL_STAR = 14,                      /* STAR  */
+  YYSYMBOL_LF = 15,                        /* LF  */
+  YYSYMBOL_INTEGER = 16,                   /* INTEGER  */
+  YYSYMBOL_STRING = 17,                    /* STRING  */
+  YYSYMBOL_ID = 18,                        /* ID  */
+  YYSYMBOL_EQUAL = 19,                     /* EQUAL  */
+  YYSYMBOL_NEQUAL = 20,                    /* NEQUAL  */
+  YYSYMBOL_LESS = 21,                      /* LESS  */
+  YYSYMBOL_LESSEQUAL = 22,                 /* LESSEQUAL  */
+  YYSYMBOL_GREATER = 23,                   /* GREATER  */
+  YYSYMBOL_GREATEREQUAL = 24,              /* GREATEREQUAL  */
+  YYSYMBOL_25_ = 25,                       /* '('  */
+  YYSYMBOL_26_ = 26,                       /* ')'  */
+  YYSYMBOL_YYACCEPT = 27,                  /* $accept  */
+  YYSYMBOL_commands = 28,                  /* commands  */
+  YYSYMBOL_command = 29,                   /* command  */
+  YYSYMBOL_quit_command = 30,              /* quit_command  */
+  YYSYMBOL_load_command = 31,              /* load_command  */
+  YYSYMBOL_load_options = 32,              /* load_options  */
+  YYSYMBOL_index_option = 33,              /* index_option  */
+  YYSYMBOL_index_command = 34,             /* index_command  */
+  YYSYMBOL_analyze_command = 35,           /* analyze_command  */
+  YYSYMBOL_select_command = 36,            /* select_command  */
+  YYSYMBOL_limit_option = 37,              /* limit_option  */
+  YYSYMBOL_explain_option = 38,            /* explain_option  */
+  YYSYMBOL_conditions = 39,                /* conditions  */
+  YYSYMBOL_condition = 40,                 /* condition  */
+  YYSYMBOL_value_list = 41,                /* value_list  */
+  YYSYMBOL_attributes = 42,                /* attributes  */
+  YYSYMBOL_attribute = 43,                 /* attribute  */
+  YYSYMBOL_value = 44,                     /* value  */
+  YYSYMBOL_table = 45,                     /* table  */
+  YYSYMBOL_comparator = 46                 /* comparator  */
 };
-# define YYSTYPE_IS_TRIVIAL 1
-# define YYSTYPE_IS_DECLARED 1
-#endif
+typedef enum yysymbol_kind_t yysymbol_kind_t;
 
 
-extern YYSTYPE sqllval;
 
-int sqlparse (void);
-
-#endif /* !YY_SQL_SQLPARSER_TAB_H_INCLUDED  */
-
-/* Copy the second part of user declarations.  */
-
-#line 193 "SqlParser.tab.c" /* yacc.c:358  */
 
 #ifdef short
 # undef short
 #endif
 
-#ifdef YYTYPE_UINT8
-typedef YYTYPE_UINT8 yytype_uint8;
-#else
-typedef unsigned char yytype_uint8;
+/* On compilers that do not define __PTRDIFF_MAX__ etc., make sure
+   <limits.h> and (if available) <stdint.h> are included
+   so that the code can choose integer types of a good width.  */
+
+#ifndef __PTRDIFF_MAX__
+# include <limits.h> /* INFRINGES ON USER NAME SPACE */
+# if defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
+#  include <stdint.h> /* INFRINGES ON USER NAME SPACE */
+#  define YY_STDINT_H
+# endif
 #endif
 
-#ifdef YYTYPE_INT8
-typedef YYTYPE_INT8 yytype_int8;
+/* Narrow types that promote to a signed type and that can represent a
+   signed or unsigned integer of at least N bits.  In tables they can
+   save space and decrease cache pressure.  Promoting to a signed type
+   helps avoid bugs in integer arithmetic.  */
+
+#ifdef __INT_LEAST8_MAX__
+typedef __INT_LEAST8_TYPE__ yytype_int8;
+#elif defined YY_STDINT_H
+typedef int_least8_t yytype_int8;
 #else
 typedef signed char yytype_int8;
 #endif
 
-#ifdef YYTYPE_UINT16
-typedef YYTYPE_UINT16 yytype_uint16;
+#ifdef __INT_LEAST16_MAX__
+typedef __INT_LEAST16_TYPE__ yytype_int16;
+#elif defined YY_STDINT_H
+typedef int_least16_t yytype_int16;
+#else
+typedef short yytype_int16;
+#endif
+
+/* Work around bug in HP-UX 11.23, which defines these macros
+   incorrectly for preprocessor constants.  This workaround can likely
+   be removed in 2023, as HPE has promised support for HP-UX 11.23
+   (aka HP-UX 11i v2) only through the end of 2022; see Table 2 of
+   <https://h20195.www2.hpe.com/V2/getpdf.aspx/4AA4-7673ENW.pdf>.  */
+#ifdef __hpux
+# undef UINT_LEAST8_MAX
+# undef UINT_LEAST16_MAX
+# define UINT_LEAST8_MAX 255
+# define UINT_LEAST16_MAX 65535
+#endif
+
+#if defined __UINT_LEAST8_MAX__ && __UINT_LEAST8_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST8_TYPE__ yytype_uint8;
+#elif (!defined __UINT_LEAST8_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST8_MAX <= INT_MAX)
+typedef uint_least8_t yytype_uint8;
+#elif !defined __UINT_LEAST8_MAX__ && UCHAR_MAX <= INT_MAX
+typedef unsigned char yytype_uint8;
 #else
-typedef unsigned short int yytype_uint16;
+typedef short yytype_uint8;
 #endif
 
-#ifdef YYTYPE_INT16
-typedef YYTYPE_INT16 yytype_int16;
+#if defined __UINT_LEAST16_MAX__ && __UINT_LEAST16_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST16_TYPE__ yytype_uint16;
+#elif (!defined __UINT_LEAST16_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST16_MAX <= INT_MAX)
+typedef uint_least16_t yytype_uint16;
+#elif !defined __UINT_LEAST16_MAX__ && USHRT_MAX <= INT_MAX
+typedef unsigned short yytype_uint16;
 #else
-typedef short int yytype_int16;
+typedef int yytype_uint16;
+#endif
+
+#ifndef YYPTRDIFF_T
+# if defined __PTRDIFF_TYPE__ && defined __PTRDIFF_MAX__
+#  define YYPTRDIFF_T __PTRDIFF_TYPE__
+#  define YYPTRDIFF_MAXIMUM __PTRDIFF_MAX__
+# elif defined PTRDIFF_MAX
+#  ifndef ptrdiff_t
+#   include <stddef.h> /* INFRINGES ON USER NAME SPACE */
+#  endif
+#  define YYPTRDIFF_T ptrdiff_t
+#  define YYPTRDIFF_MAXIMUM PTRDIFF_MAX
+# else
+#  define YYPTRDIFF_T long
+#  define YYPTRDIFF_MAXIMUM LONG_MAX
+# endif
 #endif
 
 #ifndef YYSIZE_T
@@ -224,15 +281,28 @@ typedef short int yytype_int16;
 #  define YYSIZE_T __SIZE_TYPE__
 # elif defined size_t
 #  define YYSIZE_T size_t
-# elif ! defined YYSIZE_T
+# elif defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
 #  include <stddef.h> /* INFRINGES ON USER NAME SPACE */
 #  define YYSIZE_T size_t
 # else
-#  define YYSIZE_T unsigned int
+#  define YYSIZE_T unsigned
 # endif
 #endif
 
-#define YYSIZE_MAXIMUM ((YYSIZE_T) -1)
+#define YYSIZE_MAXIMUM                                  \
+  YY_CAST (YYPTRDIFF_T,                                 \
+           (YYPTRDIFF_MAXIMUM < YY_CAST (YYSIZE_T, -1)  \
+            ? YYPTRDIFF_MAXIMUM                         \
+            : YY_CAST (YYSIZE_T, -1)))
+
+#define YYSIZEOF(X) YY_CAST (YYPTRDIFF_T, sizeof (X))
+
+
+/* Stored state numbers (used for stacks). */
+typedef yytype_int8 yy_state_t;
+
+/* State numbers in computations.  */
+typedef int yy_state_fast_t;
 
 #ifndef YY_
 # if defined YYENABLE_NLS && YYENABLE_NLS
@@ -246,47 +316,43 @@ typedef short int yytype_int16;
 # endif
 #endif
 
-#ifndef YY_ATTRIBUTE
-# if (defined __GNUC__                                               \
-      && (2 < __GNUC__ || (__GNUC__ == 2 && 96 <= __GNUC_MINOR__)))  \
-     || defined __SUNPRO_C && 0x5110 <= __SUNPRO_C
-#  define YY_ATTRIBUTE(Spec) __attribute__(Spec)
-# else
-#  define YY_ATTRIBUTE(Spec) /* empty */
-# endif
-#endif
 
 #ifndef YY_ATTRIBUTE_PURE
-# define YY_ATTRIBUTE_PURE   YY_ATTRIBUTE ((__pure__))
+# if defined __GNUC__ && 2 < __GNUC__ + (96 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_PURE __attribute__ ((__pure__))
+# else
+#  define YY_ATTRIBUTE_PURE
+# endif
 #endif
 
 #ifndef YY_ATTRIBUTE_UNUSED
-# define YY_ATTRIBUTE_UNUSED YY_ATTRIBUTE ((__unused__))
-#endif
-
-#if !defined _Noreturn \
-     && (!defined __STDC_VERSION__ || __STDC_VERSION__ < 201112)
-# if defined _MSC_VER && 1200 <= _MSC_VER
-#  define _Noreturn __declspec (noreturn)
+# if defined __GNUC__ && 2 < __GNUC__ + (7 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_UNUSED __attribute__ ((__unused__))
 # else
-#  define _Noreturn YY_ATTRIBUTE ((__noreturn__))
+#  define YY_ATTRIBUTE_UNUSED
 # endif
 #endif
 
 /* Suppress unused-variable warnings by "using" E.  */
 #if ! defined lint || defined __GNUC__
-# define YYUSE(E) ((void) (E))
+# define YY_USE(E) ((void) (E))
 #else
-# define YYUSE(E) /* empty */
+# define YY_USE(E) /* empty */
 #endif
 
-#if defined __GNUC__ && 407 <= __GNUC__ * 100 + __GNUC_MINOR__
 /* Suppress an incorrect diagnostic about yylval being uninitialized.  */
-# define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN \
-    _Pragma ("GCC diagnostic push") \
-    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")\
+#if defined __GNUC__ && ! defined __ICC && 406 <= __GNUC__ * 100 + __GNUC_MINOR__
+# if __GNUC__ * 100 + __GNUC_MINOR__ < 407
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")
+# else
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")              \
     _Pragma ("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
-# define YY_IGNORE_MAYBE_UNINITIALIZED_END \
+# endif
+# define YY_IGNORE_MAYBE_UNINITIALIZED_END      \
     _Pragma ("GCC diagnostic pop")
 #else
 # define YY_INITIAL_VALUE(Value) Value
@@ -299,8 +365,22 @@ typedef short int yytype_int16;
 # define YY_INITIAL_VALUE(Value) /* Nothing. */
 #endif
 
+#if defined __cplusplus && defined __GNUC__ && ! defined __ICC && 6 <= __GNUC__
+# define YY_IGNORE_USELESS_CAST_BEGIN                          \
+    _Pragma ("GCC diagnostic push")                            \
+    _Pragma ("GCC diagnostic ignored \"-Wuseless-cast\"")
+# define YY_IGNORE_USELESS_CAST_END            \
+    _Pragma ("GCC diagnostic pop")
+#endif
+#ifndef YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_END
+#endif
+
 
-#if ! defined yyoverflow || YYERROR_VERBOSE
+#define YY_ASSERT(E) ((void) (0 && (E)))
+
+#if !defined yyoverflow
 
 /* The parser invokes alloca or malloc; define the necessary symbols.  */
 
@@ -365,8 +445,7 @@ void free (void *); /* INFRINGES ON USER NAME SPACE */
 #   endif
 #  endif
 # endif
-#endif /* ! defined yyoverflow || YYERROR_VERBOSE */
-
+#endif /* !defined yyoverflow */
 
 #if (! defined yyoverflow \
      && (! defined __cplusplus \
@@ -375,17 +454,17 @@ void free (void *); /* INFRINGES ON USER NAME SPACE */
 /* A type that is properly aligned for any stack member.  */
 union yyalloc
 {
-  yytype_int16 yyss_alloc;
+  yy_state_t yyss_alloc;
   YYSTYPE yyvs_alloc;
 };
 
 /* The size of the maximum gap between one aligned stack and the next.  */
-# define YYSTACK_GAP_MAXIMUM (sizeof (union yyalloc) - 1)
+# define YYSTACK_GAP_MAXIMUM (YYSIZEOF (union yyalloc) - 1)
 
 /* The size of an array large to enough to hold all stacks, each with
    N elements.  */
 # define YYSTACK_BYTES(N) \
-     ((N) * (sizeof (yytype_int16) + sizeof (YYSTYPE)) \
+     ((N) * (YYSIZEOF (yy_state_t) + YYSIZEOF (YYSTYPE)) \
       + YYSTACK_GAP_MAXIMUM)
 
 # define YYCOPY_NEEDED 1
@@ -398,11 +477,11 @@ union yyalloc
 # define YYSTACK_RELOCATE(Stack_alloc, Stack)                           \
     do                                                                  \
       {                                                                 \
-        YYSIZE_T yynewbytes;                                            \
+        YYPTRDIFF_T yynewbytes;                                         \
         YYCOPY (&yyptr->Stack_alloc, Stack, yysize);                    \
         Stack = &yyptr->Stack_alloc;                                    \
-        yynewbytes = yystacksize * sizeof (*Stack) + YYSTACK_GAP_MAXIMUM; \
-        yyptr += yynewbytes / sizeof (*yyptr);                          \
+        yynewbytes = yystacksize * YYSIZEOF (*Stack) + YYSTACK_GAP_MAXIMUM; \
+        yyptr += yynewbytes / YYSIZEOF (*yyptr);                        \
       }                                                                 \
     while (0)
 
@@ -414,12 +493,12 @@ union yyalloc
 # ifndef YYCOPY
 #  if defined __GNUC__ && 1 < __GNUC__
 #   define YYCOPY(Dst, Src, Count) \
-      __builtin_memcpy (Dst, Src, (Count) * sizeof (*(Src)))
+      __builtin_memcpy (Dst, Src, YY_CAST (YYSIZE_T, (Count)) * sizeof (*(Src)))
 #  else
 #   define YYCOPY(Dst, Src, Count)              \
       do                                        \
         {                                       \
-          YYSIZE_T yyi;                         \
+          YYPTRDIFF_T yyi;                      \
           for (yyi = 0; yyi < (Count); yyi++)   \
             (Dst)[yyi] = (Src)[yyi];            \
         }                                       \
@@ -431,34 +510,37 @@ union yyalloc
 /* YYFINAL -- State number of the termination state.  */
 #define YYFINAL  2
 /* YYLAST -- Last index in YYTABLE.  */
-#define YYLAST   33
+#define YYLAST   73
 
 /* YYNTOKENS -- Number of terminals.  */
-#define YYNTOKENS  25
+#define YYNTOKENS  27
 /* YYNNTS -- Number of nonterminals.  */
-#define YYNNTS  13
+#define YYNNTS  20
 /* YYNRULES -- Number of rules.  */
-#define YYNRULES  29
+#define YYNRULES  50
 /* YYNSTATES -- Number of states.  */
-#define YYNSTATES  46
+#define YYNSTATES  87
 
-/* YYTRANSLATE[YYX] -- Symbol number corresponding to YYX as returned
-   by yylex, with out-of-bounds checking.  */
-#define YYUNDEFTOK  2
+/* YYMAXUTOK -- Last valid token kind.  */
 #define YYMAXUTOK   279
 
-#define YYTRANSLATE(YYX)                                                \
-  ((unsigned int) (YYX) <= YYMAXUTOK ? yytranslate[YYX] : YYUNDEFTOK)
+
+/* YYTRANSLATE(TOKEN-NUM) -- Symbol number corresponding to TOKEN-NUM
+   as returned by yylex, with out-of-bounds checking.  */
+#define YYTRANSLATE(YYX)                                \
+  (0 <= (YYX) && (YYX) <= YYMAXUTOK                     \
+   ? YY_CAST (yysymbol_kind_t, yytranslate[YYX])        \
+   : YYSYMBOL_YYUNDEF)
 
 /* YYTRANSLATE[TOKEN-NUM] -- Symbol number corresponding to TOKEN-NUM
-   as returned by yylex, without out-of-bounds checking.  */
-static const yytype_uint8 yytranslate[] =
+   as returned by yylex.  */
+static const yytype_int8 yytranslate[] =
 {
        0,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
-       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+      25,    26,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
@@ -485,167 +567,200 @@ static const yytype_uint8 yytranslate[] =
 };
 
 #if YYDEBUG
-  /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
-static const yytype_uint8 yyrline[] =
+/* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
+static const yytype_int16 yyrline[] =
 {
-       0,    52,    52,    53,    57,    58,    59,    60,    61,    65,
-      69,    74,    82,    87,    98,   104,   112,   122,   123,   124,
-     128,   136,   137,   141,   145,   146,   147,   148,   149,   150
+       0,    56,    56,    57,    61,    62,    63,    64,    65,    66,
+      67,    71,    75,    83,    84,    88,    89,    96,   104,   116,
+     122,   131,   138,   151,   160,   165,   177,   184,   188,   193,
+     197,   203,   211,   218,   232,   252,   256,   263,   264,   265,
+     266,   276,   284,   285,   289,   293,   294,   295,   296,   297,
+     298
 };
 #endif
 
-#if YYDEBUG || YYERROR_VERBOSE || 0
+/** Accessing symbol of state STATE.  */
+#define YY_ACCESSING_SYMBOL(State) YY_CAST (yysymbol_kind_t, yystos[State])
+
+#if YYDEBUG || 0
+/* The user-facing name of the symbol whose (internal) number is
+   YYSYMBOL.  No bounds checking.  */
+static const char *yysymbol_name (yysymbol_kind_t yysymbol) YY_ATTRIBUTE_UNUSED;
+
 /* YYTNAME[SYMBOL-NUM] -- String name of the symbol SYMBOL-NUM.
    First, the terminals, then, starting at YYNTOKENS, nonterminals.  */
 static const char *const yytname[] =
 {
-  "$end", "error", "$undefined", "SELECT", "FROM", "WHERE", "LOAD",
-  "WITH", "INDEX", "QUIT", "COUNT", "AND", "OR", "COMMA", "STAR", "LF",
-  "INTEGER", "STRING", "ID", "EQUAL", "NEQUAL", "LESS", "LESSEQUAL",
-  "GREATER", "GREATEREQUAL", "$accept", "commands", "command",
-  "quit_command", "load_command", "select_command", "conditions",
-  "condition", "attributes", "attribute", "value", "table", "comparator", YY_NULLPTR
+  "\"end of file\"", "error", "\"invalid token\"", "SELECT", "FROM",
+  "WHERE", "LOAD", "WITH", "INDEX", "QUIT", "COUNT", "AND", "OR", "COMMA",
+  "STAR", "LF", "INTEGER", "STRING", "ID", "EQUAL", "NEQUAL", "LESS",
+  "LESSEQUAL", "GREATER", "GREATEREQUAL", "'('", "')'", "$accept",
+  "commands", "command", "quit_command", "load_command", "load_options",
+  "index_option", "index_command", "analyze_command", "select_command",
+  "limit_option", "explain_option", "conditions", "condition",
+  "value_list", "attributes", "attribute", "value", "table", "comparator", YY_NULLPTR
 };
-#endif
 
-# ifdef YYPRINT
-/* YYTOKNUM[NUM] -- (External) token number corresponding to the
-   (internal) symbol number NUM (which must be that of a token).  */
-static const yytype_uint16 yytoknum[] =
+static const char *
+yysymbol_name (yysymbol_kind_t yysymbol)
 {
-       0,   256,   257,   258,   259,   260,   261,   262,   263,   264,
-     265,   266,   267,   268,   269,   270,   271,   272,   273,   274,
-     275,   276,   277,   278,   279
-};
-# endif
+  return yytname[yysymbol];
+}
+#endif
 
-#define YYPACT_NINF -14
+#define YYPACT_NINF (-71)
 
-#define yypact_value_is_default(Yystate) \
-  (!!((Yystate) == (-14)))
+#define yypact_value_is_default(Yyn) \
+  ((Yyn) == YYPACT_NINF)
 
-#define YYTABLE_NINF -1
+#define YYTABLE_NINF (-30)
 
-#define yytable_value_is_error(Yytable_value) \
+#define yytable_value_is_error(Yyn) \
   0
 
-  /* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
-     STATE-NUM.  */
+/* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
+   STATE-NUM.  */
 static const yytype_int8 yypact[] =
 {
-     -14,     0,   -14,    -5,     3,     2,   -14,   -14,   -14,   -14,
-     -14,   -14,   -14,   -14,   -14,   -14,    10,   -14,   -14,    14,
-       2,     5,    -3,     1,    11,   -14,    22,   -14,    -4,   -14,
-       4,    16,    11,   -14,   -14,   -14,   -14,   -14,   -14,   -14,
-     -12,   -14,   -14,   -14,   -14,   -14
+     -71,     1,   -71,    -9,    -1,   -71,   -71,     4,   -71,   -71,
+     -71,   -71,   -71,   -71,    17,   -71,   -71,    28,    23,    27,
+      16,    21,    -1,    20,   -71,   -71,   -71,    15,    49,   -71,
+     -71,    22,    36,   -71,    37,    -1,    24,    38,   -71,    41,
+      32,     0,     5,   -71,    43,    45,   -71,    44,    47,    46,
+      48,    56,   -71,    50,   -71,   -71,    25,   -71,    26,   -71,
+     -71,    51,   -71,   -71,    44,    52,     8,   -71,   -71,   -71,
+     -71,   -71,   -71,    35,   -71,   -71,   -71,   -71,   -71,    35,
+     -71,   -71,    -5,   -71,    35,   -71,   -71
 };
 
-  /* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
-     Performed when YYTABLE does not specify something else to do.  Zero
-     means the default is an error.  */
-static const yytype_uint8 yydefact[] =
+/* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
+   Performed when YYTABLE does not specify something else to do.  Zero
+   means the default is an error.  */
+static const yytype_int8 yydefact[] =
 {
-       3,     0,     1,     0,     0,     0,     9,     8,     2,     6,
-       4,     5,     7,    19,    18,    20,     0,    17,    23,     0,
-       0,     0,     0,     0,     0,    12,     0,    10,     0,    14,
-       0,     0,     0,    13,    24,    25,    26,    28,    27,    29,
-       0,    11,    15,    21,    22,    16
+       3,     0,     1,     0,     0,    11,    10,    28,     2,     8,
+       4,     6,     7,     5,     0,     9,    44,     0,     0,     0,
+       0,     0,    44,     0,    23,    39,    38,    41,     0,    37,
+      14,     0,     0,    19,     0,     0,     0,     0,    21,     0,
+       0,    27,     0,    12,     0,     0,    40,     0,     0,     0,
+      15,     0,    13,     0,    20,    41,    27,    30,     0,    26,
+      24,    16,    18,    22,     0,     0,     0,    45,    46,    47,
+      49,    48,    50,     0,    17,    31,    25,    42,    43,     0,
+      33,    32,     0,    35,     0,    34,    36
 };
 
-  /* YYPGOTO[NTERM-NUM].  */
+/* YYPGOTO[NTERM-NUM].  */
 static const yytype_int8 yypgoto[] =
 {
-     -14,   -14,   -14,   -14,   -14,   -14,   -14,   -13,   -14,    28,
-     -14,    13,   -14
+     -71,   -71,   -71,   -71,   -71,   -71,   -71,   -71,   -71,   -71,
+      12,   -71,   -71,     6,   -71,   -71,    53,   -70,    -7,   -71
 };
 
-  /* YYDEFGOTO[NTERM-NUM].  */
+/* YYDEFGOTO[NTERM-NUM].  */
 static const yytype_int8 yydefgoto[] =
 {
-      -1,     1,     8,     9,    10,    11,    28,    29,    16,    30,
-      45,    19,    40
+       0,     1,     8,     9,    10,    36,    52,    11,    12,    13,
+      49,    14,    56,    57,    82,    28,    58,    80,    17,    73
 };
 
-  /* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
-     positive, shift that token.  If negative, reduce the rule whose
-     number is the opposite.  If YYTABLE_NINF, syntax error.  */
-static const yytype_uint8 yytable[] =
+/* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
+   positive, shift that token.  If negative, reduce the rule whose
+   number is the opposite.  If YYTABLE_NINF, syntax error.  */
+static const yytype_int8 yytable[] =
 {
-       2,     3,    24,     4,    43,    44,     5,    32,    26,     6,
-      12,    33,    25,    13,    20,     7,    27,    14,    21,    42,
-      18,    15,    23,    34,    35,    36,    37,    38,    39,    15,
-      31,    41,    17,    22
+      19,     2,     3,    81,   -29,    47,    15,     4,    84,    83,
+       5,    23,    18,    50,    86,    31,     6,    16,    48,     7,
+      20,    85,    16,    51,    77,    78,    25,    32,    41,    37,
+      26,    42,    21,    79,    27,    33,    64,    38,    30,    43,
+      34,    22,    24,    48,    66,    67,    68,    69,    70,    71,
+      72,    77,    78,    35,    39,    40,    44,    45,    46,    53,
+      54,    60,    55,    59,    62,    63,    61,    76,    65,    74,
+      75,     0,     0,    29
 };
 
-static const yytype_uint8 yycheck[] =
+static const yytype_int8 yycheck[] =
 {
-       0,     1,     5,     3,    16,    17,     6,    11,     7,     9,
-      15,    15,    15,    10,     4,    15,    15,    14,     4,    32,
-      18,    18,    17,    19,    20,    21,    22,    23,    24,    18,
-       8,    15,     4,    20
+       7,     0,     1,    73,     3,     5,    15,     6,    13,    79,
+       9,    18,     8,     8,    84,    22,    15,    18,    18,    18,
+       3,    26,    18,    18,    16,    17,    10,     7,    35,     7,
+      14,     7,     4,    25,    18,    15,    11,    15,    17,    15,
+      25,    18,    15,    18,    18,    19,    20,    21,    22,    23,
+      24,    16,    17,     4,    18,    18,    18,    16,    26,    16,
+      15,    15,    18,    16,     8,    15,    18,    15,    56,    18,
+      64,    -1,    -1,    20
 };
 
-  /* YYSTOS[STATE-NUM] -- The (internal number of the) accessing
-     symbol of state STATE-NUM.  */
-static const yytype_uint8 yystos[] =
+/* YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
+   state STATE-NUM.  */
+static const yytype_int8 yystos[] =
 {
-       0,    26,     0,     1,     3,     6,     9,    15,    27,    28,
-      29,    30,    15,    10,    14,    18,    33,    34,    18,    36,
-       4,     4,    36,    17,     5,    15,     7,    15,    31,    32,
-      34,     8,    11,    15,    19,    20,    21,    22,    23,    24,
-      37,    15,    32,    16,    17,    35
+       0,    28,     0,     1,     6,     9,    15,    18,    29,    30,
+      31,    34,    35,    36,    38,    15,    18,    45,     8,    45,
+       3,     4,    18,    45,    15,    10,    14,    18,    42,    43,
+      17,    45,     7,    15,    25,     4,    32,     7,    15,    18,
+      18,    45,     7,    15,    18,    16,    26,     5,    18,    37,
+       8,    18,    33,    16,    15,    18,    39,    40,    43,    16,
+      15,    18,     8,    15,    11,    37,    18,    19,    20,    21,
+      22,    23,    24,    46,    18,    40,    15,    16,    17,    25,
+      44,    44,    41,    44,    13,    26,    44
 };
 
-  /* YYR1[YYN] -- Symbol number of symbol that rule YYN derives.  */
-static const yytype_uint8 yyr1[] =
+/* YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.  */
+static const yytype_int8 yyr1[] =
 {
-       0,    25,    26,    26,    27,    27,    27,    27,    27,    28,
-      29,    29,    30,    30,    31,    31,    32,    33,    33,    33,
-      34,    35,    35,    36,    37,    37,    37,    37,    37,    37
+       0,    27,    28,    28,    29,    29,    29,    29,    29,    29,
+      29,    30,    31,    32,    32,    33,    33,    33,    33,    34,
+      34,    34,    34,    35,    36,    36,    37,    37,    38,    38,
+      39,    39,    40,    40,    40,    41,    41,    42,    42,    42,
+      42,    43,    44,    44,    45,    46,    46,    46,    46,    46,
+      46
 };
 
-  /* YYR2[YYN] -- Number of symbols on the right hand side of rule YYN.  */
-static const yytype_uint8 yyr2[] =
+/* YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.  */
+static const yytype_int8 yyr2[] =
 {
-       0,     2,     2,     0,     1,     1,     1,     2,     1,     1,
-       5,     7,     5,     7,     1,     3,     3,     1,     1,     1,
-       1,     1,     1,     1,     1,     1,     1,     1,     1,     1
+       0,     2,     2,     0,     1,     1,     1,     1,     1,     2,
+       1,     1,     6,     3,     0,     1,     2,     3,     2,     4,
+       7,     5,     8,     3,     7,     9,     2,     0,     1,     0,
+       1,     3,     3,     3,     5,     1,     3,     1,     1,     1,
+       4,     1,     1,     1,     1,     1,     1,     1,     1,     1,
+       1
 };
 
 
+enum { YYENOMEM = -2 };
+
 #define yyerrok         (yyerrstatus = 0)
 #define yyclearin       (yychar = YYEMPTY)
-#define YYEMPTY         (-2)
-#define YYEOF           0
 
 #define YYACCEPT        goto yyacceptlab
 #define YYABORT         goto yyabortlab
 #define YYERROR         goto yyerrorlab
+#define YYNOMEM         goto yyexhaustedlab
 
 
 #define YYRECOVERING()  (!!yyerrstatus)
 
-#define YYBACKUP(Token, Value)                                  \
-do                                                              \
-  if (yychar == YYEMPTY)                                        \
-    {                                                           \
-      yychar = (Token);                                         \
-      yylval = (Value);                                         \
-      YYPOPSTACK (yylen);                                       \
-      yystate = *yyssp;                                         \
-      goto yybackup;                                            \
-    }                                                           \
-  else                                                          \
-    {                                                           \
-      yyerror (YY_("syntax error: cannot back up")); \
-      YYERROR;                                                  \
-    }                                                           \
-while (0)
-
-/* Error token number */
-#define YYTERROR        1
-#define YYERRCODE       256
-
+#define YYBACKUP(Token, Value)                                    \
+  do                                                              \
+    if (yychar == YYEMPTY)                                        \
+      {                                                           \
+        yychar = (Token);                                         \
+        yylval = (Value);                                         \
+        YYPOPSTACK (yylen);                                       \
+        yystate = *yyssp;                                         \
+        goto yybackup;                                            \
+      }                                                           \
+    else                                                          \
+      {                                                           \
+        yyerror (YY_("syntax error: cannot back up")); \
+        YYERROR;                                                  \
+      }                                                           \
+  while (0)
+
+/* Backward compatibility with an undocumented macro.
+   Use YYerror or YYUNDEF. */
+#define YYERRCODE YYUNDEF
 
 
 /* Enable debugging if requested.  */
@@ -662,55 +777,52 @@ do {                                            \
     YYFPRINTF Args;                             \
 } while (0)
 
-/* This macro is provided for backward compatibility. */
-#ifndef YY_LOCATION_PRINT
-# define YY_LOCATION_PRINT(File, Loc) ((void) 0)
-#endif
 
 
-# define YY_SYMBOL_PRINT(Title, Type, Value, Location)                    \
+
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)                    \
 do {                                                                      \
   if (yydebug)                                                            \
     {                                                                     \
       YYFPRINTF (stderr, "%s ", Title);                                   \
       yy_symbol_print (stderr,                                            \
-                  Type, Value); \
+                  Kind, Value); \
       YYFPRINTF (stderr, "\n");                                           \
     }                                                                     \
 } while (0)
 
 
-/*----------------------------------------.
-| Print this symbol's value on YYOUTPUT.  |
-`----------------------------------------*/
+/*-----------------------------------.
+| Print this symbol's value on YYO.  |
+`-----------------------------------*/
 
 static void
-yy_symbol_value_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep)
+yy_symbol_value_print (FILE *yyo,
+                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep)
 {
-  FILE *yyo = yyoutput;
-  YYUSE (yyo);
+  FILE *yyoutput = yyo;
+  YY_USE (yyoutput);
   if (!yyvaluep)
     return;
-# ifdef YYPRINT
-  if (yytype < YYNTOKENS)
-    YYPRINT (yyoutput, yytoknum[yytype], *yyvaluep);
-# endif
-  YYUSE (yytype);
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  YY_USE (yykind);
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
 }
 
 
-/*--------------------------------.
-| Print this symbol on YYOUTPUT.  |
-`--------------------------------*/
+/*---------------------------.
+| Print this symbol on YYO.  |
+`---------------------------*/
 
 static void
-yy_symbol_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep)
+yy_symbol_print (FILE *yyo,
+                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep)
 {
-  YYFPRINTF (yyoutput, "%s %s (",
-             yytype < YYNTOKENS ? "token" : "nterm", yytname[yytype]);
+  YYFPRINTF (yyo, "%s %s (",
+             yykind < YYNTOKENS ? "token" : "nterm", yysymbol_name (yykind));
 
-  yy_symbol_value_print (yyoutput, yytype, yyvaluep);
-  YYFPRINTF (yyoutput, ")");
+  yy_symbol_value_print (yyo, yykind, yyvaluep);
+  YYFPRINTF (yyo, ")");
 }
 
 /*------------------------------------------------------------------.
@@ -719,7 +831,7 @@ yy_symbol_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep)
 `------------------------------------------------------------------*/
 
 static void
-yy_stack_print (yytype_int16 *yybottom, yytype_int16 *yytop)
+yy_stack_print (yy_state_t *yybottom, yy_state_t *yytop)
 {
   YYFPRINTF (stderr, "Stack now");
   for (; yybottom <= yytop; yybottom++)
@@ -742,21 +854,21 @@ do {                                                            \
 `------------------------------------------------*/
 
 static void
-yy_reduce_print (yytype_int16 *yyssp, YYSTYPE *yyvsp, int yyrule)
+yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
+                 int yyrule)
 {
-  unsigned long int yylno = yyrline[yyrule];
+  int yylno = yyrline[yyrule];
   int yynrhs = yyr2[yyrule];
   int yyi;
-  YYFPRINTF (stderr, "Reducing stack by rule %d (line %lu):\n",
+  YYFPRINTF (stderr, "Reducing stack by rule %d (line %d):\n",
              yyrule - 1, yylno);
   /* The symbols being reduced.  */
   for (yyi = 0; yyi < yynrhs; yyi++)
     {
       YYFPRINTF (stderr, "   $%d = ", yyi + 1);
       yy_symbol_print (stderr,
-                       yystos[yyssp[yyi + 1 - yynrhs]],
-                       &(yyvsp[(yyi + 1) - (yynrhs)])
-                                              );
+                       YY_ACCESSING_SYMBOL (+yyssp[yyi + 1 - yynrhs]),
+                       &yyvsp[(yyi + 1) - (yynrhs)]);
       YYFPRINTF (stderr, "\n");
     }
 }
@@ -771,8 +883,8 @@ do {                                    \
    multiple parsers can coexist.  */
 int yydebug;
 #else /* !YYDEBUG */
-# define YYDPRINTF(Args)
-# define YY_SYMBOL_PRINT(Title, Type, Value, Location)
+# define YYDPRINTF(Args) ((void) 0)
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)
 # define YY_STACK_PRINT(Bottom, Top)
 # define YY_REDUCE_PRINT(Rule)
 #endif /* !YYDEBUG */
@@ -795,249 +907,30 @@ int yydebug;
 #endif
 
 
-#if YYERROR_VERBOSE
-
-# ifndef yystrlen
-#  if defined __GLIBC__ && defined _STRING_H
-#   define yystrlen strlen
-#  else
-/* Return the length of YYSTR.  */
-static YYSIZE_T
-yystrlen (const char *yystr)
-{
-  YYSIZE_T yylen;
-  for (yylen = 0; yystr[yylen]; yylen++)
-    continue;
-  return yylen;
-}
-#  endif
-# endif
-
-# ifndef yystpcpy
-#  if defined __GLIBC__ && defined _STRING_H && defined _GNU_SOURCE
-#   define yystpcpy stpcpy
-#  else
-/* Copy YYSRC to YYDEST, returning the address of the terminating '\0' in
-   YYDEST.  */
-static char *
-yystpcpy (char *yydest, const char *yysrc)
-{
-  char *yyd = yydest;
-  const char *yys = yysrc;
-
-  while ((*yyd++ = *yys++) != '\0')
-    continue;
-
-  return yyd - 1;
-}
-#  endif
-# endif
 
-# ifndef yytnamerr
-/* Copy to YYRES the contents of YYSTR after stripping away unnecessary
-   quotes and backslashes, so that it's suitable for yyerror.  The
-   heuristic is that double-quoting is unnecessary unless the string
-   contains an apostrophe, a comma, or backslash (other than
-   backslash-backslash).  YYSTR is taken from yytname.  If YYRES is
-   null, do not copy; instead, return the length of what the result
-   would have been.  */
-static YYSIZE_T
-yytnamerr (char *yyres, const char *yystr)
-{
-  if (*yystr == '"')
-    {
-      YYSIZE_T yyn = 0;
-      char const *yyp = yystr;
-
-      for (;;)
-        switch (*++yyp)
-          {
-          case '\'':
-          case ',':
-            goto do_not_strip_quotes;
-
-          case '\\':
-            if (*++yyp != '\\')
-              goto do_not_strip_quotes;
-            /* Fall through.  */
-          default:
-            if (yyres)
-              yyres[yyn] = *yyp;
-            yyn++;
-            break;
-
-          case '"':
-            if (yyres)
-              yyres[yyn] = '\0';
-            return yyn;
-          }
-    do_not_strip_quotes: ;
-    }
 
-  if (! yyres)
-    return yystrlen (yystr);
 
-  return yystpcpy (yyres, yystr) - yyres;
-}
-# endif
-
-/* Copy into *YYMSG, which is of size *YYMSG_ALLOC, an error message
-   about the unexpected token YYTOKEN for the state stack whose top is
-   YYSSP.
-
-   Return 0 if *YYMSG was successfully written.  Return 1 if *YYMSG is
-   not large enough to hold the message.  In that case, also set
-   *YYMSG_ALLOC to the required number of bytes.  Return 2 if the
-   required number of bytes is too large to store.  */
-static int
-yysyntax_error (YYSIZE_T *yymsg_alloc, char **yymsg,
-                yytype_int16 *yyssp, int yytoken)
-{
-  YYSIZE_T yysize0 = yytnamerr (YY_NULLPTR, yytname[yytoken]);
-  YYSIZE_T yysize = yysize0;
-  enum { YYERROR_VERBOSE_ARGS_MAXIMUM = 5 };
-  /* Internationalized format string. */
-  const char *yyformat = YY_NULLPTR;
-  /* Arguments of yyformat. */
-  char const *yyarg[YYERROR_VERBOSE_ARGS_MAXIMUM];
-  /* Number of reported tokens (one for the "unexpected", one per
-     "expected"). */
-  int yycount = 0;
-
-  /* There are many possibilities here to consider:
-     - If this state is a consistent state with a default action, then
-       the only way this function was invoked is if the default action
-       is an error action.  In that case, don't check for expected
-       tokens because there are none.
-     - The only way there can be no lookahead present (in yychar) is if
-       this state is a consistent state with a default action.  Thus,
-       detecting the absence of a lookahead is sufficient to determine
-       that there is no unexpected or expected token to report.  In that
-       case, just report a simple "syntax error".
-     - Don't assume there isn't a lookahead just because this state is a
-       consistent state with a default action.  There might have been a
-       previous inconsistent state, consistent state with a non-default
-       action, or user semantic action that manipulated yychar.
-     - Of course, the expected token list depends on states to have
-       correct lookahead information, and it depends on the parser not
-       to perform extra reductions after fetching a lookahead from the
-       scanner and before detecting a syntax error.  Thus, state merging
-       (from LALR or IELR) and default reductions corrupt the expected
-       token list.  However, the list is correct for canonical LR with
-       one exception: it will still contain any token that will not be
-       accepted due to an error action in a later state.
-  */
-  if (yytoken != YYEMPTY)
-    {
-      int yyn = yypact[*yyssp];
-      yyarg[yycount++] = yytname[yytoken];
-      if (!yypact_value_is_default (yyn))
-        {
-          /* Start YYX at -YYN if negative to avoid negative indexes in
-             YYCHECK.  In other words, skip the first -YYN actions for
-             this state because they are default actions.  */
-          int yyxbegin = yyn < 0 ? -yyn : 0;
-          /* Stay within bounds of both yycheck and yytname.  */
-          int yychecklim = YYLAST - yyn + 1;
-          int yyxend = yychecklim < YYNTOKENS ? yychecklim : YYNTOKENS;
-          int yyx;
-
-          for (yyx = yyxbegin; yyx < yyxend; ++yyx)
-            if (yycheck[yyx + yyn] == yyx && yyx != YYTERROR
-                && !yytable_value_is_error (yytable[yyx + yyn]))
-              {
-                if (yycount == YYERROR_VERBOSE_ARGS_MAXIMUM)
-                  {
-                    yycount = 1;
-                    yysize = yysize0;
-                    break;
-                  }
-                yyarg[yycount++] = yytname[yyx];
-                {
-                  YYSIZE_T yysize1 = yysize + yytnamerr (YY_NULLPTR, yytname[yyx]);
-                  if (! (yysize <= yysize1
-                         && yysize1 <= YYSTACK_ALLOC_MAXIMUM))
-                    return 2;
-                  yysize = yysize1;
-                }
-              }
-        }
-    }
-
-  switch (yycount)
-    {
-# define YYCASE_(N, S)                      \
-      case N:                               \
-        yyformat = S;                       \
-      break
-      YYCASE_(0, YY_("syntax error"));
-      YYCASE_(1, YY_("syntax error, unexpected %s"));
-      YYCASE_(2, YY_("syntax error, unexpected %s, expecting %s"));
-      YYCASE_(3, YY_("syntax error, unexpected %s, expecting %s or %s"));
-      YYCASE_(4, YY_("syntax error, unexpected %s, expecting %s or %s or %s"));
-      YYCASE_(5, YY_("syntax error, unexpected %s, expecting %s or %s or %s or %s"));
-# undef YYCASE_
-    }
-
-  {
-    YYSIZE_T yysize1 = yysize + yystrlen (yyformat);
-    if (! (yysize <= yysize1 && yysize1 <= YYSTACK_ALLOC_MAXIMUM))
-      return 2;
-    yysize = yysize1;
-  }
-
-  if (*yymsg_alloc < yysize)
-    {
-      *yymsg_alloc = 2 * yysize;
-      if (! (yysize <= *yymsg_alloc
-             && *yymsg_alloc <= YYSTACK_ALLOC_MAXIMUM))
-        *yymsg_alloc = YYSTACK_ALLOC_MAXIMUM;
-      return 1;
-    }
-
-  /* Avoid sprintf, as that infringes on the user's name space.
-     Don't have undefined behavior even if the translation
-     produced a string with the wrong number of "%s"s.  */
-  {
-    char *yyp = *yymsg;
-    int yyi = 0;
-    while ((*yyp = *yyformat) != '\0')
-      if (*yyp == '%' && yyformat[1] == 's' && yyi < yycount)
-        {
-          yyp += yytnamerr (yyp, yyarg[yyi++]);
-          yyformat += 2;
-        }
-      else
-        {
-          yyp++;
-          yyformat++;
-        }
-  }
-  return 0;
-}
-#endif /* YYERROR_VERBOSE */
 
 /*-----------------------------------------------.
 | Release the memory associated to this symbol.  |
 `-----------------------------------------------*/
 
 static void
-yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep)
+yydestruct (const char *yymsg,
+            yysymbol_kind_t yykind, YYSTYPE *yyvaluep)
 {
-  YYUSE (yyvaluep);
+  YY_USE (yyvaluep);
   if (!yymsg)
     yymsg = "Deleting";
-  YY_SYMBOL_PRINT (yymsg, yytype, yyvaluep, yylocationp);
+  YY_SYMBOL_PRINT (yymsg, yykind, yyvaluep, yylocationp);
 
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
-  YYUSE (yytype);
+  YY_USE (yykind);
   YY_IGNORE_MAYBE_UNINITIALIZED_END
 }
 
 
-
-
-/* The lookahead symbol.  */
+/* Lookahead token kind.  */
 int yychar;
 
 /* The semantic value of the lookahead symbol.  */
@@ -1046,6 +939,8 @@ YYSTYPE yylval;
 int yynerrs;
 
 
+
+
 /*----------.
 | yyparse.  |
 `----------*/
@@ -1053,43 +948,36 @@ int yynerrs;
 int
 yyparse (void)
 {
-    int yystate;
+    yy_state_fast_t yystate = 0;
     /* Number of tokens to shift before error messages enabled.  */
-    int yyerrstatus;
-
-    /* The stacks and their tools:
-       'yyss': related to states.
-       'yyvs': related to semantic values.
+    int yyerrstatus = 0;
 
-       Refer to the stacks through separate pointers, to allow yyoverflow
+    /* Refer to the stacks through separate pointers, to allow yyoverflow
        to reallocate them elsewhere.  */
 
-    /* The state stack.  */
-    yytype_int16 yyssa[YYINITDEPTH];
-    yytype_int16 *yyss;
-    yytype_int16 *yyssp;
+    /* Their size.  */
+    YYPTRDIFF_T yystacksize = YYINITDEPTH;
 
-    /* The semantic value stack.  */
-    YYSTYPE yyvsa[YYINITDEPTH];
-    YYSTYPE *yyvs;
-    YYSTYPE *yyvsp;
+    /* The state stack: array, bottom, top.  */
+    yy_state_t yyssa[YYINITDEPTH];
+    yy_state_t *yyss = yyssa;
+    yy_state_t *yyssp = yyss;
 
-    YYSIZE_T yystacksize;
+    /* The semantic value stack: array, bottom, top.  */
+    YYSTYPE yyvsa[YYINITDEPTH];
+    YYSTYPE *yyvs = yyvsa;
+    YYSTYPE *yyvsp = yyvs;
 
   int yyn;
+  /* The return value of yyparse.  */
   int yyresult;
-  /* Lookahead token as an internal (translated) token number.  */
-  int yytoken = 0;
+  /* Lookahead symbol kind.  */
+  yysymbol_kind_t yytoken = YYSYMBOL_YYEMPTY;
   /* The variables used to return semantic value and location from the
      action routines.  */
   YYSTYPE yyval;
 
-#if YYERROR_VERBOSE
-  /* Buffer for error messages, and its allocated size.  */
-  char yymsgbuf[128];
-  char *yymsg = yymsgbuf;
-  YYSIZE_T yymsg_alloc = sizeof yymsgbuf;
-#endif
+
 
 #define YYPOPSTACK(N)   (yyvsp -= (N), yyssp -= (N))
 
@@ -1097,71 +985,75 @@ yyparse (void)
      Keep to zero when no symbol should be popped.  */
   int yylen = 0;
 
-  yyssp = yyss = yyssa;
-  yyvsp = yyvs = yyvsa;
-  yystacksize = YYINITDEPTH;
-
   YYDPRINTF ((stderr, "Starting parse\n"));
 
-  yystate = 0;
-  yyerrstatus = 0;
-  yynerrs = 0;
   yychar = YYEMPTY; /* Cause a token to be read.  */
+
   goto yysetstate;
 
+
 /*------------------------------------------------------------.
-| yynewstate -- Push a new state, which is found in yystate.  |
+| yynewstate -- push a new state, which is found in yystate.  |
 `------------------------------------------------------------*/
- yynewstate:
+yynewstate:
   /* In all cases, when you get here, the value and location stacks
      have just been pushed.  So pushing a state here evens the stacks.  */
   yyssp++;
 
- yysetstate:
-  *yyssp = yystate;
+
+/*--------------------------------------------------------------------.
+| yysetstate -- set current state (the top of the stack) to yystate.  |
+`--------------------------------------------------------------------*/
+yysetstate:
+  YYDPRINTF ((stderr, "Entering state %d\n", yystate));
+  YY_ASSERT (0 <= yystate && yystate < YYNSTATES);
+  YY_IGNORE_USELESS_CAST_BEGIN
+  *yyssp = YY_CAST (yy_state_t, yystate);
+  YY_IGNORE_USELESS_CAST_END
+  YY_STACK_PRINT (yyss, yyssp);
 
   if (yyss + yystacksize - 1 <= yyssp)
+#if !defined yyoverflow && !defined YYSTACK_RELOCATE
+    YYNOMEM;
+#else
     {
       /* Get the current used size of the three stacks, in elements.  */
-      YYSIZE_T yysize = yyssp - yyss + 1;
+      YYPTRDIFF_T yysize = yyssp - yyss + 1;
 
-#ifdef yyoverflow
+# if defined yyoverflow
       {
         /* Give user a chance to reallocate the stack.  Use copies of
            these so that the &'s don't force the real ones into
            memory.  */
+        yy_state_t *yyss1 = yyss;
         YYSTYPE *yyvs1 = yyvs;
-        yytype_int16 *yyss1 = yyss;
 
         /* Each stack pointer address is followed by the size of the
            data in use in that stack, in bytes.  This used to be a
            conditional around just the two extra args, but that might
            be undefined if yyoverflow is a macro.  */
         yyoverflow (YY_("memory exhausted"),
-                    &yyss1, yysize * sizeof (*yyssp),
-                    &yyvs1, yysize * sizeof (*yyvsp),
+                    &yyss1, yysize * YYSIZEOF (*yyssp),
+                    &yyvs1, yysize * YYSIZEOF (*yyvsp),
                     &yystacksize);
-
         yyss = yyss1;
         yyvs = yyvs1;
       }
-#else /* no yyoverflow */
-# ifndef YYSTACK_RELOCATE
-      goto yyexhaustedlab;
-# else
+# else /* defined YYSTACK_RELOCATE */
       /* Extend the stack our own way.  */
       if (YYMAXDEPTH <= yystacksize)
-        goto yyexhaustedlab;
+        YYNOMEM;
       yystacksize *= 2;
       if (YYMAXDEPTH < yystacksize)
         yystacksize = YYMAXDEPTH;
 
       {
-        yytype_int16 *yyss1 = yyss;
+        yy_state_t *yyss1 = yyss;
         union yyalloc *yyptr =
-          (union yyalloc *) YYSTACK_ALLOC (YYSTACK_BYTES (yystacksize));
+          YY_CAST (union yyalloc *,
+                   YYSTACK_ALLOC (YY_CAST (YYSIZE_T, YYSTACK_BYTES (yystacksize))));
         if (! yyptr)
-          goto yyexhaustedlab;
+          YYNOMEM;
         YYSTACK_RELOCATE (yyss_alloc, yyss);
         YYSTACK_RELOCATE (yyvs_alloc, yyvs);
 #  undef YYSTACK_RELOCATE
@@ -1169,30 +1061,31 @@ yyparse (void)
           YYSTACK_FREE (yyss1);
       }
 # endif
-#endif /* no yyoverflow */
 
       yyssp = yyss + yysize - 1;
       yyvsp = yyvs + yysize - 1;
 
-      YYDPRINTF ((stderr, "Stack size increased to %lu\n",
-                  (unsigned long int) yystacksize));
+      YY_IGNORE_USELESS_CAST_BEGIN
+      YYDPRINTF ((stderr, "Stack size increased to %ld\n",
+                  YY_CAST (long, yystacksize)));
+      YY_IGNORE_USELESS_CAST_END
 
       if (yyss + yystacksize - 1 <= yyssp)
         YYABORT;
     }
+#endif /* !defined yyoverflow && !defined YYSTACK_RELOCATE */
 
-  YYDPRINTF ((stderr, "Entering state %d\n", yystate));
 
   if (yystate == YYFINAL)
     YYACCEPT;
 
   goto yybackup;
 
+
 /*-----------.
 | yybackup.  |
 `-----------*/
 yybackup:
-
   /* Do appropriate processing given the current state.  Read a
      lookahead token if we need one and don't already have one.  */
 
@@ -1203,18 +1096,29 @@ yybackup:
 
   /* Not known => get a lookahead token if don't already have one.  */
 
-  /* YYCHAR is either YYEMPTY or YYEOF or a valid lookahead symbol.  */
+  /* YYCHAR is either empty, or end-of-input, or a valid lookahead.  */
   if (yychar == YYEMPTY)
     {
-      YYDPRINTF ((stderr, "Reading a token: "));
+      YYDPRINTF ((stderr, "Reading a token\n"));
       yychar = yylex ();
     }
 
   if (yychar <= YYEOF)
     {
-      yychar = yytoken = YYEOF;
+      yychar = YYEOF;
+      yytoken = YYSYMBOL_YYEOF;
       YYDPRINTF ((stderr, "Now at end of input.\n"));
     }
+  else if (yychar == YYerror)
+    {
+      /* The scanner already issued an error message, process directly
+         to error recovery.  But do not keep the error token as
+         lookahead, it is too special and may lead us to an endless
+         loop in error recovery. */
+      yychar = YYUNDEF;
+      yytoken = YYSYMBOL_YYerror;
+      goto yyerrlab1;
+    }
   else
     {
       yytoken = YYTRANSLATE (yychar);
@@ -1242,15 +1146,13 @@ yybackup:
 
   /* Shift the lookahead token.  */
   YY_SYMBOL_PRINT ("Shifting", yytoken, &yylval, &yylloc);
-
-  /* Discard the shifted token.  */
-  yychar = YYEMPTY;
-
   yystate = yyn;
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
   *++yyvsp = yylval;
   YY_IGNORE_MAYBE_UNINITIALIZED_END
 
+  /* Discard the shifted token.  */
+  yychar = YYEMPTY;
   goto yynewstate;
 
 
@@ -1265,7 +1167,7 @@ yydefault:
 
 
 /*-----------------------------.
-| yyreduce -- Do a reduction.  |
+| yyreduce -- do a reduction.  |
 `-----------------------------*/
 yyreduce:
   /* yyn is the number of a rule to reduce with.  */
@@ -1285,197 +1187,426 @@ yyreduce:
   YY_REDUCE_PRINT (yyn);
   switch (yyn)
     {
-        case 4:
-#line 57 "SqlParser.y" /* yacc.c:1646  */
-    { fprintf(stdout, "Bruinbase> "); }
-#line 1292 "SqlParser.tab.c" /* yacc.c:1646  */
+  case 4: /* command: load_command  */
+#line 61 "SqlParser.y"
+                     { fprintf(stdout, "Bruinbase> "); }
+#line 1194 "SqlParser.tab.c"
+    break;
+
+  case 5: /* command: select_command  */
+#line 62 "SqlParser.y"
+                         { fprintf(stdout, "Bruinbase> "); }
+#line 1200 "SqlParser.tab.c"
+    break;
+
+  case 6: /* command: index_command  */
+#line 63 "SqlParser.y"
+                        { fprintf(stdout, "Bruinbase> "); }
+#line 1206 "SqlParser.tab.c"
+    break;
+
+  case 7: /* command: analyze_command  */
+#line 64 "SqlParser.y"
+                          { fprintf(stdout, "Bruinbase> "); }
+#line 1212 "SqlParser.tab.c"
+    break;
+
+  case 9: /* command: error LF  */
+#line 66 "SqlParser.y"
+                   { fprintf(stdout, "Bruinbase> "); }
+#line 1218 "SqlParser.tab.c"
     break;
 
-  case 5:
-#line 58 "SqlParser.y" /* yacc.c:1646  */
-    { fprintf(stdout, "Bruinbase> "); }
-#line 1298 "SqlParser.tab.c" /* yacc.c:1646  */
+  case 10: /* command: LF  */
+#line 67 "SqlParser.y"
+             { fprintf(stdout, "Bruinbase> "); }
+#line 1224 "SqlParser.tab.c"
     break;
 
-  case 7:
-#line 60 "SqlParser.y" /* yacc.c:1646  */
-    { fprintf(stdout, "Bruinbase> "); }
-#line 1304 "SqlParser.tab.c" /* yacc.c:1646  */
+  case 11: /* quit_command: QUIT  */
+#line 71 "SqlParser.y"
+             { return 0; }
+#line 1230 "SqlParser.tab.c"
     break;
 
-  case 8:
-#line 61 "SqlParser.y" /* yacc.c:1646  */
-    { fprintf(stdout, "Bruinbase> "); }
-#line 1310 "SqlParser.tab.c" /* yacc.c:1646  */
+  case 12: /* load_command: LOAD table FROM STRING load_options LF  */
+#line 75 "SqlParser.y"
+                                               { 
+	  SqlEngine::load(std::string((yyvsp[-4].string)), std::string((yyvsp[-2].string)), (yyvsp[-1].integer)); 
+	  free((yyvsp[-4].string));
+	  free((yyvsp[-2].string));
+	}
+#line 1240 "SqlParser.tab.c"
     break;
 
-  case 9:
-#line 65 "SqlParser.y" /* yacc.c:1646  */
-    { return 0; }
-#line 1316 "SqlParser.tab.c" /* yacc.c:1646  */
+  case 13: /* load_options: load_options WITH index_option  */
+#line 83 "SqlParser.y"
+                                       { (yyval.integer) = (yyvsp[-2].integer) | (yyvsp[0].integer); }
+#line 1246 "SqlParser.tab.c"
     break;
 
-  case 10:
-#line 69 "SqlParser.y" /* yacc.c:1646  */
-    { 
-	  SqlEngine::load(std::string((yyvsp[-3].string)), std::string((yyvsp[-1].string)), false); 
+  case 14: /* load_options: %empty  */
+#line 84 "SqlParser.y"
+          { (yyval.integer) = 0; }
+#line 1252 "SqlParser.tab.c"
+    break;
+
+  case 15: /* index_option: INDEX  */
+#line 88 "SqlParser.y"
+              { (yyval.integer) = SqlEngine::KEY_INDEX; }
+#line 1258 "SqlParser.tab.c"
+    break;
+
+  case 16: /* index_option: INDEX ID  */
+#line 89 "SqlParser.y"
+                   { 
+	  if (strcasecmp((yyvsp[0].string), "compressed") == 0)
+	    (yyval.integer) = SqlEngine::KEY_INDEX | SqlEngine::COMPRESSED_INDEX; 
+	  else (yyval.integer) = -1;
+	  free((yyvsp[0].string));
+	  if ((yyval.integer) < 0) { sqlerror("wrong index option. expected COMPRESSED"); YYERROR; }
+	}
+#line 1270 "SqlParser.tab.c"
+    break;
+
+  case 17: /* index_option: INDEX ID ID  */
+#line 96 "SqlParser.y"
+                      { 
+	  if (strcasecmp((yyvsp[-1].string), "include") == 0 && strcasecmp((yyvsp[0].string), "value") == 0)
+	    (yyval.integer) = SqlEngine::KEY_INDEX | SqlEngine::COVERING_INDEX; 
+	  else (yyval.integer) = -1;
+	  free((yyvsp[-1].string));
+	  free((yyvsp[0].string));
+	  if ((yyval.integer) < 0) { sqlerror("wrong index option. expected INCLUDE value"); YYERROR; }
+	}
+#line 1283 "SqlParser.tab.c"
+    break;
+
+  case 18: /* index_option: ID INDEX  */
+#line 104 "SqlParser.y"
+                   { 
+	  if (strcasecmp((yyvsp[-1].string), "value") == 0) (yyval.integer) = SqlEngine::VALUE_INDEX;
+	  else if (strcasecmp((yyvsp[-1].string), "hash") == 0) (yyval.integer) = SqlEngine::HASH_INDEX;
+	  else if (strcasecmp((yyvsp[-1].string), "lsm") == 0) (yyval.integer) = SqlEngine::LSM_INDEX;
+	  else if (strcasecmp((yyvsp[-1].string), "learned") == 0) (yyval.integer) = SqlEngine::LEARNED_INDEX;
+	  else (yyval.integer) = -1;
+	  free((yyvsp[-1].string));
+	  if ((yyval.integer) < 0) { sqlerror("wrong index type. expected VALUE INDEX, HASH INDEX, LSM INDEX or LEARNED INDEX"); YYERROR; }
+	}
+#line 1297 "SqlParser.tab.c"
+    break;
+
+  case 19: /* index_command: ID INDEX table LF  */
+#line 116 "SqlParser.y"
+                          {
+	  if (strcasecmp((yyvsp[-3].string), "rebuild") == 0) SqlEngine::rebuildIndex(std::string((yyvsp[-1].string)), SqlEngine::INDEX_FILL_FACTOR);
+	  else sqlerror("wrong command. expected REBUILD INDEX");
 	  free((yyvsp[-3].string));
 	  free((yyvsp[-1].string));
 	}
-#line 1326 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1308 "SqlParser.tab.c"
     break;
 
-  case 11:
-#line 74 "SqlParser.y" /* yacc.c:1646  */
-    { 
-	  SqlEngine::load(std::string((yyvsp[-5].string)), std::string((yyvsp[-3].string)), true); 
+  case 20: /* index_command: ID INDEX table WITH ID INTEGER LF  */
+#line 122 "SqlParser.y"
+                                            {
+	  if (strcasecmp((yyvsp[-6].string), "rebuild") != 0) sqlerror("wrong command. expected REBUILD INDEX");
+	  else if (strcasecmp((yyvsp[-2].string), "fillfactor") != 0) sqlerror("wrong rebuild option. expected FILLFACTOR");
+	  else SqlEngine::rebuildIndex(std::string((yyvsp[-4].string)), atoi((yyvsp[-1].string)));
+	  free((yyvsp[-6].string));
+	  free((yyvsp[-4].string));
+	  free((yyvsp[-2].string));
+	  free((yyvsp[-1].string));
+	}
+#line 1322 "SqlParser.tab.c"
+    break;
+
+  case 21: /* index_command: ID INDEX ID table LF  */
+#line 131 "SqlParser.y"
+                               {
+	  if (strcasecmp((yyvsp[-4].string), "create") == 0 && strcasecmp((yyvsp[-2].string), "on") == 0) SqlEngine::createIndex(std::string((yyvsp[-1].string)), SqlEngine::SORT_MEMORY_BUDGET);
+	  else sqlerror("wrong command. expected CREATE INDEX ON");
+	  free((yyvsp[-4].string));
+	  free((yyvsp[-2].string));
+	  free((yyvsp[-1].string));
+	}
+#line 1334 "SqlParser.tab.c"
+    break;
+
+  case 22: /* index_command: ID INDEX ID table WITH ID INTEGER LF  */
+#line 138 "SqlParser.y"
+                                               {
+	  if (strcasecmp((yyvsp[-7].string), "create") != 0 || strcasecmp((yyvsp[-5].string), "on") != 0) sqlerror("wrong command. expected CREATE INDEX ON");
+	  else if (strcasecmp((yyvsp[-2].string), "memory") != 0) sqlerror("wrong index option. expected MEMORY (in KB)");
+	  else SqlEngine::createIndex(std::string((yyvsp[-4].string)), atol((yyvsp[-1].string)) << 10);
+	  free((yyvsp[-7].string));
 	  free((yyvsp[-5].string));
-	  free((yyvsp[-3].string));
+	  free((yyvsp[-4].string));
+	  free((yyvsp[-2].string));
+	  free((yyvsp[-1].string));
 	}
-#line 1336 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1349 "SqlParser.tab.c"
     break;
 
-  case 12:
-#line 82 "SqlParser.y" /* yacc.c:1646  */
-    {
+  case 23: /* analyze_command: ID table LF  */
+#line 151 "SqlParser.y"
+                    {
+	  if (strcasecmp((yyvsp[-2].string), "analyze") == 0) SqlEngine::analyze(std::string((yyvsp[-1].string)));
+	  else sqlerror("wrong command. expected ANALYZE");
+	  free((yyvsp[-2].string));
+	  free((yyvsp[-1].string));
+	}
+#line 1360 "SqlParser.tab.c"
+    break;
+
+  case 24: /* select_command: explain_option SELECT attributes FROM table limit_option LF  */
+#line 160 "SqlParser.y"
+                                                                    {
    	        std::vector<SelCond> conds;
-		runSelect((yyvsp[-3].integer), (yyvsp[-1].string), conds);
-		free((yyvsp[-1].string));
+		runSelect((yyvsp[-4].integer), (yyvsp[-2].string), conds, (yyvsp[-1].integer), (yyvsp[-6].integer));
+		free((yyvsp[-2].string));
 	}
-#line 1346 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1370 "SqlParser.tab.c"
     break;
 
-  case 13:
-#line 87 "SqlParser.y" /* yacc.c:1646  */
-    {
-	        runSelect((yyvsp[-5].integer), (yyvsp[-3].string), *(yyvsp[-1].conds));
-	  	free((yyvsp[-3].string));
-	  	for (unsigned i = 0; i < (yyvsp[-1].conds)->size(); i++) {
-		    free((*(yyvsp[-1].conds))[i].value);
+  case 25: /* select_command: explain_option SELECT attributes FROM table WHERE conditions limit_option LF  */
+#line 165 "SqlParser.y"
+                                                                                       {
+	        runSelect((yyvsp[-6].integer), (yyvsp[-4].string), *(yyvsp[-2].conds), (yyvsp[-1].integer), (yyvsp[-8].integer));
+	  	free((yyvsp[-4].string));
+	  	for (unsigned i = 0; i < (yyvsp[-2].conds)->size(); i++) {
+		    free((*(yyvsp[-2].conds))[i].value);
+		    for (unsigned j = 0; j < (*(yyvsp[-2].conds))[i].values.size(); j++) free((*(yyvsp[-2].conds))[i].values[j]);
 		}
-	  	delete (yyvsp[-1].conds);
+	  	delete (yyvsp[-2].conds);
 	}
-#line 1359 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1384 "SqlParser.tab.c"
     break;
 
-  case 14:
-#line 98 "SqlParser.y" /* yacc.c:1646  */
-    {
+  case 26: /* limit_option: ID INTEGER  */
+#line 177 "SqlParser.y"
+                   {
+	  bool limit = (strcasecmp((yyvsp[-1].string), "limit") == 0);
+	  (yyval.integer) = atoi((yyvsp[0].string));
+	  free((yyvsp[-1].string));
+	  free((yyvsp[0].string));
+	  if (!limit) { sqlerror("wrong select option. expected LIMIT"); YYERROR; }
+	}
+#line 1396 "SqlParser.tab.c"
+    break;
+
+  case 27: /* limit_option: %empty  */
+#line 184 "SqlParser.y"
+          { (yyval.integer) = -1; }
+#line 1402 "SqlParser.tab.c"
+    break;
+
+  case 28: /* explain_option: ID  */
+#line 188 "SqlParser.y"
+           {
+	  (yyval.integer) = (strcasecmp((yyvsp[0].string), "explain") == 0);
+	  free((yyvsp[0].string));
+	  if (!(yyval.integer)) { sqlerror("wrong command. expected EXPLAIN SELECT"); YYERROR; }
+	}
+#line 1412 "SqlParser.tab.c"
+    break;
+
+  case 29: /* explain_option: %empty  */
+#line 193 "SqlParser.y"
+          { (yyval.integer) = 0; }
+#line 1418 "SqlParser.tab.c"
+    break;
+
+  case 30: /* conditions: condition  */
+#line 197 "SqlParser.y"
+                  {
 	  std::vector<SelCond>* v = new std::vector<SelCond>;
 	  v->push_back(*(yyvsp[0].cond));
 	  (yyval.conds) = v;
           delete (yyvsp[0].cond);
 	}
-#line 1370 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1429 "SqlParser.tab.c"
     break;
 
-  case 15:
-#line 104 "SqlParser.y" /* yacc.c:1646  */
-    {
+  case 31: /* conditions: conditions AND condition  */
+#line 203 "SqlParser.y"
+                                   {
 	  (yyvsp[-2].conds)->push_back(*(yyvsp[0].cond));
 	  (yyval.conds) = (yyvsp[-2].conds);
           delete (yyvsp[0].cond);
 	}
-#line 1380 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1439 "SqlParser.tab.c"
     break;
 
-  case 16:
-#line 112 "SqlParser.y" /* yacc.c:1646  */
-    { 
+  case 32: /* condition: attribute comparator value  */
+#line 211 "SqlParser.y"
+                                   { 
 	  SelCond* c = new SelCond;
 	  c->attr = (yyvsp[-2].integer);
 	  c->comp = static_cast<SelCond::Comparator>((yyvsp[-1].integer));
 	  c->value = (yyvsp[0].string);
 	  (yyval.cond) = c;
         }
-#line 1392 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1451 "SqlParser.tab.c"
+    break;
+
+  case 33: /* condition: attribute ID value  */
+#line 218 "SqlParser.y"
+                             { 
+	  if (strcasecmp((yyvsp[-1].string), "like") != 0) {
+	    sqlerror("wrong comparator. neither an operator or LIKE");
+	    free((yyvsp[-1].string));
+	    free((yyvsp[0].string));
+	    YYERROR;
+	  }
+	  SelCond* c = new SelCond;
+	  c->attr = (yyvsp[-2].integer);
+	  c->comp = SelCond::LIKE;
+	  c->value = (yyvsp[0].string);
+	  free((yyvsp[-1].string));
+	  (yyval.cond) = c;
+        }
+#line 1470 "SqlParser.tab.c"
+    break;
+
+  case 34: /* condition: attribute ID '(' value_list ')'  */
+#line 232 "SqlParser.y"
+                                          { 
+	  if (strcasecmp((yyvsp[-3].string), "in") != 0) {
+	    sqlerror("wrong comparator. expected IN");
+	    free((yyvsp[-3].string));
+	    for (unsigned i = 0; i < (yyvsp[-1].strings)->size(); i++) free((*(yyvsp[-1].strings))[i]);
+	    delete (yyvsp[-1].strings);
+	    YYERROR;
+	  }
+	  SelCond* c = new SelCond;
+	  c->attr = (yyvsp[-4].integer);
+	  c->comp = SelCond::IN;
+	  c->value = NULL;
+	  c->values = *(yyvsp[-1].strings);
+	  free((yyvsp[-3].string));
+	  delete (yyvsp[-1].strings);
+	  (yyval.cond) = c;
+        }
+#line 1492 "SqlParser.tab.c"
     break;
 
-  case 17:
-#line 122 "SqlParser.y" /* yacc.c:1646  */
-    { (yyval.integer) = (yyvsp[0].integer); }
-#line 1398 "SqlParser.tab.c" /* yacc.c:1646  */
+  case 35: /* value_list: value  */
+#line 252 "SqlParser.y"
+              { 
+	  (yyval.strings) = new std::vector<char*>;
+	  (yyval.strings)->push_back((yyvsp[0].string));
+	}
+#line 1501 "SqlParser.tab.c"
+    break;
+
+  case 36: /* value_list: value_list COMMA value  */
+#line 256 "SqlParser.y"
+                                 {
+	  (yyvsp[-2].strings)->push_back((yyvsp[0].string));
+	  (yyval.strings) = (yyvsp[-2].strings);
+	}
+#line 1510 "SqlParser.tab.c"
     break;
 
-  case 18:
-#line 123 "SqlParser.y" /* yacc.c:1646  */
-    { (yyval.integer) = 3; }
-#line 1404 "SqlParser.tab.c" /* yacc.c:1646  */
+  case 37: /* attributes: attribute  */
+#line 263 "SqlParser.y"
+                  { (yyval.integer) = (yyvsp[0].integer); }
+#line 1516 "SqlParser.tab.c"
     break;
 
-  case 19:
-#line 124 "SqlParser.y" /* yacc.c:1646  */
-    { (yyval.integer) = 4; }
-#line 1410 "SqlParser.tab.c" /* yacc.c:1646  */
+  case 38: /* attributes: STAR  */
+#line 264 "SqlParser.y"
+                { (yyval.integer) = 3; }
+#line 1522 "SqlParser.tab.c"
     break;
 
-  case 20:
-#line 128 "SqlParser.y" /* yacc.c:1646  */
-    { 
+  case 39: /* attributes: COUNT  */
+#line 265 "SqlParser.y"
+                { (yyval.integer) = 4; }
+#line 1528 "SqlParser.tab.c"
+    break;
+
+  case 40: /* attributes: ID '(' ID ')'  */
+#line 266 "SqlParser.y"
+                        {
+	  if (strcasecmp((yyvsp[-3].string), "max") == 0 && strcasecmp((yyvsp[-1].string), "key") == 0) (yyval.integer) = 5;
+	  else (yyval.integer) = -1;
+	  free((yyvsp[-3].string));
+	  free((yyvsp[-1].string));
+	  if ((yyval.integer) < 0) { sqlerror("wrong aggregate. expected MAX(key)"); YYERROR; }
+	}
+#line 1540 "SqlParser.tab.c"
+    break;
+
+  case 41: /* attribute: ID  */
+#line 276 "SqlParser.y"
+           { 
 		if (strcasecmp((yyvsp[0].string), "key") == 0) (yyval.integer)=1;
 		else if (strcasecmp((yyvsp[0].string), "value") == 0) (yyval.integer)=2;
 		else sqlerror("wrong attribute name. neither key or value");
 		free((yyvsp[0].string));
 	}
-#line 1421 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1551 "SqlParser.tab.c"
     break;
 
-  case 21:
-#line 136 "SqlParser.y" /* yacc.c:1646  */
-    { (yyval.string) = (yyvsp[0].string); }
-#line 1427 "SqlParser.tab.c" /* yacc.c:1646  */
+  case 42: /* value: INTEGER  */
+#line 284 "SqlParser.y"
+                 { (yyval.string) = (yyvsp[0].string); }
+#line 1557 "SqlParser.tab.c"
     break;
 
-  case 22:
-#line 137 "SqlParser.y" /* yacc.c:1646  */
-    { (yyval.string) = (yyvsp[0].string); }
-#line 1433 "SqlParser.tab.c" /* yacc.c:1646  */
+  case 43: /* value: STRING  */
+#line 285 "SqlParser.y"
+                 { (yyval.string) = (yyvsp[0].string); }
+#line 1563 "SqlParser.tab.c"
     break;
 
-  case 23:
-#line 141 "SqlParser.y" /* yacc.c:1646  */
-    { (yyval.string) = (yyvsp[0].string); }
-#line 1439 "SqlParser.tab.c" /* yacc.c:1646  */
+  case 44: /* table: ID  */
+#line 289 "SqlParser.y"
+           { (yyval.string) = (yyvsp[0].string); }
+#line 1569 "SqlParser.tab.c"
     break;
 
-  case 24:
-#line 145 "SqlParser.y" /* yacc.c:1646  */
-    { (yyval.integer) = SelCond::EQ; }
-#line 1445 "SqlParser.tab.c" /* yacc.c:1646  */
+  case 45: /* comparator: EQUAL  */
+#line 293 "SqlParser.y"
+                       { (yyval.integer) = SelCond::EQ; }
+#line 1575 "SqlParser.tab.c"
     break;
 
-  case 25:
-#line 146 "SqlParser.y" /* yacc.c:1646  */
-    { (yyval.integer) = SelCond::NE; }
-#line 1451 "SqlParser.tab.c" /* yacc.c:1646  */
+  case 46: /* comparator: NEQUAL  */
+#line 294 "SqlParser.y"
+                       { (yyval.integer) = SelCond::NE; }
+#line 1581 "SqlParser.tab.c"
     break;
 
-  case 26:
-#line 147 "SqlParser.y" /* yacc.c:1646  */
-    { (yyval.integer) = SelCond::LT; }
-#line 1457 "SqlParser.tab.c" /* yacc.c:1646  */
+  case 47: /* comparator: LESS  */
+#line 295 "SqlParser.y"
+                       { (yyval.integer) = SelCond::LT; }
+#line 1587 "SqlParser.tab.c"
     break;
 
-  case 27:
-#line 148 "SqlParser.y" /* yacc.c:1646  */
-    { (yyval.integer) = SelCond::GT; }
-#line 1463 "SqlParser.tab.c" /* yacc.c:1646  */
+  case 48: /* comparator: GREATER  */
+#line 296 "SqlParser.y"
+                       { (yyval.integer) = SelCond::GT; }
+#line 1593 "SqlParser.tab.c"
     break;
 
-  case 28:
-#line 149 "SqlParser.y" /* yacc.c:1646  */
-    { (yyval.integer) = SelCond::LE; }
-#line 1469 "SqlParser.tab.c" /* yacc.c:1646  */
+  case 49: /* comparator: LESSEQUAL  */
+#line 297 "SqlParser.y"
+                       { (yyval.integer) = SelCond::LE; }
+#line 1599 "SqlParser.tab.c"
     break;
 
-  case 29:
-#line 150 "SqlParser.y" /* yacc.c:1646  */
-    { (yyval.integer) = SelCond::GE; }
-#line 1475 "SqlParser.tab.c" /* yacc.c:1646  */
+  case 50: /* comparator: GREATEREQUAL  */
+#line 298 "SqlParser.y"
+                       { (yyval.integer) = SelCond::GE; }
+#line 1605 "SqlParser.tab.c"
     break;
 
 
-#line 1479 "SqlParser.tab.c" /* yacc.c:1646  */
+#line 1609 "SqlParser.tab.c"
+
       default: break;
     }
   /* User semantic actions sometimes alter yychar, and that requires
@@ -1489,25 +1620,23 @@ yyreduce:
      case of YYERROR or YYBACKUP, subsequent parser actions might lead
      to an incorrect destructor call or verbose syntax error message
      before the lookahead is translated.  */
-  YY_SYMBOL_PRINT ("-> $$ =", yyr1[yyn], &yyval, &yyloc);
+  YY_SYMBOL_PRINT ("-> $$ =", YY_CAST (yysymbol_kind_t, yyr1[yyn]), &yyval, &yyloc);
 
   YYPOPSTACK (yylen);
   yylen = 0;
-  YY_STACK_PRINT (yyss, yyssp);
 
   *++yyvsp = yyval;
 
   /* Now 'shift' the result of the reduction.  Determine what state
      that goes to, based on the state we popped back to and the rule
      number reduced by.  */
-
-  yyn = yyr1[yyn];
-
-  yystate = yypgoto[yyn - YYNTOKENS] + *yyssp;
-  if (0 <= yystate && yystate <= YYLAST && yycheck[yystate] == *yyssp)
-    yystate = yytable[yystate];
-  else
-    yystate = yydefgoto[yyn - YYNTOKENS];
+  {
+    const int yylhs = yyr1[yyn] - YYNTOKENS;
+    const int yyi = yypgoto[yylhs] + *yyssp;
+    yystate = (0 <= yyi && yyi <= YYLAST && yycheck[yyi] == *yyssp
+               ? yytable[yyi]
+               : yydefgoto[yylhs]);
+  }
 
   goto yynewstate;
 
@@ -1518,50 +1647,14 @@ yyreduce:
 yyerrlab:
   /* Make sure we have latest lookahead translation.  See comments at
      user semantic actions for why this is necessary.  */
-  yytoken = yychar == YYEMPTY ? YYEMPTY : YYTRANSLATE (yychar);
-
+  yytoken = yychar == YYEMPTY ? YYSYMBOL_YYEMPTY : YYTRANSLATE (yychar);
   /* If not already recovering from an error, report this error.  */
   if (!yyerrstatus)
     {
       ++yynerrs;
-#if ! YYERROR_VERBOSE
       yyerror (YY_("syntax error"));
-#else
-# define YYSYNTAX_ERROR yysyntax_error (&yymsg_alloc, &yymsg, \
-                                        yyssp, yytoken)
-      {
-        char const *yymsgp = YY_("syntax error");
-        int yysyntax_error_status;
-        yysyntax_error_status = YYSYNTAX_ERROR;
-        if (yysyntax_error_status == 0)
-          yymsgp = yymsg;
-        else if (yysyntax_error_status == 1)
-          {
-            if (yymsg != yymsgbuf)
-              YYSTACK_FREE (yymsg);
-            yymsg = (char *) YYSTACK_ALLOC (yymsg_alloc);
-            if (!yymsg)
-              {
-                yymsg = yymsgbuf;
-                yymsg_alloc = sizeof yymsgbuf;
-                yysyntax_error_status = 2;
-              }
-            else
-              {
-                yysyntax_error_status = YYSYNTAX_ERROR;
-                yymsgp = yymsg;
-              }
-          }
-        yyerror (yymsgp);
-        if (yysyntax_error_status == 2)
-          goto yyexhaustedlab;
-      }
-# undef YYSYNTAX_ERROR
-#endif
     }
 
-
-
   if (yyerrstatus == 3)
     {
       /* If just tried and failed to reuse lookahead token after an
@@ -1590,12 +1683,11 @@ yyerrlab:
 | yyerrorlab -- error raised explicitly by YYERROR.  |
 `---------------------------------------------------*/
 yyerrorlab:
-
-  /* Pacify compilers like GCC when the user code never invokes
-     YYERROR and the label yyerrorlab therefore never appears in user
-     code.  */
-  if (/*CONSTCOND*/ 0)
-     goto yyerrorlab;
+  /* Pacify compilers when the user code never invokes YYERROR and the
+     label yyerrorlab therefore never appears in user code.  */
+  if (0)
+    YYERROR;
+  ++yynerrs;
 
   /* Do not reclaim the symbols of the rule whose action triggered
      this YYERROR.  */
@@ -1612,13 +1704,14 @@ yyerrorlab:
 yyerrlab1:
   yyerrstatus = 3;      /* Each real token shifted decrements this.  */
 
+  /* Pop stack until we find a state that shifts the error token.  */
   for (;;)
     {
       yyn = yypact[yystate];
       if (!yypact_value_is_default (yyn))
         {
-          yyn += YYTERROR;
-          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYTERROR)
+          yyn += YYSYMBOL_YYerror;
+          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYSYMBOL_YYerror)
             {
               yyn = yytable[yyn];
               if (0 < yyn)
@@ -1632,7 +1725,7 @@ yyerrlab1:
 
 
       yydestruct ("Error: popping",
-                  yystos[yystate], yyvsp);
+                  YY_ACCESSING_SYMBOL (yystate), yyvsp);
       YYPOPSTACK (1);
       yystate = *yyssp;
       YY_STACK_PRINT (yyss, yyssp);
@@ -1644,7 +1737,7 @@ yyerrlab1:
 
 
   /* Shift the error token.  */
-  YY_SYMBOL_PRINT ("Shifting", yystos[yyn], yyvsp, yylsp);
+  YY_SYMBOL_PRINT ("Shifting", YY_ACCESSING_SYMBOL (yyn), yyvsp, yylsp);
 
   yystate = yyn;
   goto yynewstate;
@@ -1655,26 +1748,30 @@ yyerrlab1:
 `-------------------------------------*/
 yyacceptlab:
   yyresult = 0;
-  goto yyreturn;
+  goto yyreturnlab;
+
 
 /*-----------------------------------.
 | yyabortlab -- YYABORT comes here.  |
 `-----------------------------------*/
 yyabortlab:
   yyresult = 1;
-  goto yyreturn;
+  goto yyreturnlab;
+
 
-#if !defined yyoverflow || YYERROR_VERBOSE
-/*-------------------------------------------------.
-| yyexhaustedlab -- memory exhaustion comes here.  |
-`-------------------------------------------------*/
+/*-----------------------------------------------------------.
+| yyexhaustedlab -- YYNOMEM (memory exhaustion) comes here.  |
+`-----------------------------------------------------------*/
 yyexhaustedlab:
   yyerror (YY_("memory exhausted"));
   yyresult = 2;
-  /* Fall through.  */
-#endif
+  goto yyreturnlab;
+
 
-yyreturn:
+/*----------------------------------------------------------.
+| yyreturnlab -- parsing is finished, clean up and return.  |
+`----------------------------------------------------------*/
+yyreturnlab:
   if (yychar != YYEMPTY)
     {
       /* Make sure we have latest lookahead translation.  See comments at
@@ -1690,16 +1787,14 @@ yyreturn:
   while (yyssp != yyss)
     {
       yydestruct ("Cleanup: popping",
-                  yystos[*yyssp], yyvsp);
+                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp);
       YYPOPSTACK (1);
     }
 #ifndef yyoverflow
   if (yyss != yyssa)
     YYSTACK_FREE (yyss);
 #endif
-#if YYERROR_VERBOSE
-  if (yymsg != yymsgbuf)
-    YYSTACK_FREE (yymsg);
-#endif
+
   return yyresult;
 }
+
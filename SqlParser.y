@@ -1,6 +1,7 @@
 %{
 #include <cstdio>
 #include <cstring>
+#include <cstdlib>
 #include <sys/times.h>
 #include <unistd.h>
 #include <climits>
@@ -13,7 +14,7 @@ int  sqllex(void);
 void sqlerror(const char *str) { fprintf(stderr, "Error: %s\n", str); }
 extern "C" { int  sqlwrap() { return 1; } }
 
-static void runSelect(int attr, const char* table, const std::vector<SelCond>& conds)
+static void runSelect(int attr, const char* table, const std::vector<SelCond>& conds, int limit, bool explain)
 {
   struct tms tmsbuf;
   clock_t btime, etime;
@@ -21,7 +22,8 @@ static void runSelect(int attr, const char* table, const std::vector<SelCond>& c
 
   btime = times(&tmsbuf);
   bpagecnt = PageFile::getPageReadCount();
-  SqlEngine::select(attr, table, conds);
+  if (explain) SqlEngine::explain(attr, table, conds, limit);
+  else SqlEngine::select(attr, table, conds, limit);
   etime = times(&tmsbuf);
   epagecnt = PageFile::getPageReadCount();
 
@@ -35,6 +37,7 @@ static void runSelect(int attr, const char* table, const std::vector<SelCond>& c
   char* string;
   SelCond* cond;
   std::vector<SelCond>* conds;
+  std::vector<char*>* strings;
 }
 
 %token SELECT FROM WHERE LOAD WITH INDEX QUIT COUNT AND OR 
@@ -42,10 +45,11 @@ static void runSelect(int attr, const char* table, const std::vector<SelCond>& c
 %token <string> INTEGER STRING ID
 %token EQUAL NEQUAL LESS LESSEQUAL GREATER GREATEREQUAL 
 
-%type <integer> attributes attribute comparator
+%type <integer> attributes attribute comparator load_options index_option explain_option limit_option
 %type <string> table value
 %type <cond> condition
 %type <conds> conditions
+%type <strings> value_list
 %%
 
 commands:
@@ -56,6 +60,8 @@ commands:
 command:
         load_command { fprintf(stdout, "Bruinbase> "); }
 	| select_command { fprintf(stdout, "Bruinbase> "); }
+	| index_command { fprintf(stdout, "Bruinbase> "); }
+	| analyze_command { fprintf(stdout, "Bruinbase> "); }
 	| quit_command
 	| error LF { fprintf(stdout, "Bruinbase> "); }
 	| LF { fprintf(stdout, "Bruinbase> "); }
@@ -66,34 +72,127 @@ quit_command:
 	;
 
 load_command:
-	LOAD table FROM STRING LF { 
-	  SqlEngine::load(std::string($2), std::string($4), false); 
+	LOAD table FROM STRING load_options LF { 
+	  SqlEngine::load(std::string($2), std::string($4), $5); 
 	  free($2);
 	  free($4);
 	}
-	| LOAD table FROM STRING WITH INDEX LF { 
-	  SqlEngine::load(std::string($2), std::string($4), true); 
+	;
+
+load_options:
+	load_options WITH index_option { $$ = $1 | $3; }
+	| { $$ = 0; }
+	;
+
+index_option:
+	INDEX { $$ = SqlEngine::KEY_INDEX; }
+	| INDEX ID { 
+	  if (strcasecmp($2, "compressed") == 0)
+	    $$ = SqlEngine::KEY_INDEX | SqlEngine::COMPRESSED_INDEX; 
+	  else $$ = -1;
+	  free($2);
+	  if ($$ < 0) { sqlerror("wrong index option. expected COMPRESSED"); YYERROR; }
+	}
+	| INDEX ID ID { 
+	  if (strcasecmp($2, "include") == 0 && strcasecmp($3, "value") == 0)
+	    $$ = SqlEngine::KEY_INDEX | SqlEngine::COVERING_INDEX; 
+	  else $$ = -1;
 	  free($2);
+	  free($3);
+	  if ($$ < 0) { sqlerror("wrong index option. expected INCLUDE value"); YYERROR; }
+	}
+	| ID INDEX { 
+	  if (strcasecmp($1, "value") == 0) $$ = SqlEngine::VALUE_INDEX;
+	  else if (strcasecmp($1, "hash") == 0) $$ = SqlEngine::HASH_INDEX;
+	  else if (strcasecmp($1, "lsm") == 0) $$ = SqlEngine::LSM_INDEX;
+	  else if (strcasecmp($1, "learned") == 0) $$ = SqlEngine::LEARNED_INDEX;
+	  else $$ = -1;
+	  free($1);
+	  if ($$ < 0) { sqlerror("wrong index type. expected VALUE INDEX, HASH INDEX, LSM INDEX or LEARNED INDEX"); YYERROR; }
+	}
+	;
+
+index_command:
+	ID INDEX table LF {
+	  if (strcasecmp($1, "rebuild") == 0) SqlEngine::rebuildIndex(std::string($3), SqlEngine::INDEX_FILL_FACTOR);
+	  else sqlerror("wrong command. expected REBUILD INDEX");
+	  free($1);
+	  free($3);
+	}
+	| ID INDEX table WITH ID INTEGER LF {
+	  if (strcasecmp($1, "rebuild") != 0) sqlerror("wrong command. expected REBUILD INDEX");
+	  else if (strcasecmp($5, "fillfactor") != 0) sqlerror("wrong rebuild option. expected FILLFACTOR");
+	  else SqlEngine::rebuildIndex(std::string($3), atoi($6));
+	  free($1);
+	  free($3);
+	  free($5);
+	  free($6);
+	}
+	| ID INDEX ID table LF {
+	  if (strcasecmp($1, "create") == 0 && strcasecmp($3, "on") == 0) SqlEngine::createIndex(std::string($4), SqlEngine::SORT_MEMORY_BUDGET);
+	  else sqlerror("wrong command. expected CREATE INDEX ON");
+	  free($1);
+	  free($3);
+	  free($4);
+	}
+	| ID INDEX ID table WITH ID INTEGER LF {
+	  if (strcasecmp($1, "create") != 0 || strcasecmp($3, "on") != 0) sqlerror("wrong command. expected CREATE INDEX ON");
+	  else if (strcasecmp($6, "memory") != 0) sqlerror("wrong index option. expected MEMORY (in KB)");
+	  else SqlEngine::createIndex(std::string($4), atol($7) << 10);
+	  free($1);
+	  free($3);
 	  free($4);
+	  free($6);
+	  free($7);
+	}
+	;
+
+analyze_command:
+	ID table LF {
+	  if (strcasecmp($1, "analyze") == 0) SqlEngine::analyze(std::string($2));
+	  else sqlerror("wrong command. expected ANALYZE");
+	  free($1);
+	  free($2);
 	}
 	;
 
 select_command:
-	SELECT attributes FROM table LF {
+	explain_option SELECT attributes FROM table limit_option LF {
    	        std::vector<SelCond> conds;
-		runSelect($2, $4, conds);
-		free($4);
-	}
-	| SELECT attributes FROM table WHERE conditions LF {
-	        runSelect($2, $4, *$6);
-	  	free($4);
-	  	for (unsigned i = 0; i < $6->size(); i++) {
-		    free((*$6)[i].value);
+		runSelect($3, $5, conds, $6, $1);
+		free($5);
+	}
+	| explain_option SELECT attributes FROM table WHERE conditions limit_option LF {
+	        runSelect($3, $5, *$7, $8, $1);
+	  	free($5);
+	  	for (unsigned i = 0; i < $7->size(); i++) {
+		    free((*$7)[i].value);
+		    for (unsigned j = 0; j < (*$7)[i].values.size(); j++) free((*$7)[i].values[j]);
 		}
-	  	delete $6;
+	  	delete $7;
 	}
 	;
 
+limit_option:
+	ID INTEGER {
+	  bool limit = (strcasecmp($1, "limit") == 0);
+	  $$ = atoi($2);
+	  free($1);
+	  free($2);
+	  if (!limit) { sqlerror("wrong select option. expected LIMIT"); YYERROR; }
+	}
+	| { $$ = -1; }
+	;
+
+explain_option:
+	ID {
+	  $$ = (strcasecmp($1, "explain") == 0);
+	  free($1);
+	  if (!$$) { sqlerror("wrong command. expected EXPLAIN SELECT"); YYERROR; }
+	}
+	| { $$ = 0; }
+	;
+
 conditions:
 	condition {
 	  std::vector<SelCond>* v = new std::vector<SelCond>;
@@ -116,12 +215,61 @@ condition:
 	  c->value = $3;
 	  $$ = c;
         }
+	| attribute ID value { 
+	  if (strcasecmp($2, "like") != 0) {
+	    sqlerror("wrong comparator. neither an operator or LIKE");
+	    free($2);
+	    free($3);
+	    YYERROR;
+	  }
+	  SelCond* c = new SelCond;
+	  c->attr = $1;
+	  c->comp = SelCond::LIKE;
+	  c->value = $3;
+	  free($2);
+	  $$ = c;
+        }
+	| attribute ID '(' value_list ')' { 
+	  if (strcasecmp($2, "in") != 0) {
+	    sqlerror("wrong comparator. expected IN");
+	    free($2);
+	    for (unsigned i = 0; i < $4->size(); i++) free((*$4)[i]);
+	    delete $4;
+	    YYERROR;
+	  }
+	  SelCond* c = new SelCond;
+	  c->attr = $1;
+	  c->comp = SelCond::IN;
+	  c->value = NULL;
+	  c->values = *$4;
+	  free($2);
+	  delete $4;
+	  $$ = c;
+        }
+	;
+
+value_list:
+	value { 
+	  $$ = new std::vector<char*>;
+	  $$->push_back($1);
+	}
+	| value_list COMMA value {
+	  $1->push_back($3);
+	  $$ = $1;
+	}
 	;
 
 attributes:
 	attribute { $$ = $1; }
 	| STAR  { $$ = 3; }
 	| COUNT { $$ = 4; }
+	| ID '(' ID ')' {
+	  if (strcasecmp($1, "max") == 0 && strcasecmp($3, "key") == 0) $$ = 5;
+	  else $$ = -1;
+	  free($1);
+	  free($3);
+	  if ($$ < 0) { sqlerror("wrong aggregate. expected MAX(key)"); YYERROR; }
+	}
 	;
 
 attribute:
@@ -0,0 +1,322 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/19/2026
+ */
+
+#include "TableStats.h"
+#include "SqlEngine.h"
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+#include <algorithm>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+const double TableStats::RANGE_SELECTIVITY = 1.0/3;
+const double TableStats::LIKE_SELECTIVITY = 0.05;
+
+/*
+ * The statistics of a file and the version of the file they were read from.
+ */
+struct TableStats::StatsCache {
+	bool        valid;
+	struct stat fileStat;
+	TableStats  stats;
+	StatsCache() : valid(false) {}
+};
+
+map<string, TableStats::StatsCache> TableStats::caches;
+
+/*
+ * Append the bytes of a field to buf.
+ */
+template <class T>
+static void put(vector<char>& buf, const T& field)
+{
+	buf.insert(buf.end(), (const char*) &field, (const char*) &field + sizeof(T));
+}
+
+/*
+ * Take the next field from buf at pos.
+ * @return false if buf ends before it
+ */
+template <class T>
+static bool get(const vector<char>& buf, unsigned& pos, T& field)
+{
+	if(pos + sizeof(T) > buf.size()) return false;
+	memcpy(&field, &buf[pos], sizeof(T));
+	pos += sizeof(T);
+	return true;
+}
+
+/*
+ * The # of distinct items in a population of total items, from a sample of
+ * n of them with d distinct items, f1 of which were seen once (Duj1).
+ */
+static double estimateDistinct(double total, double n, double d, double f1)
+{
+	if(n >= total || n==0) return d;
+	return min(total, n*d/(n - f1 + f1*n/total));
+}
+
+TableStats::TableStats()
+{
+	rows = pages = sampleRows = 0;
+	keyOrder = 1;
+	keyDistinct = valueDistinct = 0;
+}
+
+RC TableStats::read(const string& table)
+{
+	RC error;
+	PageFile pf;
+	int length;
+
+	// the cached statistics are still good if the file did not change
+	StatsCache& cache = caches[table];
+	struct stat statbuf;
+	if(::stat((table + ".stat").c_str(), &statbuf)!=0) return RC_FILE_OPEN_FAILED;
+	if(cache.valid && PageFile::sameFileVersion(cache.fileStat, statbuf))
+	{
+		*this = cache.stats;
+		return 0;
+	}
+
+	if((error = pf.open(table + ".stat", 'r'))!=0) return error;
+	vector<char> buf(PageFile::PAGE_SIZE);
+	if((error = pf.read(0, &buf[0]))==0)
+	{
+		memcpy(&length, &buf[0], sizeof(int));
+		int pageCount = (length + PageFile::PAGE_SIZE - 1)/PageFile::PAGE_SIZE;
+		if(length < (int) sizeof(int) || pageCount > pf.endPid()) error = RC_INVALID_FILE_FORMAT;
+		else buf.resize(pageCount*PageFile::PAGE_SIZE);
+		for(int pid=1; error==0 && pid<pageCount; pid++)
+			error = pf.read(pid, &buf[pid*PageFile::PAGE_SIZE]);
+	}
+	pf.close();
+	if(error!=0) return error;
+	buf.resize(length);
+
+	unsigned pos = sizeof(int);
+	int n;
+	bool ok = get(buf, pos, rows) && get(buf, pos, pages) && get(buf, pos, sampleRows) &&
+	          get(buf, pos, keyOrder) && get(buf, pos, keyDistinct) && get(buf, pos, n) && n >= 0;
+	bounds.assign(ok ? n : 0, 0);
+	for(int i=0; ok && i<n; i++) ok = get(buf, pos, bounds[i]);
+	ok = ok && get(buf, pos, valueDistinct) && get(buf, pos, n) && n >= 0;
+	commonValues.assign(ok ? n : 0, pair<double, string>(0, ""));
+	for(int i=0, size; ok && i<n; i++)
+	{
+		ok = get(buf, pos, commonValues[i].first) && get(buf, pos, size) &&
+		     size >= 0 && pos + size <= buf.size();
+		if(ok) commonValues[i].second.assign(&buf[pos], size);
+		pos += ok ? size : 0;
+	}
+	if(!ok || pos!=buf.size()) return RC_INVALID_FILE_FORMAT;
+
+	cache.valid = true;
+	cache.fileStat = statbuf;
+	cache.stats = *this;
+	return 0;
+}
+
+RC TableStats::write(const string& table)
+{
+	RC error;
+	PageFile pf;
+	vector<char> buf;
+
+	put(buf, (int) 0); // the # of bytes, filled in below
+	put(buf, rows);
+	put(buf, pages);
+	put(buf, sampleRows);
+	put(buf, keyOrder);
+	put(buf, keyDistinct);
+	put(buf, (int) bounds.size());
+	for(unsigned i=0; i<bounds.size(); i++) put(buf, bounds[i]);
+	put(buf, valueDistinct);
+	put(buf, (int) commonValues.size());
+	for(unsigned i=0; i<commonValues.size(); i++)
+	{
+		put(buf, commonValues[i].first);
+		put(buf, (int) commonValues[i].second.size());
+		buf.insert(buf.end(), commonValues[i].second.begin(), commonValues[i].second.end());
+	}
+	int length = buf.size();
+	memcpy(&buf[0], &length, sizeof(int));
+	buf.resize((length + PageFile::PAGE_SIZE - 1)/PageFile::PAGE_SIZE*PageFile::PAGE_SIZE, 0);
+
+	// the old file may have more pages than the new statistics
+	caches[table].valid = false;
+	::unlink((table + ".stat").c_str());
+	if((error = pf.open(table + ".stat", 'w'))!=0) return error;
+	for(PageId pid=0; error==0 && pid*PageFile::PAGE_SIZE < (int) buf.size(); pid++)
+		error = pf.write(pid, &buf[pid*PageFile::PAGE_SIZE]);
+	pf.close();
+	return error;
+}
+
+RC TableStats::collect(const RecordFile& rf)
+{
+	RC error;
+	RecordId rid;
+	int key, lastKey = 0;
+	string value;
+
+	const RecordId& endRid = rf.endRid();
+	rows = endRid.pid*RecordFile::RECORDS_PER_PAGE + endRid.sid;
+	sampleRows = 0;
+	pages = endRid.pid + (endRid.sid > 0 ? 1 : 0);
+
+	// pick SAMPLE_PAGES of the pages, each with the same chance, in order
+	// (selection sampling); the same table always gives the same sample
+	vector<int> keys;
+	map<string, int> values;
+	int ordered = 0, pairs = 0, sampled = 0;
+	unsigned long long seed = 88172645463325252ULL ^ pages;
+	for(rid.pid = 0; rid.pid < pages; rid.pid++)
+	{
+		if(pages > SAMPLE_PAGES)
+		{
+			// the page is picked with chance (pages still wanted)/(pages left)
+			seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17; // xorshift64
+			if((double) (seed % 1000003)/1000003*(pages - rid.pid) >= SAMPLE_PAGES - sampled) continue;
+		}
+		sampled++;
+
+		int slots = (rid.pid==endRid.pid) ? endRid.sid : RecordFile::RECORDS_PER_PAGE;
+		for(rid.sid = 0; rid.sid < slots; rid.sid++)
+		{
+			if((error = rf.read(rid, key, value))!=0) return error;
+			// the order of the rows is seen within the pages read
+			if(rid.sid > 0)
+			{
+				pairs++;
+				if(key >= lastKey) ordered++;
+			}
+			lastKey = key;
+			keys.push_back(key);
+			values[value]++;
+		}
+		sampleRows += slots;
+	}
+	keyOrder = pairs > 0 ? max(0.0, 2.0*ordered/pairs - 1) : 1;
+
+	// the bounds of the histogram are the keys at every 1/HISTOGRAM_BUCKETS
+	// of the sorted keys
+	sort(keys.begin(), keys.end());
+	bounds.clear();
+	for(int i=0; !keys.empty() && i<=HISTOGRAM_BUCKETS; i++)
+		bounds.push_back(keys[(long long) (keys.size()-1)*i/HISTOGRAM_BUCKETS]);
+
+	int distinct = 0, once = 0;
+	for(unsigned i=0, j; i<keys.size(); i=j)
+	{
+		for(j=i+1; j<keys.size() && keys[j]==keys[i]; j++);
+		distinct++;
+		if(j==i+1) once++;
+	}
+	keyDistinct = estimateDistinct(rows, sampleRows, distinct, once);
+
+	// the values seen more than once, most common first
+	distinct = values.size();
+	once = 0;
+	vector<pair<int, string> > counts;
+	for(map<string, int>::const_iterator it = values.begin(); it != values.end(); it++)
+	{
+		if(it->second==1) once++;
+		else counts.push_back(make_pair(-it->second, it->first));
+	}
+	valueDistinct = estimateDistinct(rows, sampleRows, distinct, once);
+	sort(counts.begin(), counts.end());
+	commonValues.clear();
+	for(unsigned i=0; i<counts.size() && i<(unsigned) COMMON_VALUES; i++)
+		commonValues.push_back(make_pair((double) -counts[i].first/sampleRows, counts[i].second));
+	return 0;
+}
+
+double TableStats::estimateRows(long long lo, long long hi) const
+{
+	if(bounds.empty() || lo > hi) return 0;
+	lo = max(lo, (long long) bounds.front());
+	hi = min(hi, (long long) bounds.back());
+	if(lo > hi) return 0;
+
+	// every bucket [bounds[i], bounds[i+1]) holds the same # of rows, spread
+	// evenly over its keys; the last one includes its upper bound, and a
+	// bucket between two equal bounds holds just that key
+	int buckets = bounds.size() - 1;
+	double perBucket = (double) rows/max(1, buckets);
+	double estimate = 0;
+	for(int i=0; i<buckets; i++)
+	{
+		double from = bounds[i], to = bounds[i+1] + (i==buckets-1 ? 1 : 0);
+		if(to <= from) to = from + 1;
+		double overlap = min(to, (double) hi + 1) - max(from, (double) lo);
+		if(overlap > 0) estimate += perBucket*overlap/(to - from);
+	}
+	if(buckets==0) estimate = rows;
+
+	// a single key that fills no bucket by itself has the average # of rows
+	if(lo==hi && keyDistinct > 0) estimate = max(estimate, rows/keyDistinct);
+	return min(estimate, (double) rows);
+}
+
+double TableStats::valueFrequency(const char* value) const
+{
+	double common = 0;
+	for(unsigned i=0; i<commonValues.size(); i++)
+	{
+		if(commonValues[i].second==value) return commonValues[i].first;
+		common += commonValues[i].first;
+	}
+	// the other values share the rest of the rows evenly
+	return max(0.0, 1 - common)/max(1.0, valueDistinct - commonValues.size());
+}
+
+double TableStats::selectivity(const SelCond& c) const
+{
+	if(rows==0) return 0;
+
+	double s = 0;
+	bool wildcard = (c.value!=NULL && strcspn(c.value, "%_")!=strlen(c.value));
+	if(c.attr==1)
+	{
+		long long v = c.value ? atoi(c.value) : 0;
+		switch(c.comp)
+		{
+			case SelCond::EQ: s = estimateRows(v, v)/rows; break;
+			case SelCond::NE: s = 1 - estimateRows(v, v)/rows; break;
+			case SelCond::LT: s = estimateRows(INT_MIN, v-1)/rows; break;
+			case SelCond::LE: s = estimateRows(INT_MIN, v)/rows; break;
+			case SelCond::GT: s = estimateRows(v+1, INT_MAX)/rows; break;
+			case SelCond::GE: s = estimateRows(v, INT_MAX)/rows; break;
+			case SelCond::LIKE: s = wildcard ? LIKE_SELECTIVITY : estimateRows(v, v)/rows; break;
+			case SelCond::IN:
+				for(unsigned i=0; i<c.values.size(); i++)
+				{
+					v = atoi(c.values[i]);
+					s += estimateRows(v, v)/rows;
+				}
+				break;
+		}
+	}
+	else
+	{
+		switch(c.comp)
+		{
+			case SelCond::EQ: s = valueFrequency(c.value); break;
+			case SelCond::NE: s = 1 - valueFrequency(c.value); break;
+			case SelCond::LIKE: s = wildcard ? LIKE_SELECTIVITY : valueFrequency(c.value); break;
+			case SelCond::IN:
+				for(unsigned i=0; i<c.values.size(); i++) s += valueFrequency(c.values[i]);
+				break;
+			default: s = RANGE_SELECTIVITY; break;
+		}
+	}
+	return max(0.0, min(1.0, s));
+}
@@ -0,0 +1,123 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/19/2026
+ */
+
+#ifndef TABLESTATS_H
+#define TABLESTATS_H
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Bruinbase.h"
+#include "PageFile.h"
+#include "RecordFile.h"
+
+struct SelCond;
+
+/**
+ * Statistics of a table, kept in <table>.stat and collected by ANALYZE
+ * and at the end of every LOAD:
+ *   - the # of rows and pages
+ *   - an equi-depth histogram of the keys: HISTOGRAM_BUCKETS+1 bounds with
+ *     about the same # of rows between every two of them, so that dense and
+ *     sparse key ranges are estimated equally well, and a key that fills
+ *     whole buckets by itself is seen as such
+ *   - the # of distinct keys and of distinct values
+ *   - the most common values and how often they occur
+ *   - how close the order of the rows is to key order
+ * A table of up to SAMPLE_PAGES pages is read in full. Of a bigger one,
+ * SAMPLE_PAGES pages picked at random are read, and the distinct counts
+ * are estimated from the sample (Haas and Stokes' Duj1 estimator).
+ * The planner uses them to estimate how many rows a condition matches
+ * without reading the table or its indexes. The statistics read are kept
+ * for the process, until the file changes.
+ *
+ * File layout: the fields below, in order, over as many pages as needed:
+ *   |# bytes|# rows|# pages|# sampled rows|key order|# distinct keys|
+ *   |# bounds|bounds...|# distinct values|# common values|(frequency, value)...|
+ */
+class TableStats {
+ public:
+  static const int HISTOGRAM_BUCKETS = 64;
+  static const int COMMON_VALUES = 10;   // most common values kept
+  static const int SAMPLE_PAGES = 1000;  // table pages read at most
+
+  // fractions of rows assumed to meet the conditions on value that the
+  // statistics do not describe
+  static const double RANGE_SELECTIVITY; // <, >, <=, >=
+  static const double LIKE_SELECTIVITY;  // LIKE with a wildcard
+
+  TableStats();
+
+  /**
+   * Read the statistics of table.
+   * @param table[IN] the name of the table
+   * @return error code. 0 if no error, an error code if table has none
+   */
+  RC read(const std::string& table);
+
+  /**
+   * Write the statistics of table, replacing the old ones.
+   * @param table[IN] the name of the table
+   * @return error code. 0 if no error
+   */
+  RC write(const std::string& table);
+
+  /**
+   * Collect the statistics of a table from its rows, or a sample of its
+   * pages if it has more than SAMPLE_PAGES of them.
+   * @param rf[IN] the open table file
+   * @return error code. 0 if no error
+   */
+  RC collect(const RecordFile& rf);
+
+  /**
+   * @return the estimated # of rows with lo <= key <= hi
+   */
+  double estimateRows(long long lo, long long hi) const;
+
+  /**
+   * @return the estimated fraction of the rows that meet c
+   */
+  double selectivity(const SelCond& c) const;
+
+  /**
+   * @return how close the order of the rows is to key order: 1 if the
+   *         table was loaded in key order, 0 if in random order (where half
+   *         of the rows follow a smaller key) or worse
+   */
+  double getKeyOrder() const { return keyOrder; }
+
+  int getRowCount() const { return rows; }
+  int getPageCount() const { return pages; }
+  int getSampleRowCount() const { return sampleRows; }
+  int getBucketCount() const { return bounds.empty() ? 0 : bounds.size() - 1; }
+  int getCommonValueCount() const { return commonValues.size(); }
+  double getKeyDistinct() const { return keyDistinct; }
+  double getValueDistinct() const { return valueDistinct; }
+
+ private:
+  /**
+   * @return the estimated fraction of the rows whose value is value
+   */
+  double valueFrequency(const char* value) const;
+
+  struct StatsCache; // the statistics of a file, see TableStats.cc
+  static std::map<std::string, StatsCache> caches;
+
+  int    rows;          /// # rows in the table
+  int    pages;         /// # pages of the table
+  int    sampleRows;    /// # rows the statistics were collected from
+  double keyOrder;      /// see getKeyOrder()
+  double keyDistinct;   /// # distinct keys
+  double valueDistinct; /// # distinct values
+  std::vector<int> bounds; /// the bounds of the equi-depth key histogram
+  std::vector<std::pair<double, std::string> > commonValues; /// (frequency, value), most common first
+};
+
+#endif /* TABLESTATS_H */
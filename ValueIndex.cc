@@ -0,0 +1,317 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/18/2026
+ */
+
+#include "ValueIndex.h"
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+
+/*
+ * Node format (all ints are 4 bytes):
+ * |count|next or first child|prefix length|prefix|entry|entry|...
+ * leaf entry:    |suffix length (1 byte)|suffix|RecordId|
+ * nonleaf entry: |suffix length (1 byte)|suffix|child PageId|
+ */
+static const int NODE_HEADER_SIZE = 3*sizeof(int);
+
+void ValueNode::decode(const char* page, bool leaf)
+{
+	int count, prefixLength;
+	PageId first;
+	memcpy(&count, page, sizeof(int));
+	memcpy(&first, page+sizeof(int), sizeof(PageId));
+	memcpy(&prefixLength, page+2*sizeof(int), sizeof(int));
+
+	keys.clear(); rids.clear(); children.clear();
+	next = 0;
+	if(leaf) next = first;
+	else children.push_back(first);
+
+	string prefix(page+NODE_HEADER_SIZE, prefixLength);
+	const char* temp = page + NODE_HEADER_SIZE + prefixLength;
+	for(int i=0; i<count; i++)
+	{
+		int suffixLength = (unsigned char)*temp++;
+		keys.push_back(prefix + string(temp, suffixLength));
+		temp += suffixLength;
+		if(leaf)
+		{
+			RecordId rid;
+			memcpy(&rid, temp, sizeof(RecordId));
+			rids.push_back(rid);
+			temp += sizeof(RecordId);
+		}
+		else
+		{
+			PageId pid;
+			memcpy(&pid, temp, sizeof(PageId));
+			children.push_back(pid);
+			temp += sizeof(PageId);
+		}
+	}
+}
+
+RC ValueNode::encode(char* page, bool leaf) const
+{
+	int count = keys.size();
+	int entrySize = leaf ? sizeof(RecordId) : sizeof(PageId);
+
+	// the common prefix of a sorted key list is the common prefix of its first and last key
+	int prefixLength = 0;
+	if(count > 0)
+	{
+		const string& a = keys.front();
+		const string& b = keys.back();
+		while(prefixLength < (int)a.size() && prefixLength < (int)b.size() && a[prefixLength]==b[prefixLength])
+			prefixLength++;
+	}
+
+	int size = NODE_HEADER_SIZE + prefixLength;
+	for(int i=0; i<count; i++) size += 1 + keys[i].size() - prefixLength + entrySize;
+	if(size > PageFile::PAGE_SIZE) return RC_NODE_FULL;
+
+	memset(page, 0, PageFile::PAGE_SIZE);
+	PageId first = leaf ? next : children[0];
+	memcpy(page, &count, sizeof(int));
+	memcpy(page+sizeof(int), &first, sizeof(PageId));
+	memcpy(page+2*sizeof(int), &prefixLength, sizeof(int));
+	if(count > 0) memcpy(page+NODE_HEADER_SIZE, keys[0].data(), prefixLength);
+
+	char* temp = page + NODE_HEADER_SIZE + prefixLength;
+	for(int i=0; i<count; i++)
+	{
+		int suffixLength = keys[i].size() - prefixLength;
+		*temp++ = (char)suffixLength;
+		memcpy(temp, keys[i].data()+prefixLength, suffixLength);
+		temp += suffixLength;
+		if(leaf) memcpy(temp, &rids[i], sizeof(RecordId));
+		else memcpy(temp, &children[i+1], sizeof(PageId));
+		temp += entrySize;
+	}
+	return 0;
+}
+
+/*
+ * Return the number of separator keys smaller than value, i.e. the child to
+ * follow so that the left-most occurrence of value is reached.
+ */
+static int childIndex(const ValueNode& node, const string& value)
+{
+	return lower_bound(node.keys.begin(), node.keys.end(), value) - node.keys.begin();
+}
+
+/*
+ * Return the shortest key s with left < s <= right (suffix truncation),
+ * which is all the parent needs to separate the two nodes.
+ */
+static string shortestSeparator(const string& left, const string& right)
+{
+	if(left >= right) return right;
+	unsigned i = 0;
+	while(i < left.size() && left[i]==right[i]) i++;
+	return right.substr(0, i+1);
+}
+
+ValueIndex::ValueIndex()
+{
+	rootPid = -1;
+	treeHeight = 0;
+}
+
+RC ValueIndex::open(const string& indexname, char mode)
+{
+	RC error;
+	char buffer[PageFile::PAGE_SIZE];
+
+	if((error = pf.open(indexname, mode))!=0) return error;
+
+	rootPid = -1;
+	treeHeight = 0;
+	if(pf.endPid()==0) return 0; // new index
+
+	if((error = pf.read(0, buffer))!=0) return error;
+	memcpy(&rootPid, buffer, sizeof(PageId));
+	memcpy(&treeHeight, buffer+sizeof(PageId), sizeof(int));
+	return 0;
+}
+
+RC ValueIndex::close()
+{
+	RC error;
+	char buffer[PageFile::PAGE_SIZE];
+
+	// store rootPid and treeHeight in page 0, as BTreeIndex does
+	memset(buffer, 0, PageFile::PAGE_SIZE);
+	memcpy(buffer, &rootPid, sizeof(PageId));
+	memcpy(buffer+sizeof(PageId), &treeHeight, sizeof(int));
+	if((error = pf.write(0, buffer))!=0) return error;
+
+	return pf.close();
+}
+
+RC ValueIndex::readNode(PageId pid, bool leaf, ValueNode& node)
+{
+	RC error;
+	char buffer[PageFile::PAGE_SIZE];
+	if((error = pf.read(pid, buffer))!=0) return error;
+	node.decode(buffer, leaf);
+	return 0;
+}
+
+RC ValueIndex::writeNode(PageId pid, bool leaf, const ValueNode& node)
+{
+	RC error;
+	char buffer[PageFile::PAGE_SIZE];
+	if((error = node.encode(buffer, leaf))!=0) return error;
+	return pf.write(pid, buffer);
+}
+
+RC ValueIndex::insert(const string& value, const RecordId& rid)
+{
+	RC error;
+	string key = value.substr(0, RecordFile::MAX_VALUE_LENGTH-1); // as stored in the table
+
+	if(treeHeight==0)
+	{
+		ValueNode root;
+		root.next = 0;
+		root.keys.push_back(key);
+		root.rids.push_back(rid);
+		rootPid = (pf.endPid()==0) ? 1 : pf.endPid();
+		treeHeight = 1;
+		return writeNode(rootPid, true, root);
+	}
+
+	string sepKey;
+	PageId insertPid = -1;
+	if((error = helper_insert(key, rid, rootPid, 1, sepKey, insertPid))!=0) return error;
+
+	// the root was split: grow the tree by one level
+	if(insertPid!=-1)
+	{
+		ValueNode root;
+		root.keys.push_back(sepKey);
+		root.children.push_back(rootPid);
+		root.children.push_back(insertPid);
+		rootPid = pf.endPid();
+		treeHeight++;
+		return writeNode(rootPid, false, root);
+	}
+	return 0;
+}
+
+RC ValueIndex::helper_insert(const string& value, const RecordId& rid, PageId pid, int height,
+                             string& sepKey, PageId& insertPid)
+{
+	RC error;
+	ValueNode node;
+	bool leaf = (height==treeHeight);
+	insertPid = -1;
+
+	if((error = readNode(pid, leaf, node))!=0) return error;
+
+	if(leaf)
+	{
+		// duplicates go behind the existing entries with the same value
+		int pos = upper_bound(node.keys.begin(), node.keys.end(), value) - node.keys.begin();
+		node.keys.insert(node.keys.begin()+pos, value);
+		node.rids.insert(node.rids.begin()+pos, rid);
+	}
+	else
+	{
+		int j = childIndex(node, value);
+		string childKey;
+		PageId childPid = -1;
+		if((error = helper_insert(value, rid, node.children[j], height+1, childKey, childPid))!=0) return error;
+		if(childPid==-1) return 0;
+
+		node.keys.insert(node.keys.begin()+j, childKey);
+		node.children.insert(node.children.begin()+j+1, childPid);
+	}
+
+	char buffer[PageFile::PAGE_SIZE];
+	if(node.encode(buffer, leaf)==0) return pf.write(pid, buffer);
+
+	// the node does not fit in a page anymore: split it half and half
+	ValueNode sibling;
+	int half = node.keys.size()/2;
+	insertPid = pf.endPid();
+
+	if(leaf)
+	{
+		sibling.keys.assign(node.keys.begin()+half, node.keys.end());
+		sibling.rids.assign(node.rids.begin()+half, node.rids.end());
+		node.keys.resize(half);
+		node.rids.resize(half);
+		sibling.next = node.next;
+		node.next = insertPid;
+		sepKey = shortestSeparator(node.keys.back(), sibling.keys.front());
+	}
+	else
+	{
+		// the middle key moves up to the parent
+		sepKey = node.keys[half];
+		sibling.keys.assign(node.keys.begin()+half+1, node.keys.end());
+		sibling.children.assign(node.children.begin()+half+1, node.children.end());
+		node.keys.resize(half);
+		node.children.resize(half+1);
+	}
+
+	if((error = writeNode(insertPid, leaf, sibling))!=0) return error;
+	return writeNode(pid, leaf, node);
+}
+
+RC ValueIndex::locate(const string& searchValue, IndexCursor& cursor)
+{
+	RC error;
+	ValueNode node;
+
+	if(treeHeight<=0) return RC_NO_SUCH_RECORD;
+
+	PageId pid = rootPid;
+	for(int height = 1; height < treeHeight; height++)
+	{
+		if((error = readNode(pid, false, node))!=0) return error;
+		pid = node.children[childIndex(node, searchValue)];
+	}
+
+	if((error = readNode(pid, true, node))!=0) return error;
+	cursor.pid = pid;
+	cursor.eid = lower_bound(node.keys.begin(), node.keys.end(), searchValue) - node.keys.begin();
+	// eid may be past the last entry; readForward() then continues in the next leaf
+
+	if(cursor.eid < (int)node.keys.size() && node.keys[cursor.eid]==searchValue) return 0;
+	return RC_NO_SUCH_RECORD;
+}
+
+RC ValueIndex::readForward(IndexCursor& cursor, string& value, RecordId& rid)
+{
+	RC error;
+	ValueNode node;
+
+	while(true)
+	{
+		// page 0 holds rootPid and treeHeight, so pid 0 marks the end of the chain
+		if(cursor.pid <= 0) return RC_END_OF_TREE;
+		if((error = readNode(cursor.pid, true, node))!=0) return error;
+
+		if(cursor.eid < (int)node.keys.size()) break;
+		cursor.pid = node.next;
+		cursor.eid = 0;
+	}
+
+	value = node.keys[cursor.eid];
+	rid = node.rids[cursor.eid];
+
+	if(++cursor.eid >= (int)node.keys.size())
+	{
+		cursor.pid = node.next;
+		cursor.eid = 0;
+	}
+	return 0;
+}
@@ -0,0 +1,125 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/18/2026
+ */
+
+#ifndef VALUEINDEX_H
+#define VALUEINDEX_H
+
+#include <string>
+#include <vector>
+#include "Bruinbase.h"
+#include "PageFile.h"
+#include "RecordFile.h"
+#include "BTreeIndex.h"
+
+/**
+ * ValueNode: a node of the value index, decoded into memory.
+ * On disk, a node is stored as
+ *   |count|next (leaf) or first child (nonleaf)|prefix length|prefix|entries...|
+ * where prefix is the longest common prefix of all keys in the node and
+ * every entry holds |suffix length (1 byte)|key suffix|RecordId or child PageId|.
+ * Only the suffixes are stored, so long shared prefixes (e.g. "Star Wars: ...")
+ * take space once per node.
+ */
+struct ValueNode {
+  std::vector<std::string> keys;     // the keys (values of the table) in sorted order
+  std::vector<RecordId>    rids;     // leaf: the RecordId of each key
+  std::vector<PageId>      children; // nonleaf: keys.size()+1 child pointers
+  PageId                   next;     // leaf: PageId of the next leaf (0 if none)
+
+  /**
+   * Decode the node from a page buffer.
+   * @param page[IN] the page content
+   * @param leaf[IN] true if the page holds a leaf node
+   */
+  void decode(const char* page, bool leaf);
+
+  /**
+   * Encode the node into a page buffer.
+   * @param page[OUT] the page content
+   * @param leaf[IN] true if the node is a leaf node
+   * @return 0 if successful, RC_NODE_FULL if the node does not fit in a page
+   */
+  RC encode(char* page, bool leaf) const;
+};
+
+/**
+ * Implements a B+tree index over the value column of a table.
+ * Keys are variable-length strings (prefix-compressed inside each node)
+ * mapped to the RecordId of the record. Duplicate values are allowed;
+ * locate() always finds the left-most entry of a value.
+ */
+class ValueIndex {
+ public:
+  ValueIndex();
+
+  /**
+   * Open the index file in read or write mode.
+   * Under 'w' mode, the index file should be created if it does not exist.
+   * @param indexname[IN] the name of the index file
+   * @param mode[IN] 'r' for read, 'w' for write
+   * @return error code. 0 if no error
+   */
+  RC open(const std::string& indexname, char mode);
+
+  /**
+   * Close the index file.
+   * @return error code. 0 if no error
+   */
+  RC close();
+
+  /**
+   * Insert (value, RecordId) pair to the index.
+   * @param value[IN] the value of the record
+   * @param rid[IN] the RecordId for the record being inserted into the index
+   * @return error code. 0 if no error
+   */
+  RC insert(const std::string& value, const RecordId& rid);
+
+  /**
+   * Set the cursor to the first index entry whose value is greater than
+   * or equal to searchValue.
+   * @param searchValue[IN] the value to find
+   * @param cursor[OUT] the cursor pointing to the first entry >= searchValue
+   * @return 0 if an entry equal to searchValue exists. Otherwise RC_NO_SUCH_RECORD
+   */
+  RC locate(const std::string& searchValue, IndexCursor& cursor);
+
+  /**
+   * Read the (value, rid) pair at the location specified by the index cursor,
+   * and move foward the cursor to the next entry.
+   * @param cursor[IN/OUT] the cursor pointing to an leaf-node index entry
+   * @param value[OUT] the value stored at the index cursor location
+   * @param rid[OUT] the RecordId stored at the index cursor location
+   * @return error code. 0 if no error, RC_END_OF_TREE after the last entry
+   */
+  RC readForward(IndexCursor& cursor, std::string& value, RecordId& rid);
+
+  /**
+   * @return the size of the index file in pages
+   */
+  int getPageCount() const { return pf.endPid(); }
+
+ private:
+  /**
+   * Recursive function for insertion. If the node at pid had to be split,
+   * the separator key and the PageId of the new sibling are returned.
+   */
+  RC helper_insert(const std::string& value, const RecordId& rid, PageId pid, int height,
+                   std::string& sepKey, PageId& insertPid);
+
+  /**
+   * Read and decode the node at pid, or encode and write it.
+   */
+  RC readNode(PageId pid, bool leaf, ValueNode& node);
+  RC writeNode(PageId pid, bool leaf, const ValueNode& node);
+
+  PageFile pf;         /// the PageFile used to store the b+tree on disk
+  PageId   rootPid;    /// the PageId of the root node
+  int      treeHeight; /// the height of the tree (1: the root is a leaf)
+};
+
+#endif /* VALUEINDEX_H */
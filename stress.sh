@@ -0,0 +1,87 @@
+#!/bin/sh
+#
+# Mixed read/insert stress test for the B+tree index.
+# A LOAD keeps inserting into stress.idx while N reader processes run range
+# SELECTs on the same index. For each N, prints the SELECT throughput and
+# the number of SELECTs that went wrong while leaves were being split:
+# keys out of order (or, for distinct keys, an entry seen twice), fewer
+# keys than the rows loaded before the readers started, or more than all
+# rows loaded by the end. It should be 0.
+# It runs twice: on distinct keys, and on 100 keys with ~1000 duplicates each,
+# whose splits leave runs of one key across several leaves that locate()
+# must move right through.
+#
+# usage: ./stress.sh [rows] [queries per reader]
+
+ROWS=${1:-100000}
+QUERIES=${2:-100}
+
+printf "%10s %8s %10s %12s %10s\n" keys readers seconds selects/sec wrong
+
+for SET in distinct duplicate; do
+  if [ $SET = distinct ]; then MOD=1000003 WIDTH=5000 DUP=0; else MOD=100 WIDTH=3 DUP=1; fi
+
+  # distinct keys: 7919 is coprime to the prime 1000003, so (i*7919) % 1000003
+  # is a permutation; duplicate keys: the same order folded onto 100 keys.
+  # Keys start at 1 because a leaf marks its empty slots with key 0.
+  awk -v n=$ROWS -v m=$MOD 'BEGIN { for (i = 0; i < n; i++) printf "%d,\"value %d\"\n", (i*7919) % m + 1, i }' > stress.del
+  head -n $((ROWS / 2)) stress.del > stress_base.del
+  tail -n +$((ROWS / 2 + 1)) stress.del > stress_rest.del
+
+  # the rows present before the readers start and after the LOAD ends,
+  # for checking their results
+  rm -f stressref.tbl stressref.idx stressall.tbl stressall.idx
+  echo "LOAD stressref FROM 'stress_base.del' WITH INDEX" | ./bruinbase > /dev/null 2>&1
+  echo "LOAD stressall FROM 'stress.del' WITH INDEX" | ./bruinbase > /dev/null 2>&1
+
+  for READERS in 1 2 4 8; do
+    rm -f stress.tbl stress.idx
+    echo "LOAD stress FROM 'stress_base.del' WITH INDEX" | ./bruinbase > /dev/null 2>&1
+
+    i=0
+    while [ $i -lt $READERS ]; do
+      awk -v n=$QUERIES -v seed=$i -v m=$MOD -v w=$WIDTH 'BEGIN { srand(seed); for (q = 0; q < n; q++) { lo = int(rand()*m); printf "SELECT key FROM stress WHERE key > %d AND key < %d\n", lo, lo+w } }' > stress_q$i.sql
+      sed 's/SELECT key FROM stress/SELECT COUNT(*) FROM stressref/' stress_q$i.sql | ./bruinbase 2> /dev/null | tr ' ' '\n' | grep '^[0-9]' > stress_lo$i.txt
+      sed 's/SELECT key FROM stress/SELECT COUNT(*) FROM stressall/' stress_q$i.sql | ./bruinbase 2> /dev/null | tr ' ' '\n' | grep '^[0-9]' > stress_hi$i.txt
+      paste -d ' ' stress_lo$i.txt stress_hi$i.txt > stress_ref$i.txt
+      i=$((i + 1))
+    done
+
+    echo "LOAD stress FROM 'stress_rest.del' WITH INDEX" | ./bruinbase > /dev/null 2>&1 &
+    WRITER=$!
+
+    START=$(date +%s.%N)
+    PIDS=""
+    i=0
+    while [ $i -lt $READERS ]; do
+      ./bruinbase < stress_q$i.sql > stress_out$i.txt 2> /dev/null &
+      PIDS="$PIDS $!"
+      i=$((i + 1))
+    done
+    wait $PIDS
+    END=$(date +%s.%N)
+    wait $WRITER
+
+    # every SELECT output starts behind a prompt; its keys must be increasing
+    # (non-decreasing for duplicate keys) and as many as the reference
+    # counts allow
+    WRONG=0
+    i=0
+    while [ $i -lt $READERS ]; do
+      W=$(awk -v dup=$DUP '
+        FNR == NR { lo[FNR] = $1; hi[FNR] = $2; next }
+        function check() { if (q > 0 && (bad || cnt < lo[q] || cnt > hi[q])) n++ }
+        { while (sub(/^Bruinbase> /, "")) { check(); q++; prev = -1; cnt = 0; bad = 0 } }
+        /^[0-9]+$/ { if ($1 + 0 < prev || (!dup && $1 + 0 == prev)) bad = 1; prev = $1 + 0; cnt++ }
+        END { print n + 0 }' stress_ref$i.txt stress_out$i.txt)
+      WRONG=$((WRONG + W))
+      i=$((i + 1))
+    done
+
+    awk -v k=$SET -v r=$READERS -v q=$QUERIES -v s=$START -v e=$END -v u=$WRONG \
+      'BEGIN { printf "%10s %8d %10.2f %12.1f %10d\n", k, r, e-s, r*q/(e-s), u }'
+    rm -f stress_q*.sql stress_out*.txt stress_lo*.txt stress_hi*.txt stress_ref*.txt
+  done
+done
+
+rm -f stress.tbl stress.idx stressref.tbl stressref.idx stressall.tbl stressall.idx stress.del stress_base.del stress_rest.del
@@ -1,10 +1,17 @@
 #!/bin/sh
 
-rm -f xsmall.tbl xsmall.idx
-rm -f small.tbl small.idx
-rm -f medium.tbl medium.idx
-rm -f large.tbl large.idx
-rm -f xlarge.tbl xlarge.idx
+rm -f xsmall.tbl xsmall.idx xsmall.stat
+rm -f small.tbl small.idx small.stat
+rm -f medium.tbl medium.idx medium.stat
+rm -f large.tbl large.idx large.stat
+rm -f xlarge.tbl xlarge.idx xlarge.stat
+rm -f largecov.tbl largecov.idx largecov.stat
+rm -f xlargez.tbl xlargez.idx xlargez.stat
+rm -f largeval.tbl largeval.vdx largeval.stat
+rm -f xlargehash.tbl xlargehash.hdx xlargehash.stat
+rm -f xlargelsm.tbl xlargelsm.lsm xlargelsm.lsm.* xlargelsm.stat
+rm -f xlargelearned.tbl xlargelearned.ldx xlargelearned.stat
+rm -f xlargenoidx.tbl xlargenoidx.idx xlargenoidx.stat
 
 ./bruinbase < test.sql
 
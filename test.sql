@@ -20,3 +20,62 @@ SELECT COUNT(*) FROM xlarge
 SELECT * FROM xlarge WHERE key = 4240
 SELECT * FROM xlarge WHERE key > 400 AND key < 500 AND key > 100 AND key < 4000000
 
+
+LOAD largecov FROM 'large.del' WITH INDEX INCLUDE value
+SELECT * FROM large WHERE key > 4500 AND value > 'M'
+SELECT * FROM largecov WHERE key > 4500 AND value > 'M'
+
+LOAD xlargez FROM 'xlarge.del' WITH INDEX COMPRESSED
+SELECT * FROM xlarge WHERE key > 400 AND key < 500
+SELECT * FROM xlargez WHERE key > 400 AND key < 500
+
+LOAD largeval FROM 'large.del' WITH VALUE INDEX
+SELECT * FROM large WHERE value = 'Star Wars'
+SELECT * FROM largeval WHERE value = 'Star Wars'
+SELECT COUNT(*) FROM largeval WHERE value LIKE 'Star%'
+
+LOAD xlargehash FROM 'xlarge.del' WITH HASH INDEX
+SELECT * FROM xlarge WHERE key = 4240
+SELECT * FROM xlargehash WHERE key = 4240
+SELECT * FROM xlarge WHERE key = 4240
+SELECT * FROM xlargehash WHERE key = 4240
+
+SELECT * FROM xlarge WHERE key IN (4240, 17, 4241, 2, 400)
+
+LOAD xlargelsm FROM 'xlarge.del' WITH LSM INDEX
+LOAD xlargelsm FROM 'xlarge.del' WITH LSM INDEX
+SELECT COUNT(*) FROM xlargelsm WHERE key > 400 AND key < 500
+SELECT * FROM xlargelsm WHERE key = 4240
+
+LOAD xlargelearned FROM 'xlarge.del' WITH LEARNED INDEX
+SELECT COUNT(*) FROM xlargelearned WHERE key > 400 AND key < 500
+SELECT * FROM xlargelearned WHERE key = 4240
+
+REBUILD INDEX xlarge
+SELECT COUNT(*) FROM xlarge WHERE key > 400 AND key < 500
+SELECT * FROM xlarge WHERE key = 4240
+REBUILD INDEX xlargez WITH FILLFACTOR 100
+SELECT COUNT(*) FROM xlargez WHERE key > 400 AND key < 500
+
+LOAD xlargenoidx FROM 'xlarge.del'
+CREATE INDEX ON xlargenoidx WITH MEMORY 64
+SELECT COUNT(*) FROM xlargenoidx WHERE key > 400 AND key < 500
+SELECT * FROM xlargenoidx WHERE key = 4240
+
+SELECT * FROM xlarge WHERE key > 0 AND value = 'x'
+SELECT * FROM xlarge WHERE key > 400 AND key < 500 AND value = 'x'
+
+ANALYZE xlarge
+EXPLAIN SELECT * FROM xlarge WHERE key > 400 AND key < 500
+EXPLAIN SELECT COUNT(*) FROM xlarge WHERE value = 'x'
+EXPLAIN SELECT * FROM xlarge WHERE key > 500 AND key < 400
+
+SELECT * FROM xlarge WHERE key > 400 LIMIT 5
+SELECT key FROM xlarge WHERE value LIKE '%a%' LIMIT 3
+SELECT MAX(key) FROM xlarge
+SELECT MAX(key) FROM xlarge WHERE key < 4240 AND key <> 4239
+
+SELECT COUNT(*) FROM xlarge WHERE key > -1
+SELECT * FROM xlarge WHERE key >= 400 AND key <= 410 AND key <> 403 AND key <> 404
+EXPLAIN SELECT * FROM xlarge WHERE key IN (1, 2, 3) AND key > 2
+EXPLAIN SELECT * FROM xlarge WHERE value = 'a' AND value = 'b'